@@ -0,0 +1,191 @@
+/**
+ * @file
+ * @brief     Knob access counters, enabled with `KNOBCPP_PROFILE`
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * When the program is compiled with `-DKNOBCPP_PROFILE`, StaticKnob
+ * `profileKnobAccess` is true and Knob and Group count:
+ *  - reads, typed accessors of Knob: `asInt()`, `asString()`, `bind()`...;
+ *  - name lookups, `at()`, `find()`, `gr()`, `lookup()`, `findKnob()`,
+ *    with the time spent in each lookup.
+ *
+ * Without the macro the hooks are discarded by `if constexpr`,
+ * release build pays nothing. The macro must be the same for all
+ * translation units of the program.
+ *
+ * Counters are per thread, without locks; a thread merges its counters
+ * into the process totals when it exits. `profile::counters()` returns
+ * totals of exited threads plus the calling thread, join workers first.
+ * See `accessReport` for knobs ranked by accesses and never read knobs.
+ */
+#pragma once
+#ifndef KNOBCPP_ACCESS_PROFILE_H_INCLUDED
+#define KNOBCPP_ACCESS_PROFILE_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "static_knob.h"
+
+namespace knb {
+
+/// Knob access profiling flag as StaticKnob, see access_profile.h.
+constexpr StaticKnob profileKnobAccess{
+#if defined KNOBCPP_PROFILE
+true
+#else
+false
+#endif
+};
+
+namespace profile {
+
+/// Accesses of one knob or group.
+struct Counter
+{
+    std::uint64_t reads{0};     ///< typed accessor calls
+    std::uint64_t lookups{0};   ///< name lookups that found it
+    std::uint64_t lookupNs{0};  ///< time spent in those lookups
+    /// Nanoseconds from program start to the first access.
+    std::int64_t  firstNs{std::numeric_limits<std::int64_t>::max()};
+
+    std::uint64_t accesses() const {return reads + lookups;}
+
+    void merge(const Counter& c) {
+        reads += c.reads; lookups += c.lookups; lookupNs += c.lookupNs;
+        if (c.firstNs < firstNs) firstNs = c.firstNs;
+    }
+};
+
+/// Counters by address of the Knob or Group.
+using Counters = std::unordered_map<const void*,Counter>;
+
+namespace detail {
+
+using Clock = std::chrono::steady_clock;
+
+inline const Clock::time_point startTime = Clock::now();
+
+inline std::int64_t sinceStart(Clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - startTime).count();
+}
+
+/// Counters of exited threads.
+struct Totals
+{
+    std::mutex mutex;
+    Counters counters;
+
+    static Totals& get() { static Totals t; return t; }
+};
+
+struct ThreadCounters
+{
+    Counters counters;
+    unsigned paused{0};
+
+    ThreadCounters() { Totals::get(); } // totals outlive this thread table
+
+    ~ThreadCounters() {
+        Totals& t = Totals::get();
+        std::lock_guard<std::mutex> lock(t.mutex);
+        for (const auto& [p, c] : counters) t.counters[p].merge(c);
+    }
+
+    Counter& at(const void* p, Clock::time_point now) {
+        auto [it, inserted] = counters.try_emplace(p);
+        if (inserted) it->second.firstNs = sinceStart(now);
+        return it->second;
+    }
+
+    static ThreadCounters& get() { thread_local ThreadCounters t; return t; }
+};
+
+inline void read(const void* p)
+{
+    ThreadCounters& t = ThreadCounters::get();
+    if (t.paused == 0) ++t.at(p, Clock::now()).reads;
+}
+
+template <typename T> const void* target(T* p) {return p;}
+template <typename T> const void* target(const T& x) {return &x;}
+
+/** Call `find`, count lookup of what it returns.
+ *
+ * `find` returns a reference or a pointer, `nullptr` is not counted.
+ */
+template <typename F>
+decltype(auto) timedLookup(F& find)
+{
+    ThreadCounters& t = ThreadCounters::get();
+    const Clock::time_point start = Clock::now();
+    decltype(auto) res = find();
+    const Clock::time_point end = Clock::now();
+    if (const void* p = target(res); t.paused == 0 and p != nullptr) {
+        Counter& c = t.at(p, start);
+        ++c.lookups;
+        c.lookupNs += static_cast<std::uint64_t>(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(end - start).count());
+    }
+    return res;
+}
+
+} // namespace detail
+
+/** Call `find` and return its result, count the lookup if profiling.
+ *
+ * `find` returns reference or pointer to the found Knob or Group.
+ */
+template <typename F>
+decltype(auto) lookup(F&& find)
+{
+    if constexpr (profileKnobAccess == true) return detail::timedLookup(find);
+    else return find();
+}
+
+/** Do not count accesses of this thread while the guard lives.
+ *
+ * Used by the library when it reads every knob: printing,
+ * FrozenGroup and snapshot, so they do not hide unused knobs.
+ */
+class Pause
+{
+public:
+    Pause() { if constexpr (profileKnobAccess == true) ++detail::ThreadCounters::get().paused; }
+    ~Pause() { if constexpr (profileKnobAccess == true) --detail::ThreadCounters::get().paused; }
+    Pause(const Pause&) = delete;
+    Pause& operator=(const Pause&) = delete;
+};
+
+/// Counters of exited threads plus the calling thread.
+inline Counters counters()
+{
+    detail::Totals& t = detail::Totals::get();
+    Counters res;
+    {
+        std::lock_guard<std::mutex> lock(t.mutex);
+        res = t.counters;
+    }
+    for (const auto& [p, c] : detail::ThreadCounters::get().counters) res[p].merge(c);
+    return res;
+}
+
+/// Forget counters of exited threads and the calling thread.
+inline void reset()
+{
+    detail::Totals& t = detail::Totals::get();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.counters.clear();
+    detail::ThreadCounters::get().counters.clear();
+}
+
+} // namespace profile
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief     Report of knob accesses: hot knobs and never used knobs
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Build with `-DKNOBCPP_PROFILE`, run, and print the report at exit:
+ * ~~~{.cpp}
+ * knb::accessReport(knobs).print(std::cerr);
+ * ~~~
+ * Knobs with many lookups are candidates for `bind` or FrozenGroup,
+ * knobs that were never used are candidates for deletion.
+ * Reads through KnobHandle, FrozenGroup and snapshot are not seen.
+ * Without `KNOBCPP_PROFILE` nothing is counted, every knob is unused.
+ */
+#pragma once
+#ifndef KNOBCPP_ACCESS_REPORT_H_INCLUDED
+#define KNOBCPP_ACCESS_REPORT_H_INCLUDED
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+#include "access_profile.h"
+#include "knob.h"
+
+namespace knb {
+
+/// Counters of one knob or group, path is relative to the report root.
+struct AccessRecord
+{
+    std::string path;
+    profile::Counter count;
+};
+
+struct AccessReport
+{
+    std::vector<AccessRecord> knobs;  ///< used knobs, most accessed first
+    std::vector<AccessRecord> groups; ///< looked up groups, most looked up first
+    std::vector<std::string>  unused; ///< knobs never read or looked up, visit order
+
+    /// Print `top` most accessed knobs and groups, and all unused knobs.
+    void print(std::ostream& o, std::size_t top = 20) const
+    {
+        std::string out;
+        auto table = [&](const char* title, const std::vector<AccessRecord>& recs) {
+            out += title; out += ": "; out += std::to_string(recs.size()); out += '\n';
+            if (recs.empty()) return;
+            out += "       reads     lookups  ns/lookup  first ms  path\n";
+            char line[80];
+            for (std::size_t i = 0; i < std::min(top, recs.size()); ++i) {
+                const profile::Counter& c = recs[i].count;
+                std::snprintf(line, sizeof(line), "%12llu%12llu%11llu%10.3f  ",
+                    static_cast<unsigned long long>(c.reads),
+                    static_cast<unsigned long long>(c.lookups),
+                    static_cast<unsigned long long>(c.lookups? c.lookupNs / c.lookups : 0),
+                    static_cast<double>(c.firstNs) / 1e6);
+                out += line; out += recs[i].path; out += '\n';
+            }
+        };
+        table("used knobs", knobs);
+        table("looked up groups", groups);
+        out += "unused knobs: "; out += std::to_string(unused.size()); out += '\n';
+        for (const std::string& path : unused) { out += "  "; out += path; out += '\n'; }
+        o.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+};
+
+namespace detail {
+
+inline void collectAccesses(const Group& g, const std::string& prefix,
+                            const profile::Counters& counters, AccessReport& report)
+{
+    for (const Knob& k : g.knobs()) {
+        std::string path = prefix + std::string(k.name());
+        if (auto c = counters.find(&k); c != std::end(counters) and c->second.accesses() != 0) {
+            report.knobs.push_back({std::move(path), c->second});
+        } else {
+            report.unused.push_back(std::move(path));
+        }
+    }
+    for (const Group& sub : g.groups()) {
+        std::string path = prefix + std::string(sub.name());
+        if (auto c = counters.find(&sub); c != std::end(counters) and c->second.lookups != 0) {
+            report.groups.push_back({path, c->second});
+        }
+        collectAccesses(sub, path + ':', counters, report);
+    }
+}
+
+} // namespace detail
+
+/** Accesses of knobs and groups of the sub-tree `root`.
+ *
+ * Counters are taken from `profile::counters()`: exited threads
+ * and the calling thread.
+ */
+inline AccessReport accessReport(const Group& root,
+                                 const profile::Counters& counters = profile::counters())
+{
+    AccessReport report;
+    detail::collectAccesses(root, "", counters, report);
+    auto hotter = [](const AccessRecord& a, const AccessRecord& b) {
+        return a.count.accesses() > b.count.accesses();
+    };
+    std::stable_sort(std::begin(report.knobs), std::end(report.knobs), hotter);
+    std::stable_sort(std::begin(report.groups), std::end(report.groups), hotter);
+    return report;
+}
+
+}
+
+#endif
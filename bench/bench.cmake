@@ -0,0 +1,45 @@
+# Benchmarks are not part of `make test`, run them by hand:
+# `./bench_frozen_group`.
+
+add_executable (bench_frozen_group bench/bench_frozen_group.cpp)
+add_executable (bench_memory bench/bench_memory.cpp)
+add_executable (bench_arena bench/bench_arena.cpp)
+add_executable (bench_snapshot bench/bench_snapshot.cpp)
+add_executable (bench_config_file bench/bench_config_file.cpp)
+add_executable (bench_program_options bench/bench_program_options.cpp)
+add_executable (bench_config_handle bench/bench_config_handle.cpp)
+add_executable (bench_live_knob bench/bench_live_knob.cpp)
+add_executable (bench_dispatch bench/bench_dispatch.cpp)
+add_executable (bench_knobcpp bench/bench_knobcpp.cpp)
+add_executable (bench_sweep bench/bench_sweep.cpp)
+add_executable (bench_visit bench/bench_visit.cpp)
+add_executable (bench_serializer bench/bench_serializer.cpp)
+add_executable (bench_codec bench/bench_codec.cpp)
+add_executable (bench_fingerprint bench/bench_fingerprint.cpp)
+add_executable (bench_derived bench/bench_derived.cpp)
+add_executable (bench_group_builder bench/bench_group_builder.cpp)
+
+set_target_properties(bench_frozen_group bench_memory bench_arena bench_snapshot
+    bench_config_file bench_program_options bench_config_handle bench_live_knob
+    bench_dispatch bench_knobcpp bench_sweep bench_visit bench_serializer bench_codec
+    bench_fingerprint bench_derived bench_group_builder
+    PROPERTIES COMPILE_FLAGS "-O2"
+)
+
+target_link_libraries(bench_config_handle Threads::Threads)
+target_link_libraries(bench_live_knob Threads::Threads)
+target_link_libraries(bench_sweep Threads::Threads)
+target_link_libraries(bench_visit Threads::Threads)
+
+# Opt-in performance regression check, `cmake -DKNOBCPP_BENCH_REGRESSION=ON`.
+# bench/baseline.json in the tree is only a sample of the result format,
+# taken on another machine. Regenerate it locally before enabling the check,
+# and again after changes that make code faster or slower on purpose:
+# `./bench_knobcpp --max-knobs 100000 --json ../bench/baseline.json`.
+option(KNOBCPP_BENCH_REGRESSION "Compare bench_knobcpp results with bench/baseline.json" OFF)
+if (KNOBCPP_BENCH_REGRESSION)
+    add_test(NAME bench_knobcpp_regression
+        COMMAND bench_knobcpp --max-knobs 100000 --json bench_knobcpp.json
+                --baseline ${KNOBCPP_SOURCE_DIR}/bench/baseline.json --tolerance 2.0
+    )
+endif()
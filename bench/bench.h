@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief     Helpers shared by knobcpp benchmarks
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ */
+#pragma once
+#ifndef KNOBCPP_BENCH_H_INCLUDED
+#define KNOBCPP_BENCH_H_INCLUDED
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "../knob.h"
+
+namespace knb::bench {
+
+/// Keep value alive so the compiler does not drop benchmarked code.
+template <typename T>
+inline void keep(const T& v) { asm volatile("" : : "g"(&v) : "memory"); }
+
+/// Run `fn` `reps` times, return nanoseconds per repetition.
+template <typename F>
+double timeit(std::size_t reps, F&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < reps; ++i) fn(i);
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>(stop - start).count() / reps;
+}
+
+/** Run `fn` until it takes at least `minNs` in total, return ns per call.
+ *
+ * Number of calls doubles, so fast and slow functions are measured
+ * with similar precision.
+ */
+template <typename F>
+double autotime(F&& fn, double minNs = 2e7)
+{
+    for (std::size_t reps = 1;; reps *= 2) {
+        const double ns = timeit(reps, fn);
+        if (ns * reps >= minNs or reps >= (std::size_t(1) << 30)) return ns;
+    }
+}
+
+inline void report(const std::string& what, std::size_t n, double ns)
+{
+    std::cout << std::left << std::setw(40) << what
+              << " n=" << std::setw(8) << n
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << ns << " ns" << std::endl;
+}
+
+/// Knob leaf name for knob `i`, unique over the whole tree.
+inline std::string knobName(std::size_t i, const std::string& prefix = "unit-knob-")
+{
+    return prefix + std::to_string(i);
+}
+
+/// Path of groups (relative to root) that holds knob `i`.
+inline std::string groupPath(std::size_t i, std::size_t fanout, std::size_t depth)
+{
+    std::string path;
+    std::size_t g = i / fanout;
+    for (std::size_t d = 0; d < depth; ++d, g /= fanout) {
+        path += (path.empty()? "g" : ":g") + std::to_string(g % fanout);
+    }
+    return path;
+}
+
+/** Build tree with `n` knobs, `fanout` knobs per group and groups per level.
+ *
+ * Knob types cycle over {int,bool,float,string}.
+ */
+inline void fillTree(Group& root, std::size_t n, std::size_t fanout = 16, std::size_t depth = 3,
+                     const std::string& prefix = "unit-knob-")
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        Group* g = &root;
+        std::size_t gi = i / fanout;
+        for (std::size_t d = 0; d < depth; ++d, gi /= fanout) {
+            g = &g->getGroup("g" + std::to_string(gi % fanout));
+        }
+        const std::string nm = knobName(i, prefix);
+        switch (i % 4) {
+        case 0: g->addKnob(nm, static_cast<int>(i), "integer knob, size of some simulated structure"); break;
+        case 1: g->addKnob(nm, (i & 2) != 0, "boolean knob, enables some simulated feature"); break;
+        case 2: g->addKnob(nm, static_cast<float>(i) / 3, "float knob, ratio of some simulated events"); break;
+        case 3: g->addKnob(nm, std::string("value-") + std::to_string(i), "string knob, policy name of simulated unit"); break;
+        }
+    }
+}
+
+}
+
+#endif
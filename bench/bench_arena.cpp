@@ -0,0 +1,36 @@
+/** Build and destroy configuration tree: default heap vs monotonic arena.
+ */
+#include <memory_resource>
+
+#include "bench.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {1000, 10000, 100000}) {
+        const std::size_t reps = (n < 100000)? 20 : 5;
+        double build = 0, destroy = 0;
+
+        for (std::size_t r = 0; r < reps; ++r) {
+            auto* knobs = new Group("root");
+            build += bench::timeit(1, [&](std::size_t){ bench::fillTree(*knobs, n); });
+            destroy += bench::timeit(1, [&](std::size_t){ delete knobs; });
+        }
+        bench::report("heap: build", n, build / reps);
+        bench::report("heap: destroy", n, destroy / reps);
+
+        // arena is reused run after run, like per experiment rebuild
+        std::pmr::monotonic_buffer_resource arena;
+        build = destroy = 0;
+        for (std::size_t r = 0; r < reps; ++r) {
+            auto* knobs = new Group("root", &arena);
+            build += bench::timeit(1, [&](std::size_t){ bench::fillTree(*knobs, n); });
+            destroy += bench::timeit(1, [&](std::size_t){ delete knobs; arena.release(); });
+        }
+        bench::report("arena: build", n, build / reps);
+        bench::report("arena: destroy", n, destroy / reps);
+    }
+
+    return 0;
+}
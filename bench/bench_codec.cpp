@@ -0,0 +1,63 @@
+/** Value conversion: stoi/stof/to_string vs codec from_chars/to_chars.
+ */
+#include <random>
+
+#include "bench.h"
+#include "../codec.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    const std::size_t n = 1000000;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> ints(-1000000, 1000000);
+    std::uniform_real_distribution<float> floats(0.0f, 1000.0f);
+
+    std::vector<std::string> intText, floatText, unitText;
+    std::vector<float> values;
+    for (std::size_t i = 0; i < n; ++i) {
+        intText.push_back(std::to_string(ints(rng)));
+        values.push_back(floats(rng));
+        floatText.push_back(codec::encode(values.back()));
+        unitText.push_back(std::to_string(i % 1024) + ((i & 1)? "KiB" : "M"));
+    }
+
+    long long sum = 0;
+    bench::report("std::stoi", n, bench::timeit(n, [&](std::size_t i){
+        sum += std::stoi(intText[i]);
+    }));
+    bench::report("codec::decode int", n, bench::timeit(n, [&](std::size_t i){
+        int v = 0; bench::keep(codec::decode(intText[i], v)); sum += v;
+    }));
+    bench::report("codec::decode int with unit", n, bench::timeit(n, [&](std::size_t i){
+        int v = 0; bench::keep(codec::decode(unitText[i], v)); sum += v;
+    }));
+    bench::report("std::stof", n, bench::timeit(n, [&](std::size_t i){
+        sum += static_cast<long long>(std::stof(floatText[i]));
+    }));
+    bench::report("codec::decode float", n, bench::timeit(n, [&](std::size_t i){
+        float v = 0; bench::keep(codec::decode(floatText[i], v)); sum += static_cast<long long>(v);
+    }));
+    bench::keep(sum);
+
+    std::size_t lost = 0;
+    bench::report("std::to_string float", n, bench::timeit(n, [&](std::size_t i){
+        const std::string s = std::to_string(values[i]);
+        lost += std::stof(s) != values[i];
+    }));
+    bench::report("codec::encode float", n, bench::timeit(n, [&](std::size_t i){
+        const std::string s = codec::encode(values[i]);
+        float back = 0; codec::decode(s, back);
+        lost += back != values[i];
+    }));
+    std::cout << lost << " of " << n << " floats did not round-trip through std::to_string" << std::endl;
+
+    std::string out;
+    bench::report("codec::append float, reused buffer", n, bench::timeit(n, [&](std::size_t i){
+        if ((i & 1023) == 0) out.clear();
+        codec::append(out, values[i]);
+    }));
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/** Throughput of configuration file loading, MB/s.
+ */
+#include <cstdio>
+#include <fstream>
+
+#include "bench.h"
+#include "../config_file.h"
+
+using namespace knb;
+
+namespace {
+
+struct NullHandler {
+    std::size_t values{0};
+    void section(std::size_t, strv) {}
+    void value(std::size_t, strv k, strv v) { values += k.size() + v.size(); }
+    void error(std::size_t, const char*) {}
+};
+
+std::string makeConfig(std::size_t n, std::size_t fanout = 16)
+{
+    std::string text;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i % fanout == 0) text += "\n[" + bench::groupPath(i, fanout, 3) + "]\n";
+        text += bench::knobName(i) + " = ";
+        switch (i % 4) {
+        case 0: text += std::to_string(i); break;
+        case 1: text += (i & 2)? "true" : "false"; break;
+        case 2: text += std::to_string(static_cast<float>(i) / 3); break;
+        case 3: text += "\"value-" + std::to_string(i) + "\""; break;
+        }
+        text += "   # comment\n";
+    }
+    return text;
+}
+
+void reportMBs(const std::string& what, std::size_t bytes, double ns)
+{
+    std::cout << std::left << std::setw(40) << what << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << bytes / ns * 1e3 << " MB/s" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {10000, 100000, 1000000}) {
+        const std::string text = makeConfig(n);
+        std::cout << n << " knobs, " << text.size() / 1000000.0 << " MB" << std::endl;
+
+        NullHandler null;
+        reportMBs("  ConfigReader (tokenize only)", text.size(), bench::timeit(1, [&](std::size_t){
+            ConfigReader reader;
+            reader.feed(text, null);
+            reader.finish(null);
+        }));
+        bench::keep(null.values);
+
+        reportMBs("  loadConfig (into Group)", text.size(), bench::timeit(1, [&](std::size_t){
+            Group knobs("root");
+            loadConfig(text, knobs);
+        }));
+
+        Group knobs("root");
+        loadConfig(text, knobs);
+        reportMBs("  loadConfig (update existing knobs)", text.size(), bench::timeit(1, [&](std::size_t){
+            loadConfig(text, knobs);
+        }));
+
+        const std::string file = "bench_config_file.ini";
+        std::ofstream(file) << text;
+        reportMBs("  loadConfigFile (64KiB chunks)", text.size(), bench::timeit(1, [&](std::size_t){
+            Group knobs("root");
+            loadConfigFile(file, knobs, 64 * 1024);
+        }));
+        std::remove(file.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/** Reader throughput of ConfigHandle while configuration is reloaded,
+ *  compared with a shared_ptr guarded by mutex and with atomic shared_ptr.
+ */
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "bench.h"
+#include "../config_handle.h"
+
+using namespace knb;
+
+namespace {
+
+Group makeConfig(int version)
+{
+    Group knobs("config", false);
+    knobs.addKnob("version", version).addKnob("max", 100).addKnob("ratio", 0.5f);
+    return knobs;
+}
+
+/** Run `readers` threads that call `read(thread)` until stopped, while
+ *  main thread calls `reload()` every `reloadUs` microseconds (0 - never).
+ *  @return reads per second per reader thread
+ */
+template <typename Read, typename Reload>
+double run(unsigned readers, unsigned reloadUs, Read&& read, Reload&& reload)
+{
+    std::atomic<bool> start{false}, stop{false};
+    std::vector<std::size_t> counts(readers * 16, 0); // 16 = one cache line apart
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < readers; ++t) {
+        threads.emplace_back([&, t]{
+            auto reader = read(t);
+            while (not start.load()) {}
+            std::size_t n = 0;
+            while (not stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) reader();
+                n += 64;
+            }
+            counts[t * 16] = n;
+        });
+    }
+    const auto duration = std::chrono::milliseconds(300);
+    auto begin = std::chrono::steady_clock::now();
+    start = true;
+    for (int v = 1; std::chrono::steady_clock::now() - begin < duration; ++v) {
+        if (reloadUs != 0) {
+            reload(v);
+            std::this_thread::sleep_for(std::chrono::microseconds(reloadUs));
+        } else {
+            std::this_thread::sleep_for(duration / 10);
+        }
+    }
+    stop = true;
+    for (auto& t : threads) t.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::size_t total = 0;
+    for (unsigned t = 0; t < readers; ++t) total += counts[t * 16];
+    return total / sec / readers;
+}
+
+void reportRate(const std::string& what, unsigned readers, double perSec)
+{
+    std::cout << std::left << std::setw(40) << what << " readers=" << std::setw(4) << readers
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << perSec / 1e6 << " M reads/s/thread" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<unsigned> readerCounts{1u, cores / 2, cores - 1};
+    readerCounts.erase(std::unique(std::begin(readerCounts), std::end(readerCounts)),
+                       std::end(readerCounts));
+    for (unsigned readers : readerCounts) {
+        for (unsigned reloadUs : {0u, 1000u, 100u}) {
+            const std::string reloads = (reloadUs == 0)? " no reload" :
+                " reload/" + std::to_string(reloadUs) + "us";
+
+            ConfigHandle config(makeConfig(0));
+            reportRate("ConfigHandle" + reloads, readers, run(readers, reloadUs,
+                [&](unsigned){
+                    return [r = std::make_shared<ConfigHandle::Reader>(config)]{
+                        auto cfg = r->read();
+                        bench::keep(cfg->at("max").asInt());
+                    };
+                },
+                [&](int v){ config.publish(makeConfig(v)); }));
+
+            std::mutex mutex;
+            std::shared_ptr<const Group> locked = std::make_shared<Group>(makeConfig(0));
+            reportRate("mutex + shared_ptr" + reloads, readers, run(readers, reloadUs,
+                [&](unsigned){
+                    return [&]{
+                        std::shared_ptr<const Group> cfg;
+                        { std::lock_guard<std::mutex> lock(mutex); cfg = locked; }
+                        bench::keep(cfg->at("max").asInt());
+                    };
+                },
+                [&](int v){
+                    auto next = std::make_shared<Group>(makeConfig(v));
+                    std::lock_guard<std::mutex> lock(mutex); locked = next;
+                }));
+
+            std::shared_ptr<const Group> shared = std::make_shared<Group>(makeConfig(0));
+            reportRate("atomic_load(shared_ptr)" + reloads, readers, run(readers, reloadUs,
+                [&](unsigned){
+                    return [&]{
+                        auto cfg = std::atomic_load(&shared);
+                        bench::keep(cfg->at("max").asInt());
+                    };
+                },
+                [&](int v){
+                    std::atomic_store(&shared, std::shared_ptr<const Group>(
+                        std::make_shared<Group>(makeConfig(v))));
+                }));
+        }
+    }
+
+    return 0;
+}
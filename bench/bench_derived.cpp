@@ -0,0 +1,59 @@
+/** Derived knobs of 10k/100k-knob trees.
+ *
+ * One derived knob per group of 16 knobs; after a change of one input,
+ * reading all derived knobs recomputes one of them vs computing every
+ * derived knob again, what eager evaluation does.
+ */
+#include "bench.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {10000, 100000}) {
+        Group knobs("root", false);
+        bench::fillTree(knobs, n);
+
+        std::vector<std::string> paths;
+        for (std::size_t i = 0; i < n; i += 16) {
+            const std::string group = bench::groupPath(i, 16, 3);
+            Group* g = &knobs;
+            for (strv p = group; not p.empty();) {
+                const auto pos = p.find(':');
+                g = &g->getGroup(p.substr(0, pos));
+                p = (pos == strv::npos)? strv() : p.substr(pos + 1);
+            }
+            const std::string name = "derived-" + std::to_string(i);
+            g->addDerived<int>(name, bench::knobName(i) + " * 2 + " + bench::knobName(i + 4));
+            paths.push_back(group + ":" + name);
+        }
+
+        std::size_t sum = 0;
+        bench::report("copy tree + evaluate all derived", n, bench::timeit(1, [&](std::size_t){
+            Group copy(knobs);
+            copy.evaluate();
+        }));
+
+        knobs.evaluate();
+        const Knob& input = knobs.atPath(bench::groupPath(0, 16, 3) + ":" + bench::knobName(0));
+        bench::report("changeValue + read all derived", n, bench::autotime([&](std::size_t i){
+            knobs.changeValue(&input, (i & 1)? "1" : "2");
+            for (const std::string& p : paths) sum += knobs.atPath(p).asInt();
+        }));
+
+        std::vector<std::vector<std::string>> inputs;
+        for (const std::string& p : paths) inputs.push_back(knobs.derivedInputs(p));
+        Knob out;
+        bench::report("changeValue + compute all derived", n, bench::autotime([&](std::size_t i){
+            knobs.changeValue(&input, (i & 1)? "1" : "2");
+            for (std::size_t d = 0; d < paths.size(); ++d) {
+                const Knob* args[2] = {&knobs.atPath(inputs[d][0]), &knobs.atPath(inputs[d][1])};
+                knobs.derive(paths[d], DerivedInputs(args, 2), out);
+                sum += out.asInt();
+            }
+        }));
+        bench::keep(sum);
+    }
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+/** Inner loop that reads runtime knobs vs the same loop instantiated
+ *  for knob values with dispatch.
+ */
+#include "bench.h"
+#include "../dispatch.h"
+
+using namespace knb;
+
+namespace {
+
+/// Toy cache index loop, `ways` divides and `prefetch` branches.
+template <typename Ways, typename Prefetch>
+std::uint64_t kernel(const std::vector<std::uint32_t>& addrs, Ways ways, Prefetch prefetch)
+{
+    std::uint64_t sum = 0;
+    for (std::uint32_t a : addrs) {
+        sum += (a / 64) % ways;
+        if (prefetch) sum += ((a + 64) / 64) % ways;
+    }
+    return sum;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::uint32_t> addrs(1 << 20);
+    for (std::size_t i = 0; i < addrs.size(); ++i) addrs[i] = static_cast<std::uint32_t>(i * 2654435761u);
+
+    Group knobs("root");
+    knobs.addKnob("ways", 8).addKnob("prefetch", true);
+    const Knob& ways = knobs.at("ways");
+    const Knob& prefetch = knobs.at("prefetch");
+
+    bench::report("runtime knob values", addrs.size(), bench::timeit(20, [&](std::size_t){
+        bench::keep(kernel(addrs, static_cast<unsigned>(ways.asInt()), prefetch.asBool()));
+    }) / addrs.size());
+
+    bench::report("dispatch<Choices<1,2,4,8,16>,..>", addrs.size(), bench::timeit(20, [&](std::size_t){
+        bench::keep(dispatch<Choices<1u,2u,4u,8u,16u>, Choices<false,true>>(std::tie(ways, prefetch),
+            [&](auto w, auto p){ return kernel(addrs, w(), p); }));
+    }) / addrs.size());
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+/** Fingerprint and diff of 10k/100k-knob trees.
+ *
+ * Incremental fingerprint vs hashing the whole tree after a change;
+ * diff of trees that differ in one knob vs comparing every knob.
+ */
+#include "bench.h"
+#include "../diff.h"
+
+using namespace knb;
+
+namespace {
+
+/// Hash every knob with its path, what a non-incremental fingerprint does.
+Fingerprint fullHash(const Group& g)
+{
+    Fingerprint fp;
+    std::string path;
+    for (auto it = g.tree().begin(), end = g.tree().end(); it != end; ++it) {
+        path.clear();
+        it.appendPath(path);
+        detail::HashState h;
+        h.add(path).add(it->asString());
+        fp += h.finish();
+    }
+    return fp;
+}
+
+/// Compare every knob of `a` with the knob at the same path in `b`.
+std::size_t compareAll(const Group& a, const Group& b)
+{
+    std::size_t changed = 0;
+    std::string path;
+    for (auto it = a.tree().begin(), end = a.tree().end(); it != end; ++it) {
+        path.clear();
+        it.appendPath(path);
+        const Knob* k = b.findPath(path);
+        changed += (k == nullptr or *k != *it);
+    }
+    return changed;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {10000, 100000}) {
+        Group knobs("root", false);
+        bench::fillTree(knobs, n);
+        Group other(knobs);
+
+        const std::string path = bench::groupPath(0, 16, 3) + ":" + bench::knobName(0);
+        const Knob& k = knobs.atPath(path);
+        bench::report("changeValue + fingerprint()", n, bench::autotime([&](std::size_t i){
+            knobs.changeValue(&k, (i & 1)? "1" : "2");
+            bench::keep(knobs.fingerprint());
+        }));
+        bench::report("changeValue + hash whole tree", n, bench::timeit(5, [&](std::size_t i){
+            knobs.changeValue(&k, (i & 1)? "1" : "2");
+            bench::keep(fullHash(knobs));
+        }));
+
+        knobs.changeValue(&k, "3");
+        bench::report("diff, one knob differs", n, bench::autotime([&](std::size_t){
+            bench::keep(diff(knobs, other));
+        }));
+        bench::report("compare every knob by path", n, bench::timeit(5, [&](std::size_t){
+            bench::keep(compareAll(knobs, other));
+        }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+/** Compare map-based Group with FrozenGroup: build cost and lookup cost.
+ */
+#include "bench.h"
+#include "../frozen_group.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {1000, 10000, 100000}) {
+        const std::size_t reps = 1000000;
+        std::vector<std::string> names, paths;
+        for (std::size_t i = 0; i < 1000; ++i) {
+            std::size_t k = (i * 7919) % n;
+            names.push_back(bench::knobName(k));
+            paths.push_back(bench::groupPath(k, 16, 3) + ":" + names.back());
+        }
+
+        Group knobs("root");
+        bench::report("Group build", n, bench::timeit(1, [&](std::size_t){
+            bench::fillTree(knobs, n);
+        }));
+        knobs.finalize();
+
+        FrozenGroup* frozen{nullptr};
+        bench::report("FrozenGroup build", n, bench::timeit(1, [&](std::size_t){
+            frozen = new FrozenGroup(knobs);
+        }));
+
+        bench::report("Group::findKnob", n, bench::timeit(reps / 10, [&](std::size_t i){
+            bench::keep(knobs.findKnob(names[i % names.size()]));
+        }));
+        bench::report("Group::lookup", n, bench::timeit(reps, [&](std::size_t i){
+            bench::keep(knobs.lookup(names[i % names.size()]));
+        }));
+        bench::report("FrozenGroup::findKnob", n, bench::timeit(reps, [&](std::size_t i){
+            bench::keep(frozen->findKnob(names[i % names.size()]));
+        }));
+        bench::report("FrozenGroup::at(path)", n, bench::timeit(reps, [&](std::size_t i){
+            bench::keep(frozen->at(paths[i % paths.size()]));
+        }));
+
+        delete frozen;
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+/** Building a 1M-knob tree: chained `getGroup().addKnob()` vs GroupBuilder.
+ *
+ * Group paths and knob names are prepared before timing, both ways get
+ * the same strings. Builder is timed with knobs in generation order
+ * (least significant group first, needs sorting) and pre-sorted by path.
+ * Reported time is per knob.
+ */
+#include <algorithm>
+#include <numeric>
+
+#include "bench.h"
+#include "../group_builder.h"
+
+using namespace knb;
+
+template <typename F>
+static void addTo(F&& add, std::size_t i, const std::string& nm)
+{
+    switch (i % 4) {
+    case 0: add(nm, static_cast<int>(i), "integer knob, size of some simulated structure"); break;
+    case 1: add(nm, (i & 2) != 0, "boolean knob, enables some simulated feature"); break;
+    case 2: add(nm, static_cast<float>(i) / 3, "float knob, ratio of some simulated events"); break;
+    case 3: add(nm, std::string("value-") + std::to_string(i), "string knob, policy name of simulated unit"); break;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {100000, 1000000}) {
+        std::vector<std::vector<std::string>> groups(n);
+        std::vector<std::string> paths(n), names(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t gi = i / 16;
+            for (std::size_t d = 0; d < 3; ++d, gi /= 16) groups[i].push_back("g" + std::to_string(gi % 16));
+            paths[i] = bench::groupPath(i, 16, 3);
+            names[i] = bench::knobName(i);
+        }
+        std::vector<std::size_t> sorted(n);
+        std::iota(std::begin(sorted), std::end(sorted), 0);
+        std::sort(std::begin(sorted), std::end(sorted), [&](std::size_t a, std::size_t b) {
+            return std::tie(groups[a], names[a]) < std::tie(groups[b], names[b]);
+        });
+
+        Fingerprint expect;
+        bench::report("chained getGroup().addKnob()", n, bench::timeit(1, [&](std::size_t){
+            Group root("root");
+            for (std::size_t i = 0; i < n; ++i) {
+                Group* g = &root;
+                for (const auto& nm : groups[i]) g = &g->getGroup(nm);
+                addTo([g](auto&&... args) { g->addKnob(args...); }, i, names[i]);
+            }
+            expect = root.fingerprint();
+            bench::keep(root);
+        }) / n);
+
+        auto builder = [&](const std::string& what, const std::vector<std::size_t>& order) {
+            bench::report(what, n, bench::timeit(1, [&](std::size_t){
+                GroupBuilder b("root");
+                b.reserve(n);
+                for (std::size_t i : order) {
+                    addTo([&](auto&&... args) { b.add(paths[i], args...); }, i, names[i]);
+                }
+                Group root = b.build();
+                if (root.fingerprint() != expect) std::cerr << "different tree" << std::endl;
+                bench::keep(root);
+            }) / n);
+        };
+        std::vector<std::size_t> generated(n);
+        std::iota(std::begin(generated), std::end(generated), 0);
+        builder("GroupBuilder::build", generated);
+        builder("GroupBuilder::build, pre-sorted", sorted);
+
+        bench::report("GroupBuilder::buildFrozen, pre-sorted", n, bench::timeit(1, [&](std::size_t){
+            GroupBuilder b("root");
+            b.reserve(n);
+            for (std::size_t i : sorted) {
+                addTo([&](auto&&... args) { b.add(paths[i], args...); }, i, names[i]);
+            }
+            FrozenGroup frozen = b.buildFrozen();
+            bench::keep(frozen);
+        }) / n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/** Microbenchmarks of the core API over tree sizes and depths.
+ *
+ * ~~~
+ * ./bench_knobcpp [--max-knobs 1000000] [--json out.json]
+ *                 [--baseline bench/baseline.json --tolerance 2.0]
+ * ~~~
+ * With `--baseline` every result is compared with the result of the
+ * same name, size and depth in the baseline file; program fails if
+ * some result is slower than `tolerance` times the baseline.
+ * Timings depend on the machine, compare only with a baseline written
+ * by `--json` on the same machine, see bench.cmake.
+ */
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+
+#include "bench.h"
+#include "../program_options.h"
+
+using namespace knb;
+
+namespace {
+
+struct Result {
+    std::string name;
+    std::size_t n;
+    std::size_t depth;
+    double ns;
+};
+
+/// Stream buffer that drops everything, printing cost without I/O.
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override {return c;}
+    std::streamsize xsputn(const char*, std::streamsize n) override {return n;}
+};
+
+class Suite
+{
+    std::vector<Result> results_;
+    std::string filter_;
+
+public:
+    explicit Suite(std::string filter):filter_(std::move(filter)){}
+
+    const std::vector<Result>& results() const {return results_;}
+
+    bool enabled(const std::string& name) const {
+        return filter_.empty() or name.find(filter_) != std::string::npos;
+    }
+
+    template <typename F>
+    void run(const std::string& name, std::size_t n, std::size_t depth, F&& fn) {
+        if (not enabled(name)) return;
+        add(name, n, depth, bench::autotime(fn));
+    }
+
+    void add(const std::string& name, std::size_t n, std::size_t depth, double ns) {
+        results_.push_back(Result{name, n, depth, ns});
+        bench::report(name + " d=" + std::to_string(depth), n, ns);
+    }
+};
+
+void benchKnob(Suite& s)
+{
+    auto pool = std::make_shared<StringPool>();
+    const std::string desc = "integer knob, size of some simulated structure";
+    s.run("Knob(int)", 1, 0, [&](std::size_t i){
+        Knob k(pool, "unit-knob-1", static_cast<int>(i), desc);
+        bench::keep(k);
+    });
+    s.run("Knob(string)", 1, 0, [&](std::size_t){
+        Knob k(pool, "unit-knob-1", std::string("some-long-policy-name-value"), desc);
+        bench::keep(k);
+    });
+    const Knob ki(pool, "unit-knob-1", 42, desc);
+    const Knob ks(pool, "unit-knob-1", std::string("some-long-policy-name-value"), desc);
+    const Knob kf(pool, "unit-knob-1", 3.14f, desc);
+    s.run("Knob copy int", 1, 0, [&](std::size_t){ Knob k(ki); bench::keep(k); });
+    s.run("Knob copy string", 1, 0, [&](std::size_t){ Knob k(ks); bench::keep(k); });
+    s.run("Knob::asString int", 1, 0, [&](std::size_t){ bench::keep(ki.asString()); });
+    s.run("Knob::asString float", 1, 0, [&](std::size_t){ bench::keep(kf.asString()); });
+    s.run("Knob::asString string", 1, 0, [&](std::size_t){ bench::keep(ks.asString()); });
+}
+
+void benchGroup(Suite& s, std::size_t n, std::size_t depth)
+{
+    const std::size_t fanout = 16;
+    std::vector<std::string> names, paths;
+    for (std::size_t i = 0; i < std::min<std::size_t>(n, 1024); ++i) {
+        const std::size_t k = (i * 7919) % n;
+        names.push_back(bench::knobName(k));
+        paths.push_back(bench::groupPath(k, fanout, depth));
+    }
+
+    Group knobs("root", false);
+    const double build = bench::timeit(1, [&](std::size_t){ bench::fillTree(knobs, n, fanout, depth); });
+    if (s.enabled("Group::addKnob")) s.add("Group::addKnob", n, depth, build / n);
+
+    std::vector<const Group*> owners;
+    for (const auto& p : paths) {
+        const Group* g = &knobs;
+        for (strv rest = p; not rest.empty();) {
+            const auto pos = rest.find(':');
+            g = &g->gr(rest.substr(0, pos));
+            rest = (pos == strv::npos)? strv() : rest.substr(pos + 1);
+        }
+        owners.push_back(g);
+    }
+
+    s.run("Group::at", n, depth, [&](std::size_t i){
+        const std::size_t j = i % names.size();
+        bench::keep(owners[j]->at(names[j]));
+    });
+    s.run("Group::findKnob", n, depth, [&](std::size_t i){
+        bench::keep(knobs.findKnob(names[i % names.size()]));
+    });
+    if (s.enabled("Group::visit")) {
+        std::size_t count = 0;
+        s.add("Group::visit", n, depth, bench::autotime([&](std::size_t){
+            knobs.visit([&](const Knob& k){ count += k.typeId(); });
+        }) / n);
+        bench::keep(count);
+    }
+    std::vector<const Knob*> ints;
+    for (const auto& nm : names) {
+        if (const Knob* k = std::get<2>(knobs.findKnob(nm)); k->type() == Knob::T::Int) ints.push_back(k);
+    }
+    if (not ints.empty()) {
+        s.run("Group::changeValue", n, depth, [&](std::size_t i){
+            knobs.changeValue(ints[i % ints.size()], "12345");
+        });
+    }
+
+    if (s.enabled("parseOptions")) {
+        std::vector<std::string> options;
+        for (const auto& nm : names) {
+            const Knob* k = std::get<2>(knobs.findKnob(nm));
+            options.push_back("--" + nm);
+            if (k->type() != Knob::T::Bool) options.push_back(k->asString());
+        }
+        s.add("parseOptions", n, depth, bench::autotime([&](std::size_t){
+            bench::keep(parseOptions(options, knobs));
+        }) / names.size());
+    }
+
+    if (s.enabled("printOptions")) {
+        NullBuffer buf;
+        std::ostream null(&buf);
+        s.add("printOptions", n, depth, bench::autotime([&](std::size_t){
+            printOptions(knobs, null);
+        }) / n);
+    }
+}
+
+void benchArray(Suite& s, std::size_t n)
+{
+    Array ar("array");
+    for (std::size_t i = 0; i < n; ++i) ar.addKnob(bench::knobName(i), static_cast<int>(i));
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < 64; ++i) names.push_back(bench::knobName((i * 7919) % n));
+    s.run("Array::findKnob", n, 0, [&](std::size_t i){
+        bench::keep(ar.findKnob(names[i % names.size()]));
+    });
+}
+
+void writeJson(std::ostream& o, const std::vector<Result>& results)
+{
+    o << "{\"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        o << "  {\"name\": \"" << r.name << "\", \"n\": " << r.n << ", \"depth\": " << r.depth
+          << ", \"ns\": " << std::fixed << std::setprecision(2) << r.ns << "}"
+          << ((i + 1 < results.size())? ",\n" : "\n");
+    }
+    o << "]}\n";
+}
+
+/// Read file written by `writeJson`, one result per line.
+std::vector<Result> readJson(std::istream& in)
+{
+    std::vector<Result> results;
+    auto field = [](const std::string& ln, const std::string& key) {
+        const auto pos = ln.find("\"" + key + "\": ");
+        return (pos == std::string::npos)? std::string() : ln.substr(pos + key.size() + 4);
+    };
+    for (std::string ln; std::getline(in, ln);) {
+        const std::string name = field(ln, "name");
+        if (name.size() < 2) continue;
+        Result r;
+        r.name = name.substr(1, name.find('"', 1) - 1);
+        r.n = std::stoul(field(ln, "n"));
+        r.depth = std::stoul(field(ln, "depth"));
+        r.ns = std::stod(field(ln, "ns"));
+        results.push_back(r);
+    }
+    return results;
+}
+
+/// Results slower than `tolerance` times the baseline; small absolute noise is ignored.
+std::size_t compare(const std::vector<Result>& results, const std::vector<Result>& baseline,
+                    double tolerance)
+{
+    std::size_t slower = 0, compared = 0;
+    for (const Result& r : results) {
+        for (const Result& b : baseline) {
+            if (b.name != r.name or b.n != r.n or b.depth != r.depth) continue;
+            ++compared;
+            if (r.ns > b.ns * tolerance + 5.0) {
+                ++slower;
+                std::cout << "REGRESSION " << r.name << " n=" << r.n << " d=" << r.depth
+                          << ": " << r.ns << " ns, baseline " << b.ns << " ns" << std::endl;
+            }
+        }
+    }
+    std::cout << compared << " results compared with baseline, " << slower
+              << " regressions" << std::endl;
+    return slower;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    Group opts("bench_knobcpp", false);
+    opts.addKnob("max-knobs", 1000000, "Largest tree size, sizes are 10, 100, ... max-knobs")
+        .addKnob("json", "", "Write results to JSON file")
+        .addKnob("baseline", "", "Compare results with JSON file written by --json")
+        .addKnob("tolerance", 2.0f, "Result is a regression if slower than tolerance * baseline")
+        .addKnob("filter", "", "Run only benchmarks with names that contain filter")
+        .addKnob("help", false, "Print options");
+    OptionParser parser;
+    if (not parser.parse(argc, argv, opts) or not parser.unknown().empty()) {
+        for (const auto& e : parser.errors()) std::cerr << e << std::endl;
+        for (auto op : parser.unknown()) std::cerr << "unknown option " << op << std::endl;
+        return 2;
+    }
+    if (opts.at("help").asBool()) { printOptions(opts); return 0; }
+
+    const std::size_t maxKnobs = static_cast<std::size_t>(opts.at("max-knobs").asInt());
+    Suite suite(opts.at("filter").asString());
+
+    benchKnob(suite);
+    for (std::size_t n = 10; n <= maxKnobs; n *= 10) {
+        for (std::size_t depth : {1, 3}) benchGroup(suite, n, depth);
+        if (n <= 100000) benchArray(suite, n); // linear search
+    }
+
+    if (const std::string json = opts.at("json").asString(); not json.empty()) {
+        std::ofstream out(json);
+        writeJson(out, suite.results());
+    }
+    if (const std::string base = opts.at("baseline").asString(); not base.empty()) {
+        std::ifstream in(base);
+        if (not in) { std::cerr << "can't open " << base << std::endl; return 2; }
+        return (compare(suite.results(), readJson(in), opts.at("tolerance").asFloat()) == 0)? 0 : 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+/** Read cost of live knob compared with plain Knob::asInt and KnobHandle.
+ */
+#include <thread>
+
+#include "bench.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    const std::size_t reps = 100000000;
+
+    Group knobs("root", false);
+    knobs.addKnob("plain", 1);
+    for (int i = 0; i < 16; ++i) {
+        knobs.addLiveKnob(bench::knobName(i, "live-"), i);
+    }
+    const Knob& plain = knobs.at("plain");
+    KnobHandle<int> handle = knobs.bind<int>("plain");
+    LiveKnob<int> live = knobs.live<int>("live-0");
+
+    int sum = 0;
+    bench::report("Knob::asInt", reps, bench::timeit(reps, [&](std::size_t){
+        sum += plain.asInt(); bench::keep(sum);
+    }));
+    bench::report("KnobHandle<int>::get", reps, bench::timeit(reps, [&](std::size_t){
+        sum += handle.get(); bench::keep(sum);
+    }));
+    bench::report("LiveKnob<int>::get", reps, bench::timeit(reps, [&](std::size_t){
+        sum += live.get(); bench::keep(sum);
+    }));
+
+    // another thread keeps changing the neighbour live knob,
+    // which is on another cache line
+    std::atomic<bool> stop{false};
+    std::thread writer([&]{
+        for (int v = 0; not stop.load(std::memory_order_relaxed); ++v) {
+            knobs.setLive("live-1", v);
+        }
+    });
+    bench::report("LiveKnob<int>::get, writer of live-1", reps, bench::timeit(reps, [&](std::size_t){
+        sum += live.get(); bench::keep(sum);
+    }));
+    stop = true;
+    writer.join();
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+/** Memory footprint of a configuration tree, bytes per knob.
+ *
+ * "before" is the layout knobcpp had before names and descriptions
+ * were interned: every knob owns `std::string` name and description,
+ * map key is another copy of the name.
+ */
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "bench.h"
+
+namespace {
+std::size_t liveBytes = 0;
+std::size_t allocs = 0;
+}
+
+// noinline: keeps gcc from matching inlined free() with operator new
+__attribute__((noinline)) void* operator new(std::size_t n)
+{
+    liveBytes += n; ++allocs;
+    auto* p = static_cast<std::size_t*>(std::malloc(n + sizeof(std::max_align_t)));
+    if (p == nullptr) throw std::bad_alloc();
+    *p = n;
+    return reinterpret_cast<char*>(p) + sizeof(std::max_align_t);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    if (p == nullptr) return;
+    auto* base = reinterpret_cast<std::size_t*>(static_cast<char*>(p) - sizeof(std::max_align_t));
+    liveBytes -= *base;
+    std::free(base);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+// std::pmr::new_delete_resource, the default resource of Group, allocates aligned
+void* operator new(std::size_t n, std::align_val_t a)
+{
+    if (static_cast<std::size_t>(a) > alignof(std::max_align_t)) throw std::bad_alloc();
+    return operator new(n);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { operator delete(p); }
+
+namespace {
+
+struct LegacyKnob {
+    std::string name_;
+    std::variant<bool,int,float,std::string> v;
+    std::string desc_;
+};
+
+struct LegacyGroup {
+    std::string name_;
+    std::map<std::string,LegacyKnob> knobs_;
+    std::map<std::string,LegacyGroup> groups_;
+    bool immutable_{true};
+};
+
+void fillLegacy(LegacyGroup& root, std::size_t n, const std::string& prefix,
+                std::size_t fanout = 16, std::size_t depth = 3)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        LegacyGroup* g = &root;
+        std::size_t gi = i / fanout;
+        for (std::size_t d = 0; d < depth; ++d, gi /= fanout) {
+            std::string nm = "g" + std::to_string(gi % fanout);
+            g = &g->groups_.try_emplace(nm, LegacyGroup{nm, {}, {}}).first->second;
+        }
+        const std::string nm = knb::bench::knobName(i, prefix);
+        LegacyKnob k{nm, {}, ""};
+        switch (i % 4) {
+        case 0: k.v = static_cast<int>(i); k.desc_ = "integer knob, size of some simulated structure"; break;
+        case 1: k.v = (i & 2) != 0; k.desc_ = "boolean knob, enables some simulated feature"; break;
+        case 2: k.v = static_cast<float>(i) / 3; k.desc_ = "float knob, ratio of some simulated events"; break;
+        case 3: k.v = std::string("value-") + std::to_string(i); k.desc_ = "string knob, policy name of simulated unit"; break;
+        }
+        g->knobs_.insert_or_assign(nm, k);
+    }
+}
+
+void report(const char* what, std::size_t n, std::size_t bytes, std::size_t nalloc)
+{
+    std::cout << std::left << std::setw(30) << what << " n=" << std::setw(8) << n
+              << std::right << std::setw(12) << bytes << " bytes"
+              << std::setw(10) << std::fixed << std::setprecision(1)
+              << static_cast<double>(bytes) / n << " bytes/knob"
+              << std::setw(8) << static_cast<double>(nalloc) / n << " allocs/knob" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    // Short names fit into std::string small buffer, long ones do not.
+    for (std::string prefix : {"unit-knob-", "core-l2-prefetcher-stride-table-entry-"})
+    for (std::size_t n : {1000, 10000, 100000}) {
+        std::cout << "knob name: " << knb::bench::knobName(n, prefix) << std::endl;
+        {
+            std::size_t before = liveBytes, nalloc = allocs;
+            LegacyGroup legacy{"root", {}, {}};
+            fillLegacy(legacy, n, prefix);
+            report("before (std::string names)", n, liveBytes - before, allocs - nalloc);
+        }
+        {
+            std::size_t before = liveBytes, nalloc = allocs;
+            knb::Group knobs("root");
+            knb::bench::fillTree(knobs, n, 16, 3, prefix);
+            report("after (interned names)", n, liveBytes - before, allocs - nalloc);
+            report("  of which string pool", n, knobs.pool()->bytes(), 0);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/** Command line parsing: 10k options against 10k-knob tree.
+ */
+#include <cstdio>
+#include <fstream>
+
+#include "bench.h"
+#include "../program_options.h"
+
+using namespace knb;
+
+namespace {
+
+/// What parseOptions did before OptionParser: copy argv, findKnob per option.
+void parseCopyFindKnob(int argc, char* argv[], Group& knobs)
+{
+    std::vector<std::string> options(argv, argv + argc);
+    const Knob* knob{nullptr};
+    bool waiting = false;
+    for (const auto& op : options) {
+        if (waiting) { waiting = false; knobs.changeValue(knob, op); }
+        else if (op.find("--") == 0) {
+            auto [found, path, k] = knobs.findKnob(op.substr(2));
+            bench::keep(path);
+            if (found) { knob = k; waiting = true; }
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {1000, 10000}) {
+        Group knobs("root", false);
+        bench::fillTree(knobs, n);
+
+        // every knob set once, in a shuffled order
+        std::vector<std::string> args{"prog"};
+        std::string rsp;
+        for (std::size_t j = 0; j < n; ++j) {
+            const std::size_t i = (j * 7919) % n;
+            const std::string op = "--" + bench::knobName(i);
+            std::string val;
+            switch (i % 4) {
+            case 0: val = std::to_string(i + 1); break;
+            case 1: val = "true"; break;
+            case 2: val = std::to_string(static_cast<float>(i) / 7); break;
+            case 3: val = "policy-" + std::to_string(i); break;
+            }
+            args.push_back(op); args.push_back(val);
+            rsp += op + " " + val + "\n";
+        }
+        std::vector<char*> argvN;
+        for (auto& a : args) argvN.push_back(a.data());
+        const int argcN = static_cast<int>(argvN.size());
+
+        bench::report("copy argv + findKnob", n, bench::timeit(10, [&](std::size_t){
+            parseCopyFindKnob(argcN, argvN.data(), knobs);
+        }));
+
+        bench::report("OptionParser argv", n, bench::timeit(10, [&](std::size_t){
+            OptionParser parser;
+            bench::keep(parser.parse(argcN, argvN.data(), knobs));
+        }));
+
+        const std::string file = "bench_program_options.rsp";
+        std::ofstream(file) << rsp;
+        char prog[] = "prog", at[] = "@bench_program_options.rsp";
+        char* argvRsp[] = {prog, at};
+        bench::report("OptionParser @responsefile", n, bench::timeit(10, [&](std::size_t){
+            OptionParser parser;
+            bench::keep(parser.parse(2, argvRsp, knobs));
+        }));
+        std::remove(file.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/** Dumping 10k/100k-knob trees: ostream printing vs Serializer.
+ *
+ * Output goes to a file, so `std::endl` flushes are real writes.
+ */
+#include <cstdio>
+#include <fstream>
+
+#include "bench.h"
+#include "../program_options.h"
+
+using namespace knb;
+
+namespace {
+
+/// What printOptions did before Serializer: `std::endl`, `substr` and `asString`.
+void printOstream(const Group& knobs, std::ostream& o, std::size_t width = 50)
+{
+    knobs.visit([&](const Knob& knob) {
+        o << "--";
+        if (Knob::T t=knob.type(); t == Knob::T::String) {o << knob.name() << " [\"" << knob.asString() << "\"]";}
+        else if (t == Knob::T::Bool) {if (!knob.asBool()) {o << "no-";} o << knob.name();}
+        else {o << knob.name() << " [" << knob.asString() << "]";}
+        o << std::endl;
+        for (std::size_t ln = 0, numln=(knob.desc().size()+width)/width; ln < numln; ++ln) {
+            o << "  " << knob.desc().substr(ln*width, width) << std::endl;
+        }
+    });
+}
+
+/// `path = value` lines with ostream and `asString`.
+void keyValueOstream(const Group& knobs, std::ostream& o)
+{
+    for (auto it = knobs.tree().begin(), end = knobs.tree().end(); it != end; ++it) {
+        std::string path;
+        it.appendPath(path);
+        o << path << " = " << it->asString() << '\n';
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string file = "bench_serializer.out";
+
+    for (std::size_t n : {10000, 100000}) {
+        Group knobs("root", false);
+        bench::fillTree(knobs, n);
+
+        {
+            std::ofstream o(file);
+            bench::report("help: ostream + endl", n, bench::timeit(3, [&](std::size_t){
+                printOstream(knobs, o);
+            }));
+        }
+        {
+            std::ofstream o(file);
+            bench::report("help: printOptions", n, bench::timeit(3, [&](std::size_t){
+                printOptions(knobs, o);
+            }));
+        }
+        {
+            std::ofstream o(file);
+            bench::report("key=value: ostream", n, bench::timeit(3, [&](std::size_t){
+                keyValueOstream(knobs, o);
+            }));
+        }
+
+        Serializer s;
+        for (Format f : {Format::KeyValue, Format::Json}) {
+            std::FILE* o = std::fopen(file.c_str(), "w");
+            const std::string what = (f == Format::Json)? "json: Serializer" : "key=value: Serializer";
+            bench::report(what, n, bench::timeit(3, [&](std::size_t){
+                s.dump(knobs, f, o);
+            }));
+            std::fclose(o);
+        }
+
+        std::string buf;
+        bench::report("json: render only, reused buffer", n, bench::timeit(3, [&](std::size_t){
+            buf.clear();
+            serialize(knobs, Format::Json, buf);
+        }));
+    }
+    std::remove(file.c_str());
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/** Startup cost: rebuild Group vs map snapshot file and query in place.
+ */
+#include <cstdio>
+
+#include "bench.h"
+#include "../snapshot.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    const std::string file = "bench_snapshot.knb";
+    for (std::size_t n : {1000, 10000, 100000}) {
+        Group knobs("root");
+        bench::report("Group build", n, bench::timeit(1, [&](std::size_t){
+            bench::fillTree(knobs, n);
+        }));
+        knobs.finalize();
+
+        bench::report("saveSnapshot", n, bench::timeit(1, [&](std::size_t){
+            saveSnapshot(knobs, file);
+        }));
+
+        bench::report("MappedSnapshot verified open + 1 lookup", n, bench::timeit(100, [&](std::size_t i){
+            MappedSnapshot snap(file, true);
+            bench::keep(snap.root().findKnob(bench::knobName(i % n)));
+        }));
+        bench::report("MappedSnapshot open + 1 lookup", n, bench::timeit(100, [&](std::size_t i){
+            MappedSnapshot snap(file);
+            bench::keep(snap.root().findKnob(bench::knobName(i % n)));
+        }));
+
+        MappedSnapshot snap(file);
+        bench::report("SnapshotGroupView::findKnob", n, bench::timeit(100000, [&](std::size_t i){
+            bench::keep(snap.root().findKnob(bench::knobName((i * 7919) % n)));
+        }));
+    }
+    std::remove(file.c_str());
+
+    return 0;
+}
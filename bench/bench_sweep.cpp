@@ -0,0 +1,77 @@
+/** Sweep throughput over threads and memory use, compared with
+ *  copying the Group for each configuration.
+ */
+#include <sys/resource.h>
+
+#include "bench.h"
+#include "../sweep.h"
+
+using namespace knb;
+
+namespace {
+
+long maxRssKiB()
+{
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+/// Stand-in for a small simulation that reads few knobs.
+std::uint64_t simulate(int ways, float ratio, bool prefetch, int max)
+{
+    std::uint64_t x = static_cast<std::uint64_t>(ways) * 2654435761u + max;
+    for (int i = 0; i < 100; ++i) x = detail::mix(x + prefetch) ^ static_cast<std::uint64_t>(ratio * 1000);
+    return x;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    Group base("root");
+    bench::fillTree(base, 10000);
+    base.addKnob("max", 100);
+    base.getGroup("cache").addKnob("ways", 4).addKnob("ratio", 0.5f).addKnob("prefetch", false);
+    base.finalize();
+
+    Sweep sweep(base);
+    sweep.range("cache:ways", 1, 16, 1)
+         .values("cache:prefetch", std::vector<bool>{false, true})
+         .uniform("cache:ratio", 0.0, 1.0)
+         .samples(1 << 15);
+    const std::size_t n = sweep.size();
+
+    std::size_t knobs = 0;
+    base.visit([&](const Knob&){ ++knobs; });
+    std::cout << "base tree of " << knobs << " knobs, " << n << " points, max RSS before "
+              << maxRssKiB() << " KiB" << std::endl;
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= cores; threads *= 2) {
+        std::atomic<std::uint64_t> sum{0};
+        const double ns = bench::timeit(1, [&](std::size_t){
+            sweep.run([&](const SweepPoint& p){
+                sum.fetch_add(simulate(p[0].asInt(), p[2].asFloat(), p[1].asBool(),
+                                       p.at("max").asInt()) & 1, std::memory_order_relaxed);
+            }, threads);
+        });
+        bench::report("Sweep::run threads=" + std::to_string(threads), n, ns / n);
+    }
+    std::cout << "max RSS after sweep " << maxRssKiB() << " KiB" << std::endl;
+
+    // what hand-rolled sweeps do: copy the tree for every configuration
+    const std::size_t copies = 100;
+    SweepPoint p(sweep);
+    bench::report("SweepPoint::group (deep copy)", copies, bench::timeit(copies, [&](std::size_t i){
+        sweep.point(i, p);
+        Group g = p.group();
+        bench::keep(g);
+    }));
+    bench::report("Sweep::point (overlay)", n, bench::timeit(n, [&](std::size_t i){
+        sweep.point(i, p);
+        bench::keep(p);
+    }));
+
+    return 0;
+}
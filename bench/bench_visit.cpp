@@ -0,0 +1,45 @@
+/** Traversal cost per knob: std::function visitor, inlined visitor,
+ *  depth-first iterator and parallel traversal.
+ */
+#include "bench.h"
+#include "../parallel_visit.h"
+
+using namespace knb;
+
+int main(int argc, char* argv[])
+{
+    for (std::size_t n : {10000, 1000000}) {
+        Group knobs("root");
+        bench::fillTree(knobs, n);
+
+        std::size_t sum = 0;
+        const std::function<void(const Knob&)> erased = [&](const Knob& k){ sum += k.typeId(); };
+        bench::report("visit(std::function)", n, bench::autotime([&](std::size_t){
+            knobs.visit(erased);
+        }) / n);
+        bench::report("visit(lambda)", n, bench::autotime([&](std::size_t){
+            knobs.visit([&](const Knob& k){ sum += k.typeId(); });
+        }) / n);
+        bench::report("tree() iterator", n, bench::autotime([&](std::size_t){
+            for (const Knob& k : knobs.tree()) sum += k.typeId();
+        }) / n);
+        std::string path;
+        bench::report("tree() iterator + appendPath", n, bench::autotime([&](std::size_t){
+            for (auto it = knobs.tree().begin(); it != knobs.tree().end(); ++it) {
+                path.clear(); it.appendPath(path); sum += path.size();
+            }
+        }) / n);
+        bench::report("visit, stop at first knob", n, bench::autotime([&](std::size_t){
+            knobs.visit([&](const Knob& k){ sum += k.typeId(); return false; });
+        }));
+        bench::keep(sum);
+
+        std::atomic<std::size_t> psum{0};
+        bench::report("parallelVisit", n, bench::autotime([&](std::size_t){
+            parallelVisit(knobs, [&](const Knob& k){
+                psum.fetch_add(k.typeId(), std::memory_order_relaxed); });
+        }) / n);
+    }
+
+    return 0;
+}
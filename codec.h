@@ -0,0 +1,316 @@
+/**
+ * @file
+ * @brief     Text to value and value to text with `from_chars`/`to_chars`
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Values are parsed without locale or exceptions, numbers without
+ * allocation; whole text must be consumed. Arrays are comma separated,
+ * `1, 2, 4`. Numbers may have a unit suffix:
+ *  - size: `K M G T P` (powers of 1000), `Ki Mi Gi Ti Pi` (powers
+ *    of 1024), optionally followed by `B`: `64KiB`, `1.5G`, `4kB`;
+ *  - time, only for knobs with time unit: `ns us ms s min h`,
+ *    converted to the unit of the knob: `10ms` is 10000 `Microseconds`.
+ *
+ * Errors are returned as `Status` with a static message:
+ * ~~~{.cpp}
+ * int ways;
+ * if (knb::Status st = knb::codec::decode("64Ki", ways, {1, 1 << 20}); not st) {
+ *     std::cerr << st.what();
+ * }
+ * ~~~
+ * Floats are written in the shortest form that reads back exactly.
+ */
+#pragma once
+#ifndef KNOBCPP_CODEC_H_INCLUDED
+#define KNOBCPP_CODEC_H_INCLUDED
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "span.h"
+
+namespace knb {
+
+enum class Unit : std::uint8_t {
+    None,    ///< plain number, size suffixes are multipliers
+    Bytes,
+    Seconds, Milliseconds, Microseconds, Nanoseconds
+};
+
+/// Allowed values of a numeric knob, see `Group::constrain`.
+struct Range
+{
+    double min = -std::numeric_limits<double>::infinity();
+    double max =  std::numeric_limits<double>::infinity();
+    Unit unit = Unit::None;
+
+    bool contains(double v) const {return not (v < min) and not (v > max);}
+};
+
+/// Result of a conversion, `false` on error.
+class Status
+{
+    const char* what_{nullptr};
+
+public:
+    Status() = default;
+    explicit Status(const char* what):what_(what){}
+
+    explicit operator bool() const {return what_ == nullptr;}
+
+    /// Error message, "ok" if there is no error.
+    const char* what() const {return (what_ == nullptr)? "ok" : what_;}
+};
+
+namespace codec {
+
+namespace detail {
+
+/// Nanoseconds in `u` or 0 if `u` is not a time unit.
+constexpr std::int64_t nanoseconds(Unit u)
+{
+    switch (u) {
+    case Unit::Seconds:      return 1000000000;
+    case Unit::Milliseconds: return 1000000;
+    case Unit::Microseconds: return 1000;
+    case Unit::Nanoseconds:  return 1;
+    default:                 return 0;
+    }
+}
+
+/** Value of number text with optional suffix.
+ *
+ * Suffix multiplies mantissa by `num / den`; `integral` tells that
+ * mantissa is in `i`, otherwise it is in `d`.
+ */
+template <typename I>
+struct Number
+{
+    bool integral;
+    I i;
+    double d;
+    std::int64_t num;
+    std::int64_t den;
+    std::size_t length; ///< of mantissa text, without `+`
+    const char* error;
+};
+
+template <typename I>
+Number<I> scan(std::string_view s, Unit unit)
+{
+    Number<I> n{true, 0, 0.0, 1, 1, 0, nullptr};
+    if (s.empty()) { n.error = "empty value"; return n; }
+    if (s.front() == '+') s.remove_prefix(1);
+    const char* first = s.data();
+    const char* last = s.data() + s.size();
+
+    std::from_chars_result res = std::from_chars(first, last, n.i);
+    if (res.ec != std::errc() or
+        (res.ptr != last and (*res.ptr == '.' or *res.ptr == 'e' or *res.ptr == 'E'))) {
+        n.integral = false;
+        res = std::from_chars(first, last, n.d);
+    }
+    if (res.ec == std::errc::result_out_of_range) { n.error = "out of range"; return n; }
+    if (res.ec != std::errc()) { n.error = "not a number"; return n; }
+    n.length = static_cast<std::size_t>(res.ptr - first);
+
+    std::string_view suffix(res.ptr, static_cast<std::size_t>(last - res.ptr));
+    if (suffix.empty()) return n;
+
+    if (const std::int64_t base = nanoseconds(unit); base != 0) {
+        struct { std::string_view name; std::int64_t ns; } const times[] = {
+            {"ns", 1}, {"us", 1000}, {"ms", 1000000}, {"s", 1000000000},
+            {"min", 60000000000}, {"h", 3600000000000}};
+        for (const auto& t : times) {
+            if (suffix == t.name) {
+                n.num = t.ns; n.den = base;
+                if (n.num % n.den == 0) { n.num /= n.den; n.den = 1; }
+                return n;
+            }
+        }
+        n.error = "unknown time unit";
+        return n;
+    }
+
+    if (suffix.back() == 'B') suffix.remove_suffix(1);
+    if (suffix.empty()) return n;
+    const std::string_view prefixes = "KMGTP";
+    auto p = prefixes.find(suffix.front());
+    if (suffix.front() == 'k') p = 0;
+    const bool binary = suffix.size() == 2 and suffix[1] == 'i';
+    if (p == std::string_view::npos or (suffix.size() != 1 and not binary)) {
+        n.error = "unknown unit";
+        return n;
+    }
+    for (std::size_t j = 0; j <= p; ++j) n.num *= binary? 1024 : 1000;
+    return n;
+}
+
+template <typename I>
+Status decodeInteger(std::string_view s, I& v, const Range& r)
+{
+    const Number<I> n = scan<I>(s, r.unit);
+    if (n.error != nullptr) return Status(n.error);
+
+    I x;
+    if (n.integral and n.den == 1) {
+        if (__builtin_mul_overflow(n.i, n.num, &x)) return Status("out of range");
+    } else {
+        const double d = (n.integral? static_cast<double>(n.i) : n.d) * n.num / n.den;
+        if (d != std::trunc(d)) return Status("not an integer");
+        if (not (d >= static_cast<double>(std::numeric_limits<I>::min()) and
+                 d < std::ldexp(1.0, std::numeric_limits<I>::digits))) {
+            return Status("out of range");
+        }
+        x = static_cast<I>(d);
+    }
+    if (not r.contains(static_cast<double>(x))) return Status("outside of knob range");
+    v = x;
+    return {};
+}
+
+template <typename F>
+Status decodeReal(std::string_view s, F& v, const Range& r)
+{
+    const Number<std::int64_t> n = scan<std::int64_t>(s, r.unit);
+    if (n.error != nullptr) return Status(n.error);
+
+    F f;
+    if (n.num == 1 and n.den == 1) {
+        if (s.front() == '+') s.remove_prefix(1);
+        auto [end, ec] = std::from_chars(s.data(), s.data() + n.length, f);
+        if (ec != std::errc() or end != s.data() + n.length) return Status("out of range");
+    } else {
+        const double d = (n.integral? static_cast<double>(n.i) : n.d) * n.num / n.den;
+        if (not (std::abs(d) <= std::numeric_limits<F>::max())) return Status("out of range");
+        f = static_cast<F>(d);
+    }
+    if (not r.contains(f)) return Status("outside of knob range");
+    v = f;
+    return {};
+}
+
+/// Comma separated elements, each in range `r`; empty text is empty array.
+template <typename E>
+Status decodeArray(std::string_view s, Buffer<E>& v, const Range& r)
+{
+    std::vector<E> elems;
+    auto trim = [](std::string_view e) {
+        while (not e.empty() and e.front() == ' ') e.remove_prefix(1);
+        while (not e.empty() and e.back() == ' ') e.remove_suffix(1);
+        return e;
+    };
+    if (not trim(s).empty()) {
+        for (;;) {
+            const auto comma = s.find(',');
+            E e;
+            const std::string_view t = trim(s.substr(0, comma));
+            if constexpr (std::is_integral_v<E>) {
+                if (Status st = decodeInteger(t, e, r); not st) return st;
+            } else {
+                if (Status st = decodeReal(t, e, r); not st) return st;
+            }
+            elems.push_back(e);
+            if (comma == std::string_view::npos) break;
+            s.remove_prefix(comma + 1);
+        }
+    }
+    v = Buffer<E>(elems);
+    return {};
+}
+
+} // namespace detail
+
+/// `true|false|1|0|yes|no|on|off`, empty text is `false`.
+inline Status decode(std::string_view s, bool& v)
+{
+    if (s.empty() or s == "false" or s == "0" or s == "no" or s == "off") { v = false; return {}; }
+    if (s == "true" or s == "1" or s == "yes" or s == "on") { v = true; return {}; }
+    return Status("not a boolean");
+}
+
+/** Integer, checked for overflow of the type.
+ *
+ * Suffixed value must be whole: `1.5K` is 1500, `1.5` is an error.
+ */
+inline Status decode(std::string_view s, int& v, const Range& r = {})
+{
+    return detail::decodeInteger(s, v, r);
+}
+
+inline Status decode(std::string_view s, std::int64_t& v, const Range& r = {})
+{
+    return detail::decodeInteger(s, v, r);
+}
+
+inline Status decode(std::string_view s, std::uint64_t& v, const Range& r = {})
+{
+    return detail::decodeInteger(s, v, r);
+}
+
+/// Float, plain numbers are parsed as float and round-trip exactly.
+inline Status decode(std::string_view s, float& v, const Range& r = {})
+{
+    return detail::decodeReal(s, v, r);
+}
+
+inline Status decode(std::string_view s, double& v, const Range& r = {})
+{
+    return detail::decodeReal(s, v, r);
+}
+
+/// Array like `1, 2, 4KiB`, `Range` applies to each element.
+inline Status decode(std::string_view s, Buffer<std::int64_t>& v, const Range& r = {})
+{
+    return detail::decodeArray(s, v, r);
+}
+
+inline Status decode(std::string_view s, Buffer<double>& v, const Range& r = {})
+{
+    return detail::decodeArray(s, v, r);
+}
+
+/// Append `v` to `out`, floats in shortest round-trip form.
+template <typename N>
+void append(std::string& out, N v)
+{
+    char buf[32];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, (ec == std::errc())? end : buf);
+}
+
+inline void append(std::string& out, bool v) { out += v? "true" : "false"; }
+
+/// Elements separated by `,`, text that `decode` reads back.
+template <typename E>
+void append(std::string& out, Span<const E> v)
+{
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        if (i != 0) out += ',';
+        append(out, v[i]);
+    }
+}
+
+template <typename E>
+void append(std::string& out, const Buffer<E>& v) { append(out, v.span()); }
+
+/// Text of `v`, see `append`.
+template <typename N>
+std::string encode(const N& v)
+{
+    std::string s;
+    append(s, v);
+    return s;
+}
+
+} // namespace codec
+
+}
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file
+ * @brief     Load knobs from INI-style configuration file
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Real deployments keep hundreds or thousands of knobs in files.
+ * File format:
+ * ~~~
+ * # comment, lines starting with ';' are comments too
+ * version = "1.2.3"
+ * max = 100
+ *
+ * [feature-A]          # group path relative to the root
+ * A-val1 = 345
+ *
+ * [feature-A:A-X]
+ * A-X-val2 = 987
+ * ratio    = 0.25
+ * enabled  = true
+ * policy   = lru       # bare word is a string
+ * ~~~
+ *
+ * Input is tokenized in place with `string_view`s, numbers are converted
+ * with `std::from_chars`, Group is filled directly, no intermediate tree.
+ * Files are read in chunks, so file size is not limited by buffer size.
+ *
+ * If a knob already exists, it is changed with `Group::changeValue` of the
+ * root: the value is converted to the type of the knob, with units and the
+ * knob range, live readers see it, immutable tree keeps its values.
+ * Otherwise type of a new knob is deduced from the value:
+ * `true|false` is Bool, integer is Int (Int64 if it does not fit),
+ * number with `.` or exponent is Float, anything else is String.
+ * Value in double quotes is a string that may contain `#`, `;` and
+ * escapes `\"`, `\\`, `\n`, `\r`, `\t`.
+ */
+#pragma once
+#ifndef KNOBCPP_CONFIG_FILE_H_INCLUDED
+#define KNOBCPP_CONFIG_FILE_H_INCLUDED
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "knob.h"
+
+namespace knb {
+
+/** Incremental tokenizer of INI-style text.
+ *
+ * Text is fed in chunks of any size; only a line that crosses chunk
+ * boundary is copied. Handler receives views that are valid during
+ * the call:
+ *  - `h.section(line, path)` for `[path]`,
+ *  - `h.value(line, key, value)` for `key = value`,
+ *  - `h.error(line, what)` for malformed lines.
+ */
+class ConfigReader
+{
+    std::string carry_;
+    std::size_t line_{0};
+
+public:
+    template <typename Handler>
+    void feed(strv chunk, Handler& h)
+    {
+        if (not carry_.empty()) {
+            const char* nl = static_cast<const char*>(std::memchr(chunk.data(), '\n', chunk.size()));
+            if (nl == nullptr) { carry_.append(chunk); return; }
+            const std::size_t n = static_cast<std::size_t>(nl - chunk.data());
+            carry_.append(chunk.data(), n);
+            parseLine(carry_, h);
+            carry_.clear();
+            chunk.remove_prefix(n + 1);
+        }
+        while (not chunk.empty()) {
+            const char* nl = static_cast<const char*>(std::memchr(chunk.data(), '\n', chunk.size()));
+            if (nl == nullptr) { carry_.assign(chunk); return; }
+            const std::size_t n = static_cast<std::size_t>(nl - chunk.data());
+            parseLine(chunk.substr(0, n), h);
+            chunk.remove_prefix(n + 1);
+        }
+    }
+
+    /// End of input, parse last line if it has no `\n`.
+    template <typename Handler>
+    void finish(Handler& h)
+    {
+        if (not carry_.empty()) { parseLine(carry_, h); carry_.clear(); }
+    }
+
+    static strv trim(strv s)
+    {
+        while (not s.empty() and (s.front() == ' ' or s.front() == '\t')) s.remove_prefix(1);
+        while (not s.empty() and (s.back() == ' ' or s.back() == '\t' or s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+private:
+    /// Cut comment that starts with `#` or `;` outside of quotes.
+    static strv uncomment(strv s)
+    {
+        bool quoted = false;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == '"') quoted = not quoted;
+            else if (quoted and s[i] == '\\') ++i; // escaped character
+            else if (not quoted and (s[i] == '#' or s[i] == ';')) return s.substr(0, i);
+        }
+        return s;
+    }
+
+    template <typename Handler>
+    void parseLine(strv ln, Handler& h)
+    {
+        ++line_;
+        ln = trim(uncomment(ln));
+        if (ln.empty()) return;
+        if (ln.front() == '[') {
+            if (ln.back() != ']') { h.error(line_, "section without closing ']'"); return; }
+            h.section(line_, trim(ln.substr(1, ln.size() - 2)));
+            return;
+        }
+        const auto eq = ln.find('=');
+        if (eq == strv::npos) { h.error(line_, "expected 'name = value'"); return; }
+        const strv key = trim(ln.substr(0, eq));
+        if (key.empty()) { h.error(line_, "empty knob name"); return; }
+        h.value(line_, key, trim(ln.substr(eq + 1)));
+    }
+};
+
+/// ConfigReader handler that adds knobs to Group.
+class ConfigLoader
+{
+    Group& root_;
+    Group* section_;
+    std::vector<std::string> errors_;
+
+public:
+    explicit ConfigLoader(Group& root):root_(root),section_(&root){}
+
+    const std::vector<std::string>& errors() const {return errors_;}
+
+    void error(std::size_t line, const std::string& what)
+    {
+        errors_.push_back("line " + std::to_string(line) + ": " + what);
+    }
+
+    void section(std::size_t, strv path)
+    {
+        section_ = &resolve(root_, path);
+    }
+
+    void value(std::size_t line, strv key, strv val)
+    {
+        Group* g = section_;
+        if (auto pos = key.rfind(':'); pos != strv::npos) {
+            g = &resolve(*g, key.substr(0, pos));
+            key.remove_prefix(pos + 1);
+        }
+
+        const bool quoted = val.size() >= 2 and val.front() == '"' and val.back() == '"';
+        std::string unescaped;
+        if (quoted) {
+            val = val.substr(1, val.size() - 2);
+            if (val.find('\\') != strv::npos) val = unescaped = unescape(val);
+        }
+
+        if (const Knob* old = g->find(key); old != nullptr) {
+            set(line, *old, val);
+        } else if (quoted) {
+            g->addKnob(key, std::string(val));
+        } else if (val == "true" or val == "false") {
+            g->addKnob(key, val == "true");
+        } else if (int i; parse(val, i)) {
+            g->addKnob(key, i);
+        } else if (std::int64_t i64; parse(val, i64)) {
+            g->addKnob(key, i64);
+        } else if (float f; val.find_first_of(".eE") != strv::npos and parse(val, f)) {
+            g->addKnob(key, f);
+        } else {
+            g->addKnob(key, std::string(val));
+        }
+    }
+
+    /// Replace escapes of quoted value `\"`, `\\`, `\n`, `\r`, `\t` with characters.
+    static std::string unescape(strv s)
+    {
+        std::string out;
+        out.reserve(s.size());
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            if (s[i] != '\\' or i + 1 == s.size()) { out += s[i]; continue; }
+            switch (const char c = s[++i]; c) {
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            default:  out += c; break;
+            }
+        }
+        return out;
+    }
+
+    /// Parse whole string as number with `std::from_chars`.
+    template <typename N>
+    static bool parse(strv s, N& n)
+    {
+        if (not s.empty() and s.front() == '+') s.remove_prefix(1);
+        auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), n);
+        return ec == std::errc() and end == s.data() + s.size() and not s.empty();
+    }
+
+private:
+    static Group& resolve(Group& from, strv path)
+    {
+        Group* g = &from;
+        while (not path.empty()) {
+            auto pos = path.find(':');
+            g = &g->getGroup(ConfigReader::trim(path.substr(0, pos)));
+            path = (pos == strv::npos)? strv() : path.substr(pos + 1);
+        }
+        return *g;
+    }
+
+    void set(std::size_t line, const Knob& old, strv val)
+    {
+        // checks range, updates live readers and fingerprints
+        if (const Status st = root_.changeValue(&old, val); not st) {
+            error(line, (st.what() == Group::immutableError)?
+                "can't change knob '" + std::string(old.name()) + "': " + st.what() :
+                "can't convert '" + std::string(val) + "' to type of knob '" +
+                std::string(old.name()) + "': " + st.what());
+        }
+    }
+};
+
+/** Load knobs from configuration text, for example `mmap`ed file.
+ *
+ * @return tuple<ok,error-messages>
+ */
+inline
+std::tuple<bool,std::vector<std::string> >
+loadConfig(strv text, Group& knobs)
+{
+    ConfigReader reader;
+    ConfigLoader loader(knobs);
+    reader.feed(text, loader);
+    reader.finish(loader);
+    return std::make_tuple(loader.errors().empty(), loader.errors());
+}
+
+/** Load knobs from configuration file, reading it in chunks.
+ *
+ * @return tuple<ok,error-messages>
+ */
+inline
+std::tuple<bool,std::vector<std::string> >
+loadConfigFile(const std::string& path, Group& knobs, std::size_t bufferSize = 1 << 20)
+{
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+    if (not f) return std::make_tuple(false, std::vector<std::string>{"can't open " + path});
+
+    std::unique_ptr<char[]> buf(new char[bufferSize]);
+    ConfigReader reader;
+    ConfigLoader loader(knobs);
+    while (std::size_t n = std::fread(buf.get(), 1, bufferSize, f.get())) {
+        reader.feed(strv(buf.get(), n), loader);
+    }
+    reader.finish(loader);
+    if (std::ferror(f.get())) loader.error(0, "can't read " + path);
+    return std::make_tuple(loader.errors().empty(), loader.errors());
+}
+
+}
+
+#endif
@@ -0,0 +1,212 @@
+/**
+ * @file
+ * @brief     ConfigHandle - live configuration reload with RCU-style snapshots
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Long-running services reload configuration without restart.
+ * Mutating a Group that other threads read is a data race, so instead
+ * each configuration is an immutable snapshot, a new snapshot is
+ * published by swapping a pointer, and the old one is deleted when
+ * no reader can see it anymore (epoch-based reclamation).
+ *
+ * ~~~{.cpp}
+ * knb::ConfigHandle config(std::move(knobs));
+ *
+ * // reader thread
+ * knb::ConfigHandle::Reader reader(config);
+ * for (;;) {
+ *     auto cfg = reader.read();   // wait-free, no mutex, no refcount
+ *     use(cfg->at("max").asInt());
+ * }                               // snapshot is released here
+ *
+ * // writer thread
+ * config.publish(std::move(newKnobs));
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_CONFIG_HANDLE_H_INCLUDED
+#define KNOBCPP_CONFIG_HANDLE_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "knob.h"
+
+namespace knb {
+
+/** Publishes immutable Group snapshots, readers see them lock-free.
+ *
+ * Each reader thread owns a Reader that has its own cache line with
+ * the epoch the reader entered its critical section at. Read side
+ * writes only to that line and reads the shared epoch and snapshot
+ * pointer, which change only on publish. Writers are serialized with
+ * a mutex; a replaced snapshot is retired with the current epoch and
+ * deleted once every active reader has entered at a later epoch.
+ *
+ * All Readers must be destroyed before the ConfigHandle.
+ */
+class ConfigHandle
+{
+    /// Epoch of a reader, `0` means not reading.
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch{0};
+        bool used{true};
+    };
+
+    struct Retired {
+        std::uint64_t epoch;
+        std::unique_ptr<const Group> group;
+    };
+
+    alignas(64) std::atomic<const Group*> current_;
+    alignas(64) std::atomic<std::uint64_t> epoch_{1};
+    mutable std::mutex mutex_; ///< writers and Reader registration
+    std::deque<Slot> slots_;
+    std::vector<Retired> retired_;
+    std::uint64_t version_{0};
+
+public:
+    class Reader;
+
+    /// Snapshot of configuration, valid while this object lives.
+    class Snapshot
+    {
+        Reader* reader_{nullptr};
+        const Group* group_{nullptr};
+
+        friend class Reader;
+        Snapshot(Reader* reader, const Group* group):reader_(reader),group_(group){}
+    public:
+        Snapshot(Snapshot&& other) noexcept:reader_(other.reader_),group_(other.group_) {
+            other.reader_ = nullptr;
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot() { if (reader_ != nullptr) reader_->leave(); }
+
+        const Group& operator*() const {return *group_;}
+        const Group* operator->() const {return group_;}
+        const Group& get() const {return *group_;}
+    };
+
+    /// Read side of ConfigHandle, one per thread.
+    class Reader
+    {
+        ConfigHandle& handle_;
+        Slot& slot_;
+        const Group* group_{nullptr};
+        unsigned nesting_{0};
+
+        friend class Snapshot;
+    public:
+        explicit Reader(ConfigHandle& handle):handle_(handle),slot_(handle.acquireSlot()){}
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader() { handle_.releaseSlot(slot_); }
+
+        /** Enter critical section and get current snapshot, wait-free.
+         *
+         * Nested reads on the same Reader see the same snapshot.
+         */
+        Snapshot read()
+        {
+            if (nesting_++ == 0) {
+                // seq_cst: announcement must be visible before the pointer is read
+                slot_.epoch.store(handle_.epoch_.load(std::memory_order_seq_cst),
+                                  std::memory_order_seq_cst);
+                group_ = handle_.current_.load(std::memory_order_seq_cst);
+            }
+            return Snapshot(this, group_);
+        }
+
+    private:
+        void leave()
+        {
+            if (--nesting_ == 0) slot_.epoch.store(0, std::memory_order_release);
+        }
+    };
+
+    explicit ConfigHandle(Group initial):current_(adopt(std::move(initial))){}
+    ConfigHandle(const ConfigHandle&) = delete;
+    ConfigHandle& operator=(const ConfigHandle&) = delete;
+
+    ~ConfigHandle() { delete current_.load(); }
+
+    /** Make `next` the current configuration.
+     *
+     * `next` is finalized and its derived knobs are computed before
+     * readers can see it. Readers that already hold a snapshot keep
+     * using the old one, it is deleted by this or a later `publish`
+     * or `collect`.
+     */
+    void publish(Group next)
+    {
+        const Group* group = adopt(std::move(next));
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Group* old = current_.exchange(group, std::memory_order_seq_cst);
+        retired_.push_back({epoch_.fetch_add(1, std::memory_order_seq_cst),
+                            std::unique_ptr<const Group>(old)});
+        ++version_;
+        reclaim();
+    }
+
+    /// Delete retired snapshots that no reader can see, return how many left.
+    std::size_t collect()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reclaim();
+        return retired_.size();
+    }
+
+    /// Number of `publish` calls.
+    std::uint64_t version() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return version_;
+    }
+
+private:
+    static const Group* adopt(Group g)
+    {
+        g.finalize();
+        const Group* published = new Group(std::move(g));
+        published->evaluate(); // readers of derived knobs never take the evaluation lock
+        return published;
+    }
+
+    Slot& acquireSlot()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Slot& s : slots_) {
+            if (not s.used) { s.used = true; return s; }
+        }
+        return slots_.emplace_back();
+    }
+
+    void releaseSlot(Slot& slot)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot.epoch.store(0, std::memory_order_release);
+        slot.used = false;
+    }
+
+    /// A snapshot retired at epoch `e` is unreachable when all readers entered after `e`.
+    void reclaim()
+    {
+        std::uint64_t oldest = UINT64_MAX;
+        for (const Slot& s : slots_) {
+            const std::uint64_t e = s.epoch.load(std::memory_order_seq_cst);
+            if (e != 0 and e < oldest) oldest = e;
+        }
+        retired_.erase(std::remove_if(std::begin(retired_), std::end(retired_),
+            [oldest](const Retired& r){return r.epoch < oldest;}), std::end(retired_));
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief     StructBinding - fill plain config struct from Group
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Hot code is best served by ordinary struct fields, not by name
+ * lookup and variant access. StructBinding describes which knob
+ * goes to which field, then copies the whole struct from a finalized
+ * Group in one pass:
+ * ~~~{.cpp}
+ * struct CacheCfg { int ways = 8; bool prefetch = true; float ratio = 0.5f; std::string policy = "lru"; };
+ *
+ * const auto binding = knb::StructBinding<CacheCfg>()
+ *     .field("cache:ways",     &CacheCfg::ways,     "Number of ways")
+ *     .field("cache:prefetch", &CacheCfg::prefetch, "Enable prefetcher")
+ *     .field("cache:ratio",    &CacheCfg::ratio)
+ *     .field("cache:policy",   &CacheCfg::policy,   "Replacement policy");
+ *
+ * binding.addKnobs(knobs);             // knobs with struct defaults
+ * knb::parseOptions(argc, argv, knobs);
+ * knobs.finalize();
+ * CacheCfg cfg = binding.load(knobs);  // throws listing all mismatches
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_CONFIG_STRUCT_H_INCLUDED
+#define KNOBCPP_CONFIG_STRUCT_H_INCLUDED
+
+#include "knob.h"
+
+namespace knb {
+
+/** Description of fields of struct `S`, each bound to a knob path.
+ *
+ * Field type must match the knob type exactly, see `Knob::T`;
+ * array knobs are bound to `std::vector` fields.
+ */
+template <typename S>
+class StructBinding
+{
+    /// Alternative index is `Knob::T` of the knob.
+    using Member = std::variant<bool S::*, int S::*, float S::*, std::string S::*,
+                                std::int64_t S::*, std::uint64_t S::*, double S::*,
+                                std::vector<std::int64_t> S::*, std::vector<double> S::*>;
+
+    struct Field {
+        std::string path; ///< relative to the group given to `load`
+        std::string desc;
+        Member member;
+    };
+
+    std::vector<Field> fields_;
+
+public:
+    template <typename T>
+    StructBinding& field(strv path, T S::* member, strv desc = "") {
+        static_assert(std::is_constructible_v<Member,T S::*>,
+                      "field type is a Knob::T type or std::vector of array element");
+        fields_.push_back(Field{std::string(path), std::string(desc), member});
+        return *this;
+    }
+
+    std::size_t size() const {return fields_.size();}
+
+    /** Copy knob values to fields of `s`.
+     *
+     * All fields are checked, then `std::invalid_argument` lists every
+     * missing knob and type mismatch, one per line; `s` is not changed
+     * if there is an error.
+     */
+    void load(const Group& knobs, S& s) const
+    {
+        std::string errors;
+        std::vector<const Knob*> found(fields_.size(), nullptr);
+        for (std::size_t i = 0; i < fields_.size(); ++i) {
+            const Field& f = fields_[i];
+            try { found[i] = &knobs.atPath(f.path); }
+            catch (const std::out_of_range&) {
+                errors += "\n  " + f.path + ": no such knob";
+                continue;
+            }
+            if (found[i]->typeId() != f.member.index()) {
+                errors += "\n  " + f.path + ": knob type id " + std::to_string(found[i]->typeId()) +
+                          ", field type id " + std::to_string(f.member.index());
+            }
+        }
+        if (not errors.empty()) {
+            throw std::invalid_argument("knb::StructBinding::load: can't bind group '" +
+                                        std::string(knobs.name()) + "':" + errors);
+        }
+        for (std::size_t i = 0; i < fields_.size(); ++i) {
+            const Knob& k = *found[i];
+            std::visit([&](auto m){
+                using T = std::decay_t<decltype(s.*m)>;
+                if constexpr (std::is_same_v<T,std::vector<std::int64_t>> or
+                              std::is_same_v<T,std::vector<double>>) {
+                    s.*m = k.bind<Buffer<typename T::value_type>>()->toVector();
+                } else {
+                    s.*m = *k.bind<T>();
+                }
+            }, fields_[i].member);
+        }
+    }
+
+    /// Struct with default field values overwritten by knob values.
+    S load(const Group& knobs) const {
+        S s{};
+        load(knobs, s);
+        return s;
+    }
+
+    /** Add knobs with field values of `defaults` as knob values.
+     *
+     * Groups on the paths are created, existing knobs are not changed.
+     * Then `printOptions(knobs)` prints help for the struct.
+     */
+    void addKnobs(Group& knobs, const S& defaults = S{}) const
+    {
+        for (const Field& f : fields_) {
+            Group* g = &knobs;
+            strv path = f.path;
+            for (auto pos = path.find(':'); pos != strv::npos; pos = path.find(':')) {
+                g = &g->getGroup(path.substr(0, pos));
+                path.remove_prefix(pos + 1);
+            }
+            std::visit([&](auto m){ g->addKnob(path, defaults.*m, f.desc); }, f.member);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief     Paths of knobs that differ between two configuration trees
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * ~~~{.cpp}
+ * for (const std::string& path : knb::diff(baseline, experiment)) {
+ *     std::cout << path << "\n";   // "cache:ways"
+ * }
+ * ~~~
+ * Groups are walked side by side in name order; groups at the same
+ * path with equal fingerprints are skipped without looking at their
+ * knobs, so diff of two large trees that differ in a few knobs
+ * touches only the groups on the way to those knobs.
+ */
+#pragma once
+#ifndef KNOBCPP_DIFF_H_INCLUDED
+#define KNOBCPP_DIFF_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "knob.h"
+
+namespace knb {
+
+namespace detail {
+
+/// Add paths of all knobs of sub-tree `g` to `out`.
+inline void diffAll(const Group& g, const std::string& prefix, std::vector<std::string>& out)
+{
+    for (auto it = g.tree().begin(), end = g.tree().end(); it != end; ++it) {
+        out.push_back(prefix);
+        it.appendPath(out.back());
+    }
+}
+
+inline void diffGroups(const Group& a, const Group& b, const std::string& prefix,
+                       std::vector<std::string>& out)
+{
+    if (a.fingerprint() == b.fingerprint()) return;
+
+    auto ka = a.knobs().begin(), kb = b.knobs().begin();
+    const auto ea = a.knobs().end(), eb = b.knobs().end();
+    while (ka != ea or kb != eb) {
+        if (kb == eb or (ka != ea and ka->name() < kb->name())) {
+            out.push_back(prefix + std::string(ka->name())); ++ka;
+        } else if (ka == ea or kb->name() < ka->name()) {
+            out.push_back(prefix + std::string(kb->name())); ++kb;
+        } else {
+            const strv name = ka->name();
+            const bool differ = (a.isDerived(name) or b.isDerived(name))?
+                a.knobFingerprint(name, *ka) != b.knobFingerprint(name, *kb) : *ka != *kb;
+            if (differ) out.push_back(prefix + std::string(name));
+            ++ka; ++kb;
+        }
+    }
+
+    auto ga = a.groups().begin(), gb = b.groups().begin();
+    const auto fa = a.groups().end(), fb = b.groups().end();
+    while (ga != fa or gb != fb) {
+        if (gb == fb or (ga != fa and ga->name() < gb->name())) {
+            diffAll(*ga, prefix + std::string(ga->name()) + ':', out); ++ga;
+        } else if (ga == fa or gb->name() < ga->name()) {
+            diffAll(*gb, prefix + std::string(gb->name()) + ':', out); ++gb;
+        } else {
+            diffGroups(*ga, *gb, prefix + std::string(ga->name()) + ':', out);
+            ++ga; ++gb;
+        }
+    }
+}
+
+} // namespace detail
+
+/** Paths, relative to `a` and `b`, of knobs that are not the same in both.
+ *
+ * Knob is listed if it is only in one tree or has a different type
+ * or value; paths are in `Group::visit` order. Derived knobs count
+ * by how they are computed: one that follows a changed input is not
+ * listed, the input is.
+ */
+inline std::vector<std::string> diff(const Group& a, const Group& b)
+{
+    std::vector<std::string> out;
+    detail::diffGroups(a, b, "", out);
+    return out;
+}
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @brief     dispatch - turn runtime knob value into compile time constant
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * StaticKnob and `if constexpr` specialize code for values known
+ * at build time. Runtime knobs often take one of a few values too,
+ * then the hot kernel can be instantiated for each of them and the
+ * right instantiation is selected once, outside of the inner loop:
+ * ~~~{.cpp}
+ * knb::dispatch<1,2,4,8>(group.at("ways"), [&](auto ways) {
+ *     for (...) { kernel<ways>(...); } // `ways` is std::integral_constant
+ * });
+ * ~~~
+ * Choices are `bool`, integer (matches Int, Int64 and UInt64 knobs)
+ * or `const char*` constants; string choices must be named arrays
+ * with static storage:
+ * ~~~{.cpp}
+ * static constexpr char lru[] = "lru", fifo[] = "fifo";
+ * knb::dispatch<lru,fifo>(group.at("policy"), [&](auto policy) {
+ *     if constexpr (policy() == lru) {...}
+ * });
+ * ~~~
+ * Several knobs select instantiation from cartesian product of choices:
+ * ~~~{.cpp}
+ * using namespace knb;
+ * dispatch<Choices<1,2,4,8>, Choices<false,true>>(std::tie(ways, prefetch),
+ *     [&](auto ways, auto prefetch) {...});
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_DISPATCH_H_INCLUDED
+#define KNOBCPP_DISPATCH_H_INCLUDED
+
+#include <type_traits>
+
+#include "knob.h"
+
+namespace knb {
+
+/// Set of values for one knob in multi-knob `dispatch`.
+template <auto... Vs>
+struct Choices {};
+
+namespace detail {
+
+/// Integers are equal, like C++20 `std::cmp_equal`.
+template <typename A, typename B>
+constexpr bool cmpEqual(A a, B b)
+{
+    if constexpr (std::is_signed_v<A> == std::is_signed_v<B>) return a == b;
+    else if constexpr (std::is_signed_v<A>) return a >= 0 and std::make_unsigned_t<A>(a) == b;
+    else return b >= 0 and a == std::make_unsigned_t<B>(b);
+}
+
+template <auto V>
+bool dispatchMatch(const Knob& k)
+{
+    using V_t = decltype(V);
+    if constexpr (std::is_same_v<V_t,bool>) {
+        return k.type() == Knob::T::Bool and k.asBool() == V;
+    } else if constexpr (std::is_integral_v<V_t>) {
+        switch (k.type()) {
+        case Knob::T::Int:    return cmpEqual(k.asInt(), V);
+        case Knob::T::Int64:  return cmpEqual(k.asInt64(), V);
+        case Knob::T::UInt64: return cmpEqual(k.asUInt64(), V);
+        default:              return false;
+        }
+    } else {
+        static_assert(std::is_same_v<V_t,const char*>,
+                      "dispatch choice is bool, integer or const char*");
+        return k.type() == Knob::T::String and *k.bind<std::string>() == strv(V);
+    }
+}
+
+template <auto V>
+std::string dispatchChoice()
+{
+    using V_t = decltype(V);
+    if constexpr (std::is_same_v<V_t,bool>) return V? "true" : "false";
+    else if constexpr (std::is_integral_v<V_t>) return std::to_string(V);
+    else return "\"" + std::string(V) + "\"";
+}
+
+template <auto... Vs>
+[[noreturn]] void dispatchFail(const Knob& k)
+{
+    std::string choices;
+    ((choices += (choices.empty()? "" : ", ") + dispatchChoice<Vs>()), ...);
+    throw std::invalid_argument("knb::dispatch: knob '" + std::string(k.name()) +
+        "' value " + k.asString() + " (type id " + std::to_string(k.typeId()) +
+        ") is not one of {" + choices + "}");
+}
+
+template <auto V, auto... Vs, typename F>
+decltype(auto) dispatchOne(const Knob& k, F& f)
+{
+    if (dispatchMatch<V>(k)) return f(std::integral_constant<decltype(V),V>{});
+    if constexpr (sizeof...(Vs) != 0) return dispatchOne<Vs...>(k, f);
+    else return f(std::integral_constant<decltype(V),V>{}); // not reached
+}
+
+template <typename C>
+struct Dispatcher;
+
+template <auto... Vs>
+struct Dispatcher<Choices<Vs...>>
+{
+    template <typename F>
+    static decltype(auto) call(const Knob& k, F& f)
+    {
+        if (not (dispatchMatch<Vs>(k) or ...)) dispatchFail<Vs...>(k);
+        return dispatchOne<Vs...>(k, f);
+    }
+};
+
+template <typename C, typename... Cs, typename F, typename K, typename... Ks>
+decltype(auto) dispatchMany(F& f, const K& k, const Ks&... ks)
+{
+    if constexpr (sizeof...(Cs) == 0) {
+        return Dispatcher<C>::call(k, f);
+    } else {
+        auto bindFirst = [&](auto v) -> decltype(auto) {
+            auto rest = [&](auto... vs) -> decltype(auto) {return f(v, vs...);};
+            return dispatchMany<Cs...>(rest, ks...);
+        };
+        return Dispatcher<C>::call(k, bindFirst);
+    }
+}
+
+} // namespace detail
+
+/** Call `f(std::integral_constant<.., V>{})` where `V` is the knob value.
+ *
+ * `f` is instantiated for every choice and all instantiations must
+ * return the same type. Throws `std::invalid_argument` if knob value
+ * is not among `Vs`.
+ */
+template <auto... Vs, typename F>
+decltype(auto) dispatch(const Knob& k, F&& f)
+{
+    static_assert(sizeof...(Vs) != 0, "dispatch needs at least one choice");
+    return detail::Dispatcher<Choices<Vs...>>::call(k, f);
+}
+
+/** Call `f(v1, v2, ...)` with constants for values of several knobs.
+ *
+ * `f` is instantiated for every combination of choices.
+ */
+template <typename... Cs, typename F, typename... Ks>
+decltype(auto) dispatch(const std::tuple<Ks&...>& knobs, F&& f)
+{
+    static_assert(sizeof...(Cs) == sizeof...(Ks), "one Choices<> per knob");
+    return std::apply([&](const auto&... ks) -> decltype(auto) {
+        return detail::dispatchMany<Cs...>(f, ks...);
+    }, knobs);
+}
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief     Arithmetic expressions over knob paths, for derived knobs
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Expression like `size / (ways * line)` is compiled once into
+ * a postfix program and evaluated without allocation:
+ *  - operators `+ - * / %`, unary `-`, parentheses;
+ *  - numbers are read by `codec::decode`, so `64KiB` and `1e-3` work;
+ *  - any other word is a knob path, like `cache:line-size`; since
+ *    names may have `-`, binary minus is written with spaces: `a - b`.
+ *
+ * Integer expressions use 64-bit integer arithmetic, `/` truncates;
+ * floating point expressions use `double`.
+ */
+#pragma once
+#ifndef KNOBCPP_EXPRESSION_H_INCLUDED
+#define KNOBCPP_EXPRESSION_H_INCLUDED
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "codec.h"
+
+namespace knb {
+
+namespace detail {
+
+/// Compiled expression, `N` is `std::int64_t` or `double`.
+template <typename N>
+class Expression
+{
+    static_assert(std::is_same_v<N,std::int64_t> or std::is_same_v<N,double>,
+                  "expression is evaluated in int64_t or double");
+
+    enum class Op : std::uint8_t { Number, Input, Neg, Add, Sub, Mul, Div, Mod };
+    struct Step { Op op; std::size_t input; N value; };
+
+    std::vector<Step> program_;
+    std::vector<std::string> inputs_;
+    std::size_t depth_{0};     ///< max stack depth of the program
+
+    std::string_view text_;    ///< valid only while compiling
+    std::size_t pos_{0};
+
+public:
+    /// Compile `text`, throw `std::invalid_argument` on syntax error.
+    explicit Expression(std::string_view text):text_(text) {
+        parseSum();
+        skipSpaces();
+        if (pos_ != text_.size()) fail("unexpected text");
+        std::size_t d = 0;
+        for (const Step& s : program_) {
+            d = (s.op == Op::Number or s.op == Op::Input)? d + 1 : (s.op == Op::Neg)? d : d - 1;
+            depth_ = std::max(depth_, d);
+        }
+        text_ = {};
+    }
+
+    /// Knob paths the expression reads, in order of first use.
+    const std::vector<std::string>& inputs() const {return inputs_;}
+
+    /// Value for values of `inputs()`; integer division by zero throws `std::domain_error`.
+    N eval(const N* inputs) const {
+        N small[16]{};
+        std::vector<N> large(depth_ > 16? depth_ : 0);
+        N* stack = large.empty()? small : large.data();
+        std::size_t top = 0;
+        for (const Step& s : program_) {
+            switch (s.op) {
+            case Op::Number: stack[top++] = s.value; break;
+            case Op::Input:  stack[top++] = inputs[s.input]; break;
+            case Op::Neg:    stack[top - 1] = -stack[top - 1]; break;
+            default: {
+                const N b = stack[--top];
+                N& a = stack[top - 1];
+                switch (s.op) {
+                case Op::Add: a = a + b; break;
+                case Op::Sub: a = a - b; break;
+                case Op::Mul: a = a * b; break;
+                case Op::Div:
+                    if constexpr (std::is_integral_v<N>) {
+                        if (b == 0) throw std::domain_error("knb::Expression: division by zero");
+                    }
+                    a = a / b;
+                    break;
+                default:
+                    if constexpr (std::is_integral_v<N>) {
+                        if (b == 0) throw std::domain_error("knb::Expression: division by zero");
+                        a = a % b;
+                    } else {
+                        a = std::fmod(a, b);
+                    }
+                    break;
+                }
+            }
+            }
+        }
+        return stack[0];
+    }
+
+private:
+    [[noreturn]] void fail(const char* why) const {
+        throw std::invalid_argument("knb::Expression: " + std::string(why) + " at " +
+            std::to_string(pos_) + " in '" + std::string(text_) + "'");
+    }
+
+    void skipSpaces() {
+        while (pos_ < text_.size() and text_[pos_] == ' ') ++pos_;
+    }
+
+    bool accept(char c) {
+        skipSpaces();
+        if (pos_ < text_.size() and text_[pos_] == c) { ++pos_; return true; }
+        return false;
+    }
+
+    void emit(Op op) {program_.push_back(Step{op, 0, N()});}
+
+    void parseSum() {
+        parseProduct();
+        for (;;) {
+            if (accept('+')) { parseProduct(); emit(Op::Add); }
+            else if (accept('-')) { parseProduct(); emit(Op::Sub); }
+            else return;
+        }
+    }
+
+    void parseProduct() {
+        parseUnary();
+        for (;;) {
+            if (accept('*')) { parseUnary(); emit(Op::Mul); }
+            else if (accept('/')) { parseUnary(); emit(Op::Div); }
+            else if (accept('%')) { parseUnary(); emit(Op::Mod); }
+            else return;
+        }
+    }
+
+    void parseUnary() {
+        if (accept('-')) { parseUnary(); emit(Op::Neg); return; }
+        if (accept('(')) {
+            parseSum();
+            if (not accept(')')) fail("expected ')'");
+            return;
+        }
+        skipSpaces();
+        if (pos_ == text_.size()) fail("expected a number or a knob");
+        const unsigned char c = static_cast<unsigned char>(text_[pos_]);
+        if (std::isdigit(c) or c == '.') {
+            const std::size_t begin = pos_;
+            for (; pos_ < text_.size(); ++pos_) {
+                const unsigned char x = static_cast<unsigned char>(text_[pos_]);
+                const bool exponent = (x == '-' or x == '+') and (text_[pos_ - 1] | 0x20) == 'e';
+                if (not std::isalnum(x) and x != '.' and not exponent) break;
+            }
+            const std::string_view num = text_.substr(begin, pos_ - begin);
+            N v;
+            if (Status st = codec::decode(num, v); not st) fail(st.what());
+            program_.push_back(Step{Op::Number, 0, v});
+        } else if (std::isalpha(c) or c == '_') {
+            const std::size_t begin = pos_;
+            for (; pos_ < text_.size(); ++pos_) {
+                const unsigned char x = static_cast<unsigned char>(text_[pos_]);
+                if (not std::isalnum(x) and x != '_' and x != '-' and x != ':' and x != '.') break;
+            }
+            const std::string_view path = text_.substr(begin, pos_ - begin);
+            std::size_t i = 0;
+            while (i < inputs_.size() and inputs_[i] != path) ++i;
+            if (i == inputs_.size()) inputs_.emplace_back(path);
+            program_.push_back(Step{Op::Input, i, N()});
+        } else {
+            fail("expected a number or a knob");
+        }
+    }
+};
+
+} // namespace detail
+
+}
+
+#endif
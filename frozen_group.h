@@ -0,0 +1,307 @@
+/**
+ * @file
+ * @brief     FrozenGroup - finalized Group compiled into flat tables
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Group is a tree of `std::map`s, every lookup chases tree nodes
+ * scattered over the heap. Once configuration is finalized it never
+ * changes, so the whole tree can be compiled into few contiguous arrays:
+ *  1. hot table of packed 8-byte values, one cell per knob,
+ *     64-bit values and arrays are one indirection away;
+ *  2. cold metadata (paths, descriptions, string values) kept apart;
+ *  3. perfect hash over leaf names and paths, O(1) lookup
+ *     with at most one string compare.
+ *
+ * ~~~{.cpp}
+ * knobs.finalize();
+ * knb::FrozenGroup frozen(knobs);
+ * int v = frozen.asInt(frozen.at("feature-A:A-val1"));
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_FROZEN_GROUP_H_INCLUDED
+#define KNOBCPP_FROZEN_GROUP_H_INCLUDED
+
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "knob.h"
+
+namespace knb {
+
+/** Finalized configuration tree compiled into flat tables.
+ *
+ * Knobs are numbered by Id in `Group::visit` order. Each knob can be
+ * found by its leaf name (same first-match rule as `Group::findKnob`)
+ * or by its path relative to the root group, like `"feature-A:A-val1"`.
+ */
+class FrozenGroup
+{
+public:
+    using Id = std::uint32_t;
+    static constexpr Id npos = static_cast<Id>(-1);
+
+private:
+    /// Packed value; strings, 64-bit values and arrays live in side tables, `s` is index.
+    struct Cell {
+        union { bool b; int i; float f; std::uint32_t s; };
+        std::uint8_t t;
+    };
+
+    union Wide { std::int64_t i; std::uint64_t u; double d; };
+
+    /// Perfect hash slot, `fp` filters misses without touching cold data.
+    struct Slot {
+        std::uint64_t fp{0};
+        Id id{npos};
+        std::uint32_t keyOff{0}; ///< key is `paths_[id].substr(keyOff)`
+    };
+
+    // hot
+    std::vector<Cell> values_;
+    std::vector<std::uint32_t> seeds_;
+    std::vector<Slot> slots_;
+    std::vector<Wide> wide_;
+    // cold
+    std::vector<std::string> strings_;
+    std::vector<Buffer<std::int64_t>> int64Arrays_;
+    std::vector<Buffer<double>> doubleArrays_;
+    std::vector<std::string> paths_;
+    std::vector<strv> descs_;
+    StringPool::Ptr pool_; ///< keeps descriptions alive
+    std::string name_;
+
+public:
+    explicit FrozenGroup(const Group& root);
+
+    const std::string& name() const {return name_;}
+    std::size_t size() const {return values_.size();}
+
+    /// Find knob by leaf name or path, return `npos` if not found.
+    Id find(strv key) const
+    {
+        if (slots_.empty()) return npos;
+        const std::uint64_t h = detail::hash(key);
+        const Slot& slot = slots_[position(h, seeds_[h % seeds_.size()])];
+        if (slot.fp != h or slot.id == npos) return npos;
+        return (strv(paths_[slot.id]).substr(slot.keyOff) == key)? slot.id : npos;
+    }
+
+    /// Find knob by leaf name or path, throw `std::out_of_range` if not found.
+    Id at(strv key) const
+    {
+        if (Id id = find(key); id != npos) return id;
+        throw std::out_of_range("knb::FrozenGroup::at: " + std::string(key));
+    }
+
+    /// Same contract as `Group::findKnob`, but path is a view, no allocation.
+    std::tuple<bool,strv,Id> findKnob(strv name) const
+    {
+        Id id = find(name);
+        return (id == npos)? std::make_tuple(false, strv(), npos):
+                             std::make_tuple(true, path(id), id);
+    }
+
+    Knob::T type(Id id) const {return static_cast<Knob::T>(values_[id].t);}
+
+    bool  asBool(Id id)  const {check(id, Knob::T::Bool);  return values_[id].b;}
+    int   asInt(Id id)   const {check(id, Knob::T::Int);   return values_[id].i;}
+    float asFloat(Id id) const {check(id, Knob::T::Float); return values_[id].f;}
+    std::int64_t asInt64(Id id) const {check(id, Knob::T::Int64); return wide_[values_[id].s].i;}
+    std::uint64_t asUInt64(Id id) const {check(id, Knob::T::UInt64); return wide_[values_[id].s].u;}
+    double asDouble(Id id) const {check(id, Knob::T::Double); return wide_[values_[id].s].d;}
+    Span<const std::int64_t> asInt64Array(Id id) const {
+        check(id, Knob::T::Int64Array); return int64Arrays_[values_[id].s].span();
+    }
+    Span<const double> asDoubleArray(Id id) const {
+        check(id, Knob::T::DoubleArray); return doubleArrays_[values_[id].s].span();
+    }
+    str asString(Id id) const {
+        if (type(id) == Knob::T::String) return strings_[values_[id].s];
+        return knob(id).asString();
+    }
+
+    /// Get typed handle, throw `std::invalid_argument` if type is not `T`.
+    template <typename T>
+    KnobHandle<T> bind(strv key) const
+    {
+        const Id id = at(key);
+        const Cell& c = values_[id];
+        if constexpr (std::is_same_v<T,bool>) {
+            if (type(id) == Knob::T::Bool) return KnobHandle<T>(&c.b);
+        } else if constexpr (std::is_same_v<T,int>) {
+            if (type(id) == Knob::T::Int) return KnobHandle<T>(&c.i);
+        } else if constexpr (std::is_same_v<T,float>) {
+            if (type(id) == Knob::T::Float) return KnobHandle<T>(&c.f);
+        } else if constexpr (std::is_same_v<T,std::string>) {
+            if (type(id) == Knob::T::String) return KnobHandle<T>(&strings_[c.s]);
+        } else if constexpr (std::is_same_v<T,std::int64_t>) {
+            if (type(id) == Knob::T::Int64) return KnobHandle<T>(&wide_[c.s].i);
+        } else if constexpr (std::is_same_v<T,std::uint64_t>) {
+            if (type(id) == Knob::T::UInt64) return KnobHandle<T>(&wide_[c.s].u);
+        } else if constexpr (std::is_same_v<T,double>) {
+            if (type(id) == Knob::T::Double) return KnobHandle<T>(&wide_[c.s].d);
+        } else if constexpr (std::is_same_v<T,Buffer<std::int64_t>>) {
+            if (type(id) == Knob::T::Int64Array) return KnobHandle<T>(&int64Arrays_[c.s]);
+        } else {
+            if (type(id) == Knob::T::DoubleArray) return KnobHandle<T>(&doubleArrays_[c.s]);
+        }
+        throw std::invalid_argument("knb::FrozenGroup::bind: knob '" +
+            std::string(key) + "' has type id " + std::to_string(c.t));
+    }
+
+    /// Full path including root group name, like `Group::findKnob` returns.
+    strv path(Id id) const {return paths_[id];}
+    strv name(Id id) const {
+        strv p = paths_[id];
+        return p.substr(p.rfind(':') + 1);
+    }
+    strv desc(Id id) const {return descs_[id];}
+
+    /// Materialize knob, useful to feed frozen values back to a Group.
+    Knob knob(Id id) const
+    {
+        const strv nm = name(id);
+        switch (type(id)){
+        case Knob::T::Bool:   return Knob(pool_, nm, asBool(id), descs_[id]);
+        case Knob::T::Int:    return Knob(pool_, nm, asInt(id), descs_[id]);
+        case Knob::T::Float:  return Knob(pool_, nm, asFloat(id), descs_[id]);
+        case Knob::T::String: return Knob(pool_, nm, strings_[values_[id].s], descs_[id]);
+        case Knob::T::Int64:  return Knob(pool_, nm, asInt64(id), descs_[id]);
+        case Knob::T::UInt64: return Knob(pool_, nm, asUInt64(id), descs_[id]);
+        case Knob::T::Double: return Knob(pool_, nm, asDouble(id), descs_[id]);
+        case Knob::T::Int64Array:  return Knob(pool_, nm, int64Arrays_[values_[id].s], descs_[id]);
+        case Knob::T::DoubleArray: return Knob(pool_, nm, doubleArrays_[values_[id].s], descs_[id]);
+        }
+        return Knob();
+    }
+
+private:
+    void check(Id id, Knob::T t) const {
+        if (type(id) != t) throw std::bad_variant_access();
+    }
+
+    std::size_t position(std::uint64_t h, std::uint32_t seed) const {
+        return detail::mix(h + seed * 0x9e3779b97f4a7c15ull) % slots_.size();
+    }
+
+    void flatten(const Group& g, const std::string& prefix);
+    void buildHash();
+};
+
+inline
+FrozenGroup::FrozenGroup(const Group& root):pool_(root.pool_),name_(root.name_)
+{
+    profile::Pause pause;
+    root.evaluate();
+    flatten(root, name_);
+    buildHash();
+}
+
+inline
+void FrozenGroup::flatten(const Group& g, const std::string& prefix)
+{
+    for (const auto& [nm, knob] : g.knobs_) {
+        Cell c{}; c.t = static_cast<std::uint8_t>(knob.type());
+        switch (knob.type()){
+        case Knob::T::Bool:   c.b = knob.asBool(); break;
+        case Knob::T::Int:    c.i = knob.asInt(); break;
+        case Knob::T::Float:  c.f = knob.asFloat(); break;
+        case Knob::T::String:
+            c.s = static_cast<std::uint32_t>(strings_.size());
+            strings_.push_back(knob.asString());
+            break;
+        case Knob::T::Int64:
+        case Knob::T::UInt64:
+        case Knob::T::Double:
+            c.s = static_cast<std::uint32_t>(wide_.size());
+            wide_.emplace_back();
+            if (knob.type() == Knob::T::Int64) wide_.back().i = knob.asInt64();
+            else if (knob.type() == Knob::T::UInt64) wide_.back().u = knob.asUInt64();
+            else wide_.back().d = knob.asDouble();
+            break;
+        case Knob::T::Int64Array:
+            c.s = static_cast<std::uint32_t>(int64Arrays_.size());
+            int64Arrays_.push_back(*knob.bind<Buffer<std::int64_t>>());
+            break;
+        case Knob::T::DoubleArray:
+            c.s = static_cast<std::uint32_t>(doubleArrays_.size());
+            doubleArrays_.push_back(*knob.bind<Buffer<double>>());
+            break;
+        }
+        values_.push_back(c);
+        paths_.push_back(prefix + ":" + std::string(nm));
+        descs_.push_back(pool_->intern(knob.desc()));
+    }
+    for (const auto& [nm, group] : g.groups_) {
+        flatten(group, prefix + ":" + std::string(nm));
+    }
+}
+
+/** Build perfect hash with "hash and displace" method.
+ *
+ * Keys are distributed over small buckets, biggest buckets are placed
+ * first; for each bucket a seed is searched such that all bucket keys
+ * land into free slots.
+ */
+inline
+void FrozenGroup::buildHash()
+{
+    // Collect keys, first knob in visit order wins the leaf name.
+    std::unordered_map<strv,Slot> keys;
+    keys.reserve(2 * paths_.size());
+    const std::uint32_t rootOff = static_cast<std::uint32_t>(name_.size() + 1);
+    for (Id id = 0; id < paths_.size(); ++id) {
+        strv p = paths_[id];
+        auto nameOff = static_cast<std::uint32_t>(p.rfind(':') + 1);
+        keys.try_emplace(p.substr(nameOff), Slot{0, id, nameOff});
+        keys.try_emplace(p.substr(rootOff), Slot{0, id, rootOff});
+    }
+
+    const std::size_t n = keys.size();
+    seeds_.assign(n / 4 + 1, 0);
+    slots_.assign(n + n / 4 + 1, Slot{});
+
+    std::vector<std::vector<Slot>> buckets(seeds_.size());
+    for (auto& [key, slot] : keys) {
+        slot.fp = detail::hash(key);
+        buckets[slot.fp % buckets.size()].push_back(slot);
+    }
+
+    std::vector<std::size_t> order(buckets.size());
+    for (std::size_t b = 0; b < order.size(); ++b) order[b] = b;
+    std::stable_sort(std::begin(order), std::end(order),
+        [&](std::size_t a, std::size_t b){return buckets[a].size() > buckets[b].size();});
+
+    std::vector<std::size_t> pos;
+    for (std::size_t b : order) {
+        const auto& bucket = buckets[b];
+        if (bucket.empty()) break;
+        for (std::uint32_t seed = 0;; ++seed) {
+            if (seed == 1u << 24) {
+                throw std::runtime_error("knb::FrozenGroup: can't build perfect hash");
+            }
+            pos.clear();
+            bool ok = true;
+            for (const Slot& s : bucket) {
+                std::size_t p = position(s.fp, seed);
+                if (slots_[p].id != npos or
+                    std::find(std::begin(pos), std::end(pos), p) != std::end(pos)) {
+                    ok = false; break;
+                }
+                pos.push_back(p);
+            }
+            if (ok) {
+                seeds_[b] = seed;
+                for (std::size_t i = 0; i < bucket.size(); ++i) slots_[pos[i]] = bucket[i];
+                break;
+            }
+        }
+    }
+}
+
+}
+
+#endif
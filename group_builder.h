@@ -0,0 +1,175 @@
+/**
+ * @file
+ * @brief     GroupBuilder - build large Group trees in bulk
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Building a tree knob by knob with `getGroup(...).addKnob(...)` looks
+ * up every group on the path and rebalances the maps on every insert.
+ * Generated configurations with hundreds of thousands of knobs are
+ * better collected first and built in one pass:
+ * ~~~{.cpp}
+ * knb::GroupBuilder b("root");
+ * b.reserve(n);
+ * for (...) b.add("core0:l2", "ways", 8);
+ * knb::Group knobs = b.build();          // or b.buildFrozen()
+ * ~~~
+ * Knobs are constructed in place, with names interned in the pool of the
+ * future tree, and moved into it. Builder sorts knobs by path, unless they
+ * already come sorted, and then creates each group once and appends knobs
+ * and subgroups at the end of their maps, where insertion needs no search.
+ * Index and fingerprints are computed once for the whole tree.
+ */
+#pragma once
+#ifndef KNOBCPP_GROUP_BUILDER_H_INCLUDED
+#define KNOBCPP_GROUP_BUILDER_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "frozen_group.h"
+
+namespace knb {
+
+class GroupBuilder
+{
+    struct Entry {
+        strv group;  ///< path of the group, interned, `""` is the root
+        Knob knob;
+    };
+
+    /// Sort key of entry `index`, order of `Group::visit`.
+    struct Key {
+        std::uint32_t group;  ///< rank of group path
+        strv name;
+        std::uint32_t index;
+    };
+
+    std::pmr::memory_resource* mr_;
+    StringPool::Ptr pool_;
+    std::string name_;
+    bool immutable_;
+    std::vector<Entry> entries_;
+
+public:
+    explicit GroupBuilder(const std::string& nm, bool immutable=true):
+        mr_(nullptr),pool_(std::make_shared<StringPool>()),name_(nm),immutable_(immutable){}
+
+    /// Builder of tree that takes all its memory from `mr`, see Group.
+    GroupBuilder(const std::string& nm, std::pmr::memory_resource* mr, bool immutable=true):
+        mr_(mr),pool_(StringPool::make(mr)),name_(nm),immutable_(immutable){}
+
+    void reserve(std::size_t n) {entries_.reserve(n);}
+
+    /// Number of added knobs.
+    std::size_t size() const {return entries_.size();}
+
+    /** Add knob `name` to group `path`, like `"a:b"`, `""` is the root.
+     *
+     * Arguments are forwarded to Knob constructor. If the same knob is
+     * added several times, the last one is in the tree, like `Group::addKnob(const Knob&)`.
+     */
+    template< class... Args >
+    GroupBuilder& add(strv path, strv name, Args&&... args) {
+        entries_.push_back(Entry{pool_->intern(path), Knob(pool_, name, std::forward<Args>(args)...)});
+        return *this;
+    }
+
+    /// Add knob `kb` to group `path`, its value is moved.
+    GroupBuilder& add(strv path, Knob&& kb) {
+        entries_.push_back(Entry{pool_->intern(path), Knob(pool_, std::move(kb))});
+        return *this;
+    }
+
+    /// Build the tree from added knobs, builder is empty after it.
+    Group build() {
+        Group root = (mr_ == nullptr)? Group(pool_, name_, immutable_) :
+            Group(std::allocator_arg, Group::allocator_type(mr_), pool_, name_, immutable_);
+
+        // Paths are interned, equal paths are one view: sort distinct
+        // paths once, then knobs by rank of their path and name.
+        std::unordered_map<const char*, std::uint32_t> rankOf;
+        std::vector<strv> paths;
+        for (const auto& e : entries_) {
+            if (rankOf.try_emplace(e.group.data(), 0).second) paths.push_back(e.group);
+        }
+        std::sort(std::begin(paths), std::end(paths), pathLess);
+        for (std::uint32_t r = 0; r < paths.size(); ++r) rankOf[paths[r].data()] = r;
+
+        std::vector<Key> keys;
+        keys.reserve(entries_.size());
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            keys.push_back(Key{rankOf[entries_[i].group.data()], entries_[i].knob.name(),
+                               static_cast<std::uint32_t>(i)});
+        }
+        auto less = [](const Key& a, const Key& b) {
+            if (a.group != b.group) return a.group < b.group;
+            if (a.name != b.name) return a.name < b.name;
+            return a.index < b.index;
+        };
+        if (not std::is_sorted(std::begin(keys), std::end(keys), less)) {
+            std::sort(std::begin(keys), std::end(keys), less);
+        }
+
+        std::vector<Group*> stack{&root}; // groups on the current path
+        std::vector<strv> parts;          // names of groups on the current path
+        std::vector<strv> next;
+        std::uint32_t current = 0;
+        for (std::size_t k = 0; k < keys.size(); ++k) {
+            const Key& key = keys[k];
+            // same knob added again, the last one wins
+            if (k + 1 < keys.size() and keys[k + 1].group == key.group and keys[k + 1].name == key.name) continue;
+
+            if (key.group != current or k == 0) {
+                next.clear();
+                for (strv p = paths[key.group]; not p.empty();) {
+                    const auto pos = p.find(':');
+                    next.push_back(p.substr(0, pos));
+                    p = (pos == strv::npos)? strv() : p.substr(pos + 1);
+                }
+                std::size_t common = 0;
+                while (common < parts.size() and common < next.size() and parts[common] == next[common]) ++common;
+                stack.resize(common + 1);
+                for (std::size_t j = common; j < next.size(); ++j) {
+                    Group* parent = stack.back();
+                    // sorted order: a new subgroup is the last one of its parent
+                    auto g = parent->groups_.try_emplace(std::end(parent->groups_), next[j], pool_, next[j]);
+                    g->second.parent_ = parent;
+                    stack.push_back(&g->second);
+                }
+                parts.swap(next);
+                current = key.group;
+            }
+            Group* g = stack.back();
+            Knob& kb = entries_[key.index].knob;
+            g->knobs_.emplace_hint(std::end(g->knobs_), kb.name(), std::move(kb));
+        }
+        entries_.clear();
+        root.index_.reserve(keys.size());
+        root.reindex();
+        return root;
+    }
+
+    /// Build the tree and compile it into FrozenGroup.
+    FrozenGroup buildFrozen() {
+        Group root = build();
+        root.finalize();
+        return FrozenGroup(root);
+    }
+
+private:
+    /// Order of group paths in `Group::visit`: name by name, so `a:b` is before `a-c`.
+    static bool pathLess(strv a, strv b) {
+        const auto [ia, ib] = std::mismatch(std::begin(a), std::end(a), std::begin(b), std::end(b));
+        if (ia == std::end(a)) return ib != std::end(b);
+        if (ib == std::end(b)) return false;
+        if (*ia == ':' or *ib == ':') return *ia == ':';
+        return static_cast<unsigned char>(*ia) < static_cast<unsigned char>(*ib);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @brief     String hashes and 128-bit configuration Fingerprint
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Fingerprint of a configuration is the sum of hashes of its knobs,
+ * each knob hashed with its path, type and value. Sum does not depend
+ * on the order of knobs and is updated in O(1) when one knob changes:
+ * subtract the old hash of the knob, add the new one.
+ *
+ * Hashes do not depend on addresses, they are the same in every
+ * run of the program on machines with the same byte order.
+ */
+#pragma once
+#ifndef KNOBCPP_HASH_H_INCLUDED
+#define KNOBCPP_HASH_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace knb {
+
+namespace detail {
+
+/// FNV-1a 64-bit string hash.
+constexpr std::uint64_t hash(std::string_view s, std::uint64_t h = 0xcbf29ce484222325ull)
+{
+    for (char c : s) { h ^= static_cast<unsigned char>(c); h *= 0x100000001b3ull; }
+    return h;
+}
+
+/** Multiply-xorshift 64-bit string hash, second lane of HashState.
+ *
+ * Every byte goes through a multiply and a shift, a nonlinear step
+ * that FNV-1a does not have, so strings that collide in `hash` do not
+ * collide here because of it.
+ */
+constexpr std::uint64_t hashMx(std::string_view s, std::uint64_t h = 0x6c62272e07bb0142ull)
+{
+    for (char c : s) { h = (h + static_cast<unsigned char>(c)) * 0xbf58476d1ce4e5b9ull; h ^= h >> 29; }
+    return h;
+}
+
+/// splitmix64 finalizer, used to derive more hash functions from one.
+constexpr std::uint64_t mix(std::uint64_t x)
+{
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace detail
+
+/// 128-bit content hash of a configuration, see `Group::fingerprint`.
+struct Fingerprint
+{
+    std::uint64_t hi{0};
+    std::uint64_t lo{0};
+
+    Fingerprint& operator+=(const Fingerprint& f) {hi += f.hi; lo += f.lo; return *this;}
+    Fingerprint& operator-=(const Fingerprint& f) {hi -= f.hi; lo -= f.lo; return *this;}
+
+    friend bool operator==(const Fingerprint& a, const Fingerprint& b) {
+        return a.hi == b.hi and a.lo == b.lo;
+    }
+    friend bool operator!=(const Fingerprint& a, const Fingerprint& b) {return not (a == b);}
+    friend bool operator<(const Fingerprint& a, const Fingerprint& b) {
+        return a.hi < b.hi or (a.hi == b.hi and a.lo < b.lo);
+    }
+
+    /// 32 lower case hex digits, usable as a file name.
+    std::string hex() const {
+        static constexpr char digits[] = "0123456789abcdef";
+        std::string s(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            s[15 - i] = digits[(hi >> (4 * i)) & 0xf];
+            s[31 - i] = digits[(lo >> (4 * i)) & 0xf];
+        }
+        return s;
+    }
+};
+
+namespace detail {
+
+/** Two lanes of different hashes, FNV-1a and `hashMx`, text is added piece by piece.
+ *
+ * Both are computed byte by byte, so adding `"a:"` and then `"b"`
+ * gives the same state as adding `"a:b"`; Group keeps the state
+ * of its path and continues it with knob names.
+ */
+struct HashState
+{
+    std::uint64_t a{0xcbf29ce484222325ull};
+    std::uint64_t b{0x6c62272e07bb0142ull};
+
+    HashState& add(std::string_view s) {a = hash(s, a); b = hashMx(s, b); return *this;}
+
+    Fingerprint finish() const {return Fingerprint{mix(a), mix(b)};}
+};
+
+} // namespace detail
+
+}
+
+#endif
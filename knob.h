@@ -18,15 +18,34 @@
 #ifndef KNOBCPP_KNOB_H_INCLUDED
 #define KNOBCPP_KNOB_H_INCLUDED
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
 #include <tuple>
 #include <algorithm>
 #include <variant>
 #include <functional>
+#include <iterator>
+#include <stdexcept>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "access_profile.h"
+#include "codec.h"
+#include "expression.h"
+#include "hash.h"
+#include "span.h"
 #include "static_knob.h"
+#include "string_pool.h"
 
 namespace knb {
 
@@ -35,55 +54,225 @@ using strv = std::string_view;
 using cstr = const char*;
 
 class Group;
+class FrozenGroup;
+class GroupBuilder;
+class LayeredGroup;
+class SweepPoint;
+namespace detail { struct SnapshotWriter; }
+
+namespace detail {
+
+/// Knob value, alternative index is `Knob::T`.
+using KnobValue = std::variant<bool,int,float,std::string,
+                               std::int64_t,std::uint64_t,double,
+                               Buffer<std::int64_t>,Buffer<double>>;
+
+/// Index of `V` in KnobValue, `std::variant_npos` if it is not there.
+template <typename V, std::size_t I = 0>
+constexpr std::size_t valueIndex()
+{
+    if constexpr (I == std::variant_size_v<KnobValue>) return std::variant_npos;
+    else if constexpr (std::is_same_v<V,std::variant_alternative_t<I,KnobValue>>) return I;
+    else return valueIndex<V,I + 1>();
+}
+
+} // namespace detail
 
+/** Pre-resolved typed reference to a knob value.
+ *
+ * Name lookup and type check are done once, when handle is created
+ * with `Knob::bind`, `Group::bind` or `FrozenGroup::bind`;
+ * `get()` is a single load, no string compare and no variant dispatch.
+ *
+ * Handle stays valid as long as the knob it refers to lives and keeps
+ * its type; `Group::changeValue` does not invalidate handles.
+ */
+template <typename T>
+class KnobHandle
+{
+    static_assert(detail::valueIndex<T>() != std::variant_npos,
+                  "knob value type is one of Knob::T types");
+    const T* v_{nullptr};
+public:
+    KnobHandle() = default;
+    explicit KnobHandle(const T* v):v_(v){}
+
+    const T& get() const {return *v_;}
+    const T& operator*() const {return *v_;}
+    const T* operator->() const {return v_;}
+
+    explicit operator bool() const {return v_ != nullptr;}
+};
+
+/** Named configuration value.
+ *
+ * Name and description are interned in a StringPool shared by
+ * the whole configuration tree, see Group; knob keeps only views
+ * and a reference to the pool, so copying a knob copies no strings
+ * (unless the value itself is a string). Knob made without a pool
+ * keeps name and description in one string of its own, short ones
+ * fit into it without allocation; they are interned into the tree
+ * pool when the knob is added to a Group or Array.
+ */
 class Knob final
 {
-    std::string name_;
-    std::variant<bool,int,float,std::string> v;
-    std::string desc_;
+    StringPool::Ptr pool_;  ///< `nullptr` if the knob owns its strings
+    strv name_;
+    detail::KnobValue v;
+    strv desc_;
+    std::string own_;       ///< name and description of a knob without a pool
 public:
-    enum class T : std::size_t { Bool=0, Int, Float, String};
+    /// Value type tags, new types are appended to keep ids stable.
+    enum class T : std::size_t { Bool=0, Int, Float, String,
+                                 Int64, UInt64, Double, Int64Array, DoubleArray };
+
+    template <typename V>
+    static constexpr T typeOf() {
+        static_assert(detail::valueIndex<V>() != std::variant_npos,
+                      "knob value type is one of Knob::T types");
+        return static_cast<T>(detail::valueIndex<V>());
+    }
 public:
-    Knob(const str& nm, bool  b, const str& d=""):name_(nm),v(b),desc_(d){}
-    Knob(const str& nm, int   i, const str& d=""):name_(nm),v(i),desc_(d){}
-    Knob(const str& nm, float f, const str& d=""):name_(nm),v(f),desc_(d){}
-    Knob(const str& nm, const str& s, const str& d=""):name_(nm),v(s),desc_(d){}
+    Knob(const str& nm, bool  b, const str& d=""):v(b),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, int   i, const str& d=""):v(i),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, float f, const str& d=""):v(f),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, const str& s, const str& d=""):v(s),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const std::string& nm, cstr s, const str& d=""):v(std::string(s)),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, std::int64_t i, const str& d=""):v(i),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, std::uint64_t u, const str& d=""):v(u),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, double f, const str& d=""):v(f),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, const std::vector<std::int64_t>& a, const str& d=""):
+        v(Buffer<std::int64_t>(a)),own_(nm + d){owned(nm.size(), d.size());}
+    Knob(const str& nm, const std::vector<double>& a, const str& d=""):
+        v(Buffer<double>(a)),own_(nm + d){owned(nm.size(), d.size());}
+    Knob():Knob("",false){}
+
+    /// Construct knob with name and description interned in `pool`.
+    Knob(StringPool::Ptr pool, strv nm, bool  b, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(b),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, int   i, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(i),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, float f, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(f),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, const str& s, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(s),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, str&& s, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(std::move(s)),desc_(pool_->intern(d)){}
     //NOTE: next ctor is important, we need temp std::string, otherwise
     //Knob's copy/move ctor and op= do not work, exception -> variant looses
     //its value, gcc 7.3.
-    Knob(const std::string& nm, cstr s, const str& d=""):
-        name_(nm),v(std::string(s)),desc_(d){}
-    Knob():Knob("",false){}
+    Knob(StringPool::Ptr pool, strv nm, cstr s, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(std::string(s)),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, std::int64_t i, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(i),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, std::uint64_t u, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(u),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, double f, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(f),desc_(pool_->intern(d)){}
+    /// Array knob, elements are copied into an aligned Buffer.
+    Knob(StringPool::Ptr pool, strv nm, const std::vector<std::int64_t>& a, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(Buffer<std::int64_t>(a)),
+        desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, const std::vector<double>& a, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(Buffer<double>(a)),
+        desc_(pool_->intern(d)){}
+    /// Array knob that shares `a` with its other owners.
+    Knob(StringPool::Ptr pool, strv nm, const Buffer<std::int64_t>& a, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(a),desc_(pool_->intern(d)){}
+    Knob(StringPool::Ptr pool, strv nm, const Buffer<double>& a, strv d=""):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(a),desc_(pool_->intern(d)){}
 
-    //Compiler made defaults for us already.
-    //Knob(Knob&& other) = default;
-    //Knob(const Knob& other) = default;
-    //Knob& operator=(const Knob&) = default;
+    /// Copy of `other` with name and description interned in `pool`.
+    Knob(StringPool::Ptr pool, const Knob& other):
+        pool_(std::move(pool)),name_(pool_->intern(other.name_)),v(other.v),
+        desc_(pool_->intern(other.desc_)){}
+    /// Same, string or array value of `other` is moved, not copied.
+    Knob(StringPool::Ptr pool, Knob&& other):
+        pool_(std::move(pool)),name_(pool_->intern(other.name_)),v(std::move(other.v)),
+        desc_(pool_->intern(other.desc_)){}
 
-    const std::string& name() const {return name_;}
-    const std::string& desc() const {return desc_;}
+    // Views of own strings point to the new copy of them, moved-from knob has no name.
+    Knob(const Knob& other):
+        pool_(other.pool_),name_(other.name_),v(other.v),desc_(other.desc_),own_(other.own_){rebind();}
+    Knob(Knob&& other) noexcept(std::is_nothrow_move_constructible_v<detail::KnobValue>):
+        pool_(std::move(other.pool_)),name_(other.name_),v(std::move(other.v)),desc_(other.desc_),
+        own_(std::move(other.own_)){rebind(); other.owned(0, 0);}
+    Knob& operator=(const Knob& other) {
+        if (this != &other) {
+            pool_ = other.pool_; name_ = other.name_; v = other.v; desc_ = other.desc_;
+            own_ = other.own_; rebind();
+        }
+        return *this;
+    }
+    Knob& operator=(Knob&& other) noexcept(std::is_nothrow_move_assignable_v<detail::KnobValue>) {
+        if (this != &other) {
+            pool_ = std::move(other.pool_); name_ = other.name_; v = std::move(other.v);
+            desc_ = other.desc_; own_ = std::move(other.own_); rebind();
+            other.owned(0, 0);
+        }
+        return *this;
+    }
+
+    strv name() const {return name_;}
+    strv desc() const {return desc_;}
+
+    /// Pool that holds name and description, `nullptr` if the knob owns them.
+    const StringPool::Ptr& pool() const {return pool_;}
+
+    /// Compare names, pointer compare if both knobs share the pool.
+    bool sameName(const Knob& other) const {
+        return (pool_ and pool_ == other.pool_)? name_.data() == other.name_.data() :
+                                                 name_ == other.name_;
+    }
 
     Knob::T type() const {return static_cast<Knob::T>(v.index());}
     std::size_t typeId() const {return v.index();}
 
 public:
-    bool  asBool()  const {return std::get<bool>(v);}
-    int   asInt()   const {return std::get<int>(v);}
-    float asFloat() const {return std::get<float>(v);}
+    bool  asBool()  const {touch(); return std::get<bool>(v);}
+    int   asInt()   const {touch(); return std::get<int>(v);}
+    float asFloat() const {touch(); return std::get<float>(v);}
+    std::int64_t  asInt64()  const {touch(); return std::get<std::int64_t>(v);}
+    std::uint64_t asUInt64() const {touch(); return std::get<std::uint64_t>(v);}
+    double        asDouble() const {touch(); return std::get<double>(v);}
+    /// Elements of array knob, valid until the knob value changes.
+    Span<const std::int64_t> asInt64Array() const {
+        touch(); return std::get<Buffer<std::int64_t>>(v).span();
+    }
+    Span<const double> asDoubleArray() const {touch(); return std::get<Buffer<double>>(v).span();}
     str asString() const {
-        switch (type()){
-        case T::Bool:   return (asBool()==true)? "true":"false";
-        case T::Int:    return std::to_string(asInt());
-        case T::Float:  return std::to_string(asFloat());
-        case T::String: return std::get<str>(v); 
-        }
-        return std::get<str>(v);
+        touch();
+        return std::visit([](const auto& x) -> str {
+            if constexpr (std::is_same_v<std::decay_t<decltype(x)>,str>) return x;
+            else return codec::encode(x);
+        }, v);
+    }
+
+    /** Knob with the same name and type, value decoded from `text`.
+     *
+     * See `codec::decode`; on error the returned knob has this knob value.
+     */
+    std::pair<Status,Knob> withValue(strv text, const Range& r = Range()) const {
+        std::pair<Status,Knob> res(Status(), *this);
+        res.first = decode(text, r, res.second.v);
+        return res;
     }
 
     explicit operator bool()  const { return asBool(); }
     explicit operator int()   const { return asInt(); }
     explicit operator float() const { return asFloat(); }
 
+    /// Get typed handle, throw `std::invalid_argument` if type is not `T`.
+    template <typename T>
+    KnobHandle<T> bind() const {
+        touch();
+        if (const T* p = std::get_if<T>(&v); p != nullptr) {
+            return KnobHandle<T>(p);
+        }
+        throw std::invalid_argument("knb::Knob::bind: knob '" + std::string(name_) +
+            "' has type id " + std::to_string(typeId()));
+    }
+
     bool operator< (const Knob& other)const {return this->v <  other.v;}
     bool operator<=(const Knob& other)const {return this->v <= other.v;}
     bool operator> (const Knob& other)const {return this->v >  other.v;}
@@ -95,115 +284,1466 @@ public:
     bool operator!=(bool v) const {return asBool() != v;}
 
     friend class knb::Group;
+    friend class knb::SweepPoint;
+
+private:
+    /// Knob with value `x` of any type, see `Group::addDerived`.
+    Knob(StringPool::Ptr pool, strv nm, detail::KnobValue x, strv d):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),v(std::move(x)),desc_(pool_->intern(d)){}
+
+    /// Name and description are `own_`, `n` and `d` characters long.
+    void owned(std::size_t n, std::size_t d) {
+        name_ = strv(own_.data(), n);
+        desc_ = strv(own_.data() + n, d);
+    }
+
+    /// Point views of a knob without a pool to its own strings after copy or move.
+    void rebind() {
+        if (not pool_) owned(name_.size(), desc_.size());
+    }
+
+    /// Count read of this knob, see access_profile.h.
+    void touch() const {
+        if constexpr (profileKnobAccess == true) profile::detail::read(this);
+    }
+
+    /// Finish `h`, hash of the knob path, with type and value, see Group::fingerprint.
+    Fingerprint hashed(detail::HashState h) const {
+        const char type = static_cast<char>(typeId());
+        h.add(strv(&type, 1));
+        std::visit([&h](const auto& x) {
+            using V = std::decay_t<decltype(x)>;
+            if constexpr (std::is_same_v<V,str>) h.add(x);
+            else if constexpr (std::is_arithmetic_v<V>) h.add(strv(reinterpret_cast<const char*>(&x), sizeof(x)));
+            else h.add(strv(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(*x.data())));
+        }, v);
+        return h.finish();
+    }
+
+    /// Decode `s` as value of this knob type into `out`, `out` is unchanged on error.
+    template <std::size_t I = 0>
+    Status decode(strv s, const Range& r, detail::KnobValue& out) const {
+        if constexpr (I == std::variant_size_v<detail::KnobValue>) {
+            return Status("unknown type");
+        } else {
+            if (v.index() != I) return decode<I + 1>(s, r, out);
+            std::variant_alternative_t<I,detail::KnobValue> x{};
+            Status st;
+            if constexpr (I == static_cast<std::size_t>(T::String)) x = s;
+            else if constexpr (I == static_cast<std::size_t>(T::Bool)) st = codec::decode(s, x);
+            else st = codec::decode(s, x, r);
+            if (st) out = std::move(x);
+            return st;
+        }
+    }
+};
+
+
+namespace detail {
+
+/** Value of a live knob, see `Group::addLiveKnob`.
+ *
+ * Value is alone on its cache line, readers of one live knob do not
+ * share the line with writers of other knobs or of subscriptions.
+ */
+struct alignas(64) LiveCell
+{
+    using Callback = std::function<void(const Knob&)>;
+
+    std::atomic<std::uint64_t> bits{0};
+
+    // cold, on the next cache line
+    alignas(64) Knob::T type;
+    std::mutex mutex; ///< guards callbacks
+    std::vector<std::pair<std::size_t,Callback>> callbacks;
+    std::size_t nextId{0};
+
+    explicit LiveCell(const Knob& k):type(k.type()) { store(k); }
+
+    // Copy of a group gets current value, not subscriptions.
+    LiveCell(const LiveCell& other):bits(other.bits.load(std::memory_order_relaxed)),
+        type(other.type){}
+    LiveCell& operator=(const LiveCell& other) {
+        bits.store(other.bits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        type = other.type;
+        return *this;
+    }
+
+    template <typename T>
+    T load() const {
+        const std::uint64_t b = bits.load(std::memory_order_relaxed);
+        T v; std::memcpy(&v, &b, sizeof(T));
+        return v;
+    }
+
+    void store(const Knob& k) {
+        profile::Pause pause;
+        std::uint64_t b = 0;
+        switch (k.type()){
+        case Knob::T::Bool:  { bool  v = k.asBool();  std::memcpy(&b, &v, sizeof(v)); } break;
+        case Knob::T::Int:   { int   v = k.asInt();   std::memcpy(&b, &v, sizeof(v)); } break;
+        case Knob::T::Float: { float v = k.asFloat(); std::memcpy(&b, &v, sizeof(v)); } break;
+        case Knob::T::Int64:  b = static_cast<std::uint64_t>(k.asInt64()); break;
+        case Knob::T::UInt64: b = k.asUInt64(); break;
+        case Knob::T::Double: { double v = k.asDouble(); std::memcpy(&b, &v, sizeof(v)); } break;
+        case Knob::T::String:
+        case Knob::T::Int64Array:
+        case Knob::T::DoubleArray:
+            throw std::invalid_argument("knb::Group: knob '" +
+                std::string(k.name()) + "' of type id " + std::to_string(k.typeId()) +
+                " can't be live");
+        }
+        bits.store(b, std::memory_order_relaxed);
+    }
+
+    void notify(const Knob& k) {
+        std::vector<Callback> fire;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& id_cb : callbacks) fire.push_back(id_cb.second);
+        }
+        for (const auto& cb : fire) cb(k);
+    }
 };
 
+} // namespace detail
 
-/** Array of knobs.
+/** Input knobs of a derived knob, see `Group::addDerived`.
  *
- * Facility to add a knob to the container and find a knob by its name.
+ * Inputs are in the order of the paths given to `addDerived`.
+ */
+class DerivedInputs
+{
+    const Knob* const* knobs_;
+    std::size_t size_;
+public:
+    DerivedInputs(const Knob* const* knobs, std::size_t size):knobs_(knobs),size_(size){}
+
+    std::size_t size() const {return size_;}
+    const Knob& operator[](std::size_t i) const {return *knobs_[i];}
+
+    /// Scalar number or Bool input `i` as `N`, throw `std::invalid_argument` otherwise.
+    template <typename N>
+    N number(std::size_t i) const {
+        const Knob& k = *knobs_[i];
+        switch (k.type()) {
+        case Knob::T::Bool:   return static_cast<N>(k.asBool());
+        case Knob::T::Int:    return static_cast<N>(k.asInt());
+        case Knob::T::Float:  return static_cast<N>(k.asFloat());
+        case Knob::T::Int64:  return static_cast<N>(k.asInt64());
+        case Knob::T::UInt64: return static_cast<N>(k.asUInt64());
+        case Knob::T::Double: return static_cast<N>(k.asDouble());
+        default:
+            throw std::invalid_argument("knb::DerivedInputs: knob '" +
+                std::string(k.name()) + "' is not a number");
+        }
+    }
+};
+
+namespace detail {
+
+/// Derived knob of a group: how to compute it and its memoized state.
+struct DerivedCell
+{
+    using Compute = std::function<KnobValue(const DerivedInputs&)>;
+
+    std::vector<std::string> inputs; ///< paths relative to the owner group
+    Compute compute;
+    std::string formula;             ///< expression text, empty for callables
+
+    // Set when the root builds the dependency graph, not copied.
+    std::vector<const Knob*> args;
+    std::vector<DerivedCell*> argCells; ///< cell of each derived input or `nullptr`
+    Knob* knob{nullptr};
+    std::atomic<bool> valid{false};
+    bool evaluating{false};
+
+    DerivedCell(std::vector<std::string> in, Compute f, std::string text):
+        inputs(std::move(in)),compute(std::move(f)),formula(std::move(text)){}
+    DerivedCell(const DerivedCell& other):
+        inputs(other.inputs),compute(other.compute),formula(other.formula){}
+    DerivedCell& operator=(const DerivedCell& other) {
+        inputs = other.inputs; compute = other.compute; formula = other.formula;
+        args.clear(); argCells.clear(); knob = nullptr;
+        valid.store(false, std::memory_order_relaxed);
+        return *this;
+    }
+};
+
+/// Derived knobs of a tree and knobs they read, kept by the root.
+struct DerivedGraph
+{
+    std::vector<DerivedCell*> cells;
+    std::unordered_map<const Knob*,std::vector<DerivedCell*>> dependents;
+};
+
+/// Knob value of type `R` returned by a derived knob callable.
+template <typename R>
+KnobValue derivedValue(R&& r)
+{
+    using V = std::decay_t<R>;
+    if constexpr (std::is_same_v<V,const char*> or std::is_same_v<V,char*>) return KnobValue(std::string(r));
+    else if constexpr (std::is_same_v<V,std::vector<std::int64_t>>) return KnobValue(Buffer<std::int64_t>(r));
+    else if constexpr (std::is_same_v<V,std::vector<double>>) return KnobValue(Buffer<double>(r));
+    else return KnobValue(std::in_place_index<valueIndex<V>()>, std::forward<R>(r));
+}
+
+} // namespace detail
+
+/** Reader of a live knob, see `Group::addLiveKnob`.
+ *
+ * Each read is one relaxed atomic load, the value may change
+ * between two reads.
+ */
+template <typename T>
+class LiveKnob
+{
+    static_assert(std::is_arithmetic_v<T> and sizeof(T) <= 8 and
+                  detail::valueIndex<T>() != std::variant_npos,
+                  "live knob value type is scalar Knob::T type");
+    const detail::LiveCell* cell_{nullptr};
+public:
+    LiveKnob() = default;
+    explicit LiveKnob(const detail::LiveCell* cell):cell_(cell){}
+
+    T get() const {return cell_->load<T>();}
+    T operator*() const {return get();}
+
+    explicit operator bool() const {return cell_ != nullptr;}
+};
+
+
+/** Array of knobs, small set of knobs with fast lookup by name.
+ *
+ * Columns, structure of arrays: 32-bit name tags, names and knobs.
+ * Lookup scans the tag column, four tags per SSE2 compare, and compares
+ * names only where a tag matches, so the knobs are not touched until
+ * the one that is found. Knobs are kept in insertion order, lookup
+ * finds the first knob with the name.
  */
 class Array
 {
-    std::string name_;
-    std::vector<Knob> knobs_;
+    StringPool::Ptr pool_;
+    strv name_;
+    std::pmr::vector<std::uint32_t> tags_;
+    std::pmr::vector<strv> names_;  ///< views of names interned in `pool_`
+    std::pmr::vector<Knob> knobs_;
 public:
-    explicit Array(const std::string& nm):name_(nm){}
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit Array(const std::string& nm, StringPool::Ptr pool = std::make_shared<StringPool>()):
+        pool_(std::move(pool)),name_(pool_->intern(nm)){}
+
+    /// Array that takes all its memory from `mr`, see Group.
+    Array(const std::string& nm, std::pmr::memory_resource* mr):
+        pool_(StringPool::make(mr)),name_(pool_->intern(nm)),tags_(mr),names_(mr),knobs_(mr){}
 
-    void addKnob(const Knob& kb){knobs_.push_back(kb);}
+    strv name() const {return name_;}
+
+    std::size_t size() const {return knobs_.size();}
+
+    /// Append knob, return its index.
+    std::size_t addKnob(const Knob& kb){ reserve(); knobs_.emplace_back(pool_, kb); return added(); }
+    std::size_t addKnob(Knob&& kb){ reserve(); knobs_.emplace_back(pool_, std::move(kb)); return added(); }
 
     template< class... Args >
-    void addKnob(Args&&... args){knobs_.emplace_back(args...);}
+    std::size_t addKnob(strv name, Args&&... args){
+        reserve();
+        knobs_.emplace_back(pool_, name, std::forward<Args>(args)...);
+        return added();
+    }
 
+    /// Index of the first knob named `name` or `npos`.
+    std::size_t indexOf(strv name) const
+    {
+        const std::uint32_t t = tag(name);
+        const std::uint32_t* tags = tags_.data();
+        const std::size_t n = tags_.size();
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i key = _mm_set1_epi32(static_cast<int>(t));
+        for (; i + 4 <= n; i += 4) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+            for (int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key))); m != 0; m &= m - 1) {
+                const std::size_t j = i + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(m)));
+                if (names_[j] == name) return j;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            if (tags[i] == t and names_[i] == name) return i;
+        }
+        return npos;
+    }
 
-    std::tuple<bool,Knob> findKnob(std::string_view name) const
+    /// First knob named `name` or `nullptr`.
+    const Knob* find(strv name) const
     {
-        auto knob = std::find_if(
-                       std::begin(knobs_), std::end(knobs_),
-                       [name](const Knob& k)->bool{return k.name()==name;}
-        );
+        const std::size_t i = indexOf(name);
+        return (i == npos)? nullptr : &knobs_[i];
+    }
 
-        return (knob==std::end(knobs_))? std::make_tuple(false, Knob()):
-                                         std::make_tuple(true, *knob);
+    /// Found flag and reference to the knob, to an empty knob if not found; nothing is copied.
+    std::tuple<bool,const Knob&> findKnob(std::string_view name) const
+    {
+        static const Knob none;
+        const Knob* k = find(name);
+        return {k != nullptr, (k != nullptr)? *k : none};
     }
 
     const Knob& at(std::size_t pos) const {return knobs_.at(pos);}
-	
+
+private:
+    /// Tag of a name: its length and first and last 8 bytes, mixed.
+    static std::uint32_t tag(strv s) {
+        std::uint64_t head = 0, tail = 0;
+        std::memcpy(&head, s.data(), std::min<std::size_t>(s.size(), 8));
+        if (s.size() > 8) std::memcpy(&tail, s.data() + s.size() - 8, 8);
+        const std::uint64_t h = (head ^ (tail * 0x9e3779b97f4a7c15ull) ^ s.size()) * 0xbf58476d1ce4e5b9ull;
+        return static_cast<std::uint32_t>(h >> 32);
+    }
+
+    /// Grow all columns together, so that appending to them does not throw.
+    void reserve() {
+        if (knobs_.size() < knobs_.capacity() and tags_.size() < tags_.capacity() and
+            names_.size() < names_.capacity()) return;
+        const std::size_t n = std::max<std::size_t>(8, 2 * knobs_.size());
+        tags_.reserve(n); names_.reserve(n); knobs_.reserve(n);
+    }
+
+    /// Fill tag and name columns for the knob just appended.
+    std::size_t added() {
+        const strv nm = knobs_.back().name();
+        names_.push_back(nm);
+        tags_.push_back(tag(nm));
+        return knobs_.size() - 1;
+    }
+};
+
+namespace detail {
+
+/// Iterator over mapped values of a map, knobs or groups of a Group.
+template <typename MapIt, typename Value>
+class ValueIterator
+{
+    MapIt it_;
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Value*;
+    using reference = const Value&;
+
+    ValueIterator() = default;
+    explicit ValueIterator(MapIt it):it_(it){}
+
+    reference operator*() const {return it_->second;}
+    pointer operator->() const {return &it_->second;}
+    ValueIterator& operator++() {++it_; return *this;}
+    ValueIterator operator++(int) {ValueIterator old = *this; ++it_; return old;}
+    bool operator==(const ValueIterator& other) const {return it_ == other.it_;}
+    bool operator!=(const ValueIterator& other) const {return it_ != other.it_;}
+};
+
+/// Pair of iterators usable in range-for.
+template <typename It>
+struct Range
+{
+    It first, last;
+    It begin() const {return first;}
+    It end() const {return last;}
+    bool empty() const {return first == last;}
+};
+
+/** Call visitor with `(knob, owner)` or `(knob)`.
+ *
+ * @return false if visitor returns `bool` and it is false, stop visiting
+ */
+template <typename F, typename G>
+bool visitKnob(F& visitor, const Knob& k, const G& owner)
+{
+    if constexpr (std::is_invocable_v<F&, const Knob&, const G&>) {
+        if constexpr (std::is_same_v<std::invoke_result_t<F&, const Knob&, const G&>, bool>) {
+            return visitor(k, owner);
+        } else { visitor(k, owner); return true; }
+    } else if constexpr (std::is_same_v<std::invoke_result_t<F&, const Knob&>, bool>) {
+        return visitor(k);
+    } else { visitor(k); return true; }
+}
+
+} // namespace detail
+
+/** Result of name lookup in a Group, see `Group::lookup`.
+ *
+ * Lookup does not allocate, instead of path string it returns
+ * the group that holds the knob; use `Group::path` to get path string
+ * when it is really needed.
+ */
+struct KnobRef
+{
+    const Knob*  knob{nullptr};  ///< first match in `Group::visit` order
+    const Group* owner{nullptr}; ///< group that holds the knob, path id
+    std::size_t  matches{0};     ///< number of knobs with this leaf name
+
+    explicit operator bool() const {return knob != nullptr;}
+    bool ambiguous() const {return matches > 1;}
 };
 
 /** Hierarchy of groups of knobs.
  *
+ * Root group keeps hash index of all knobs in the tree: leaf name to knob.
+ * The index is updated as `addKnob`/`getGroup` build the tree,
+ * so name lookup from the root is O(1). Lookup from a subgroup
+ * is O(depth) for names that are unique in the tree.
+ *
+ * Group is allocator-aware: whole tree, its maps, index and string pool,
+ * can be placed into one `std::pmr::memory_resource`, for example
+ * monotonic arena that is rebuilt for every experiment run:
+ * ~~~{.cpp}
+ * std::pmr::monotonic_buffer_resource arena(1 << 20);
+ * knb::Group knobs("root", &arena);
+ * ~~~
+ * Subgroups are created in the memory resource of their parent.
  */
 class Group
 {
-    std::string name_;
-    std::map<std::string,Knob> knobs_;
-    std::map<std::string,Group> groups_;
+    /// Index entry, key is a view of the knob name owned by `knobs_` map.
+    struct IndexEntry {
+        const Knob*  knob;
+        const Group* owner;
+        std::size_t  matches;
+    };
+
+    StringPool::Ptr pool_;
+    strv name_;
+    std::pmr::map<strv,Knob> knobs_;
+    std::pmr::map<strv,Group> groups_;
+    std::pmr::unordered_map<strv,IndexEntry> index_;
+    std::pmr::map<strv,detail::LiveCell> live_;
+    std::pmr::map<strv,Range> ranges_;
+    std::pmr::map<strv,detail::DerivedCell> derived_;
+    mutable std::unique_ptr<detail::DerivedGraph> graph_; ///< root only, built on first use
+    /// Root only, created with the first derived knob; serializes evaluation
+    /// of derived knobs of this tree, reads of valid values do not lock it.
+    std::unique_ptr<std::recursive_mutex> derivedMutex_;
+    /// Root only, created with the first live knob; serializes changes of live knobs.
+    std::unique_ptr<std::mutex> liveMutex_;
+    Group* parent_{nullptr};
+    bool hasDerived_{false};   ///< root only, tree has derived knobs
+    detail::HashState path_;   ///< hash of path from the root, `"a:b:"`
+    Fingerprint fingerprint_;  ///< sum of hashes of knobs of the sub-tree
 
     bool immutable_;
+
+    /// Tag of the copy ctor used for subgroups, see `Group(const Group&)`.
+    struct Subtree { explicit Subtree() = default; };
+
+    friend class knb::FrozenGroup;
+    friend class knb::GroupBuilder;
+    friend class knb::LayeredGroup;
+    friend struct knb::detail::SnapshotWriter;
 public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
     explicit Group(const std::string& nm, bool immutable=true):
-        name_(nm),immutable_(immutable){}
+        Group(std::make_shared<StringPool>(), nm, immutable){}
 
+    /** Construct tree that takes all its memory from `mr`.
+     *
+     * With `std::pmr::monotonic_buffer_resource` the tree is built
+     * without `malloc` calls and destroyed without `free` calls,
+     * arena releases its memory at once. The arena must outlive
+     * the tree and all knobs copied out of the tree.
+     */
+    Group(const std::string& nm, std::pmr::memory_resource* mr, bool immutable=true):
+        Group(std::allocator_arg, allocator_type(mr), StringPool::make(mr), nm, immutable){}
+
+    /// Construct group that interns names in `pool`, shared with other groups.
+    Group(StringPool::Ptr pool, strv nm, bool immutable=true):
+        Group(std::allocator_arg, allocator_type(), std::move(pool), nm, immutable){}
+
+    Group(std::allocator_arg_t, const allocator_type& a,
+          StringPool::Ptr pool, strv nm, bool immutable=true):
+        pool_(std::move(pool)),name_(pool_->intern(nm)),
+        knobs_(a),groups_(a),index_(a),live_(a),ranges_(a),derived_(a),immutable_(immutable){}
+
+    // Index and parent links point inside the tree, rebuild them.
+    Group(const Group& other):
+        Group(std::allocator_arg, allocator_type(), other, nullptr, Subtree{}) { reindex(); }
+    Group(std::allocator_arg_t, const allocator_type& a, const Group& other):
+        Group(std::allocator_arg, a, other, nullptr, Subtree{}) { reindex(); }
+    Group(Group&& other):
+        pool_(other.pool_),name_(other.name_),knobs_(std::move(other.knobs_)),
+        groups_(std::move(other.groups_)),index_(knobs_.get_allocator()),
+        live_(std::move(other.live_)),ranges_(std::move(other.ranges_)),
+        derived_(std::move(other.derived_)),immutable_(other.immutable_)
+    { other.index_.clear(); other.graph_.reset(); relink(); reindex(); }
+    Group(std::allocator_arg_t, const allocator_type& a, Group&& other):
+        pool_(other.pool_),name_(other.name_),knobs_(std::move(other.knobs_), a),
+        groups_(std::move(other.groups_), a),index_(a),live_(std::move(other.live_), a),
+        ranges_(std::move(other.ranges_), a),derived_(std::move(other.derived_), a),
+        immutable_(other.immutable_)
+    { other.index_.clear(); other.graph_.reset(); relink(); reindex(); }
+    Group& operator=(const Group& other) {
+        if (this != &other) { Group tmp(other); *this = std::move(tmp); }
+        return *this;
+    }
+    Group& operator=(Group&& other) {
+        pool_ = other.pool_; name_ = other.name_; knobs_ = std::move(other.knobs_);
+        groups_ = std::move(other.groups_); live_ = std::move(other.live_);
+        ranges_ = std::move(other.ranges_); derived_ = std::move(other.derived_);
+        immutable_ = other.immutable_;
+        other.index_.clear(); other.graph_.reset(); relink();
+        root()->reindex();
+        return *this;
+    }
+
+    /// Copy sub-tree `other` as a child of `parent`, used by copy ctor.
+    Group(std::allocator_arg_t, const allocator_type& a,
+          const Group& other, Group* parent, Subtree):
+        pool_(other.pool_),name_(other.name_),knobs_(other.knobs_, a),
+        groups_(a),index_(a),live_(other.live_, a),ranges_(other.ranges_, a),
+        derived_(other.derived_, a),parent_(parent),
+        immutable_(other.immutable_)
+    {
+        for (const auto& [nm, g] : other.groups_) {
+            groups_.try_emplace(std::end(groups_), nm, g, this, Subtree{});
+        }
+    }
+
+    strv name() const {return name_;}
+
+    /// Pool that holds names and descriptions of the whole tree.
+    const StringPool::Ptr& pool() const {return pool_;}
+
+    allocator_type get_allocator() const {return knobs_.get_allocator();}
+
+    /** Add copy of `kb`, replace knob with the same name.
+     *
+     * Replaced live knob stays live, its readers and subscribers see the
+     * new value; throw `std::invalid_argument` if `kb` has another type.
+     */
     Group& addKnob(const Knob& kb){
-        knobs_.insert_or_assign(kb.name(), kb);
+        const strv name = pool_->intern(kb.name());
+        if (const auto c = live_.find(name); c != std::end(live_)) {
+            if (kb.type() != c->second.type) {
+                throw std::invalid_argument("knb::Group::addKnob: live knob '" + std::string(name) +
+                    "' can't change type id to " + std::to_string(kb.typeId()));
+            }
+            Knob& k = knobs_.find(name)->second;
+            k.desc_ = pool_->intern(kb.desc());
+            changeLive(k, kb.v);
+            return *this;
+        }
+        const auto old = knobs_.find(name);
+        const Fingerprint was = (old == std::end(knobs_))? Fingerprint() : hashOf(old->second);
+        auto [it, inserted] = knobs_.insert_or_assign(name, Knob(pool_, kb));
+        if (inserted) {
+            indexKnob(it->first, it->second);
+        } else {
+            overridden(it->second);
+        }
+        rehashed(was, hashOf(it->second));
         return *this;
     }
 
     template< class... Args >
-    Group& addKnob(const std::string& name, Args&&... args){
-        knobs_.try_emplace(name,name,args...);
+    Group& addKnob(strv name, Args&&... args){
+        const strv nm = pool_->intern(name);
+        if (auto [it, inserted] = knobs_.try_emplace(nm,pool_,nm,std::forward<Args>(args)...); inserted) {
+            indexKnob(it->first, it->second);
+            rehashed(Fingerprint(), hashOf(it->second));
+        }
         return *this;
     }
 
-    const Knob& at(const std::string& knobName) const {
-        return knobs_.at(knobName);
+    /** Add knob `name` computed by `compute` from knobs at `inputs` paths.
+     *
+     * Input paths are relative to this group; `compute(const DerivedInputs&)`
+     * gets the input knobs in the same order, its return type is the knob
+     * type (`const char*` gives String, `std::vector` gives an array knob).
+     * Value is computed on first read and kept until an input changes:
+     * ~~~{.cpp}
+     * g.addDerived("sets", {"size", "ways", "line"}, [](const knb::DerivedInputs& in) {
+     *     return in[0].asInt() / (in[1].asInt() * in[2].asInt());
+     * });
+     * ~~~
+     * If knob `name` exists, it is replaced. Changing a derived knob with
+     * `changeValue` or `addKnob` makes it an ordinary knob with that value.
+     * Inputs are resolved, and cycles found, by `finalize` or the first read.
+     * Handles from `bind` and knobs kept from earlier lookups show the value
+     * computed by the last lookup.
+     *
+     * Inputs can't be live knobs: after `finalize` and `evaluate` a derived
+     * value never changes, so other threads read it without locks.
+     * Resolving a live input throws `std::invalid_argument`.
+     *
+     * `compute` runs under the evaluation lock of this tree. It reads its
+     * inputs from `DerivedInputs` and must not re-enter trees: reading
+     * a derived knob of this tree works but hides the dependency, reading
+     * derived knobs of another tree can deadlock with its evaluation.
+     */
+    template <typename F>
+    Group& addDerived(strv name, std::vector<std::string> inputs, F compute, strv desc = "") {
+        using R = std::decay_t<std::invoke_result_t<F&, const DerivedInputs&>>;
+        using V = std::conditional_t<std::is_pointer_v<R>, std::string, R>;
+        static_assert(detail::valueIndex<V>() != std::variant_npos or
+                      std::is_same_v<V,std::vector<std::int64_t>> or std::is_same_v<V,std::vector<double>>,
+                      "derived knob value type is one of Knob::T types");
+        return addDerivedCell(Knob(pool_, name, detail::derivedValue(V{}), desc), std::move(inputs),
+            [f = std::move(compute)](const DerivedInputs& in) { return detail::derivedValue(f(in)); }, "");
     }
 
-    const Group& gr(const std::string& groupName) const {
-        return groups_.at(groupName);
+    /** Add knob `name` of numeric type `R` computed by expression `expr`.
+     *
+     * See expression.h, knob paths in `expr` are relative to this group:
+     * ~~~{.cpp}
+     * g.addDerived<int>("sets", "size / (ways * line)");
+     * ~~~
+     * Throw `std::invalid_argument` if `expr` is not an expression.
+     */
+    template <typename R>
+    Group& addDerived(strv name, strv expr, strv desc = "") {
+        static_assert(std::is_arithmetic_v<R> and not std::is_same_v<R,bool> and
+                      detail::valueIndex<R>() != std::variant_npos, "derived expression is a number");
+        using N = std::conditional_t<std::is_floating_point_v<R>, double, std::int64_t>;
+        auto e = std::make_shared<const detail::Expression<N>>(expr);
+        std::vector<std::string> inputs = e->inputs();
+        return addDerivedCell(Knob(pool_, name, detail::KnobValue(R()), desc), std::move(inputs),
+            [e](const DerivedInputs& in) {
+                N small[16]{};
+                std::vector<N> large(in.size() > 16? in.size() : 0);
+                N* args = large.empty()? small : large.data();
+                for (std::size_t i = 0; i < in.size(); ++i) args[i] = in.number<N>(i);
+                return detail::KnobValue(static_cast<R>(e->eval(args)));
+            }, std::string(expr));
     }
 
-    Group& getGroup(const std::string& groupName) {
+    /// Is knob `path` derived, see `addDerived`.
+    bool isDerived(strv path) const {
+        const auto [g, name] = locate(path);
+        return g != nullptr and not g->derived_.empty() and g->derived_.count(name) != 0;
+    }
+
+    /// Input paths, relative to this group, of derived knob `path`.
+    std::vector<std::string> derivedInputs(strv path) const {
+        std::vector<std::string> paths;
+        const auto [g, name] = locate(path);
+        if (g == nullptr) return paths;
+        if (const auto c = g->derived_.find(name); c != std::end(g->derived_)) {
+            const strv prefix = path.substr(0, path.size() - name.size());
+            for (const std::string& in : c->second.inputs) paths.push_back(std::string(prefix) + in);
+        }
+        return paths;
+    }
+
+    /** Compute derived knob `path` from `inputs` into `out`, nothing is kept.
+     *
+     * For views that override inputs without changing this tree,
+     * LayeredGroup and SweepPoint; `inputs` are knobs at `derivedInputs(path)`.
+     */
+    void derive(strv path, const DerivedInputs& inputs, Knob& out) const {
+        const auto [g, name] = locate(path);
+        const auto c = (g == nullptr)? std::end(derived_) : g->derived_.find(name);
+        if (g == nullptr or c == std::end(g->derived_)) {
+            throw std::invalid_argument("knb::Group::derive: knob '" + std::string(path) + "' is not derived");
+        }
+        out = g->knobs_.find(name)->second;
+        out.v = c->second.compute(inputs);
+    }
+
+    /** Compute all derived knobs of the tree that are not up to date.
+     *
+     * Name lookups and `visit` compute a derived knob when they return it;
+     * code that walks `knobs()` or `tree()` directly calls this first.
+     */
+    void evaluate() const {
+        const Group* r = root();
+        if (not r->hasDerived_) return;
+        std::lock_guard<std::recursive_mutex> lock(*r->derivedMutex_);
+        r->linkDerived();
+        for (detail::DerivedCell* c : r->graph_->cells) computeDerived(*c);
+    }
+
+    const Knob& at(strv knobName) const {
+        const Knob& k = profile::lookup([&]() -> const Knob& {return knobs_.at(knobName);});
+        if (not derived_.empty()) refresh(k);
+        return k;
+    }
+
+    /// Knob of this group (subgroups are not searched) or `nullptr`.
+    const Knob* find(strv knobName) const {
+        const Knob* k = profile::lookup([&]() -> const Knob* {
+            auto k = knobs_.find(knobName);
+            return (k == std::end(knobs_))? nullptr : &k->second;
+        });
+        if (k != nullptr and not derived_.empty()) refresh(*k);
+        return k;
+    }
+
+    const Group& gr(strv groupName) const {
+        return profile::lookup([&]() -> const Group& {return groups_.at(groupName);});
+    }
+
+    /// Subgroup of this group or `nullptr`.
+    const Group* findGroup(strv groupName) const {
+        return profile::lookup([&]() -> const Group* {
+            auto g = groups_.find(groupName);
+            return (g == std::end(groups_))? nullptr : &g->second;
+        });
+    }
+
+    /// Knob by path relative to this group or `nullptr`, see `atPath`.
+    const Knob* findPath(strv path) const {
+        const Group* g = this;
+        for (auto pos = path.find(':'); pos != strv::npos; pos = path.find(':')) {
+            if (g = g->findGroup(path.substr(0, pos)); g == nullptr) return nullptr;
+            path.remove_prefix(pos + 1);
+        }
+        return g->find(path);
+    }
+
+    /** Get knob by path relative to this group, like `"feature-A:A-val1"`.
+     *
+     * Throws `std::out_of_range` if any group or the knob does not exist.
+     */
+    const Knob& atPath(std::string_view path) const {
+        const Group* g = this;
+        for (auto pos = path.find(':'); pos != strv::npos; pos = path.find(':')) {
+            g = &g->gr(path.substr(0, pos));
+            path.remove_prefix(pos + 1);
+        }
+        return g->at(path);
+    }
+
+    /** Get typed handle to knob by path, see KnobHandle.
+     *
+     * ~~~{.cpp}
+     * KnobHandle<int> h = group.bind<int>("feature-A:A-val1");
+     * for (...) { use(h.get()); }
+     * ~~~
+     */
+    template <typename T>
+    KnobHandle<T> bind(std::string_view path) const {
+        return atPath(path).bind<T>();
+    }
+
+    /** Add knob that can be changed at any time, even after `finalize`.
+     *
+     * Live knob is an ordinary knob for `at`, `visit` and others, plus
+     * atomic copy of its value that readers get with `live<T>(path)`.
+     * Change it with `setLive` or `changeValue`, both call subscribers.
+     * If knob `name` exists, it becomes live with its current value.
+     * Only scalar numeric and Bool knobs can be live.
+     *
+     * Changes of live knobs of a tree are serialized, but the knob and
+     * the fingerprints are changed in place: while another thread may
+     * change the knob, read it only with `live<T>` readers or in
+     * subscribers, which get a copy. `at`, `visit`, `fingerprint` and
+     * handles from `bind` read it when no change runs.
+     */
+    template <typename T>
+    Group& addLiveKnob(strv name, T value, strv desc = "") {
+        static_assert(std::is_arithmetic_v<T> and detail::valueIndex<T>() != std::variant_npos,
+                      "live knob value type is scalar Knob::T type");
+        addKnob(name, value, desc);
+        return makeLive(name);
+    }
+
+    /// Get reader of live knob by path, throw `std::invalid_argument` if not live `T`.
+    template <typename T>
+    LiveKnob<T> live(strv path) const {
+        const auto [g, name] = splitPath(path);
+        const Knob& k = g->at(name);
+        const auto c = g->live_.find(name);
+        if (c == std::end(g->live_) or not std::holds_alternative<T>(k.v)) {
+            throw std::invalid_argument("knb::Group::live: knob '" + std::string(path) +
+                "' is not live or has type id " + std::to_string(k.typeId()));
+        }
+        return LiveKnob<T>(&c->second);
+    }
+
+    /// Change live knob by path and call its subscribers.
+    template <typename T>
+    void setLive(strv path, T value) {
+        const auto [g, name] = splitPath(path);
+        const Knob& k = g->at(name);
+        if (not g->live_.count(name) or not std::holds_alternative<T>(k.v)) {
+            throw std::invalid_argument("knb::Group::setLive: knob '" + std::string(path) +
+                "' is not live or has type id " + std::to_string(k.typeId()));
+        }
+        const_cast<Group*>(g)->changeLive(k, detail::KnobValue(std::in_place_type<T>, value));
+    }
+
+    /** Call `cb` after each change of live knob, return id for `unsubscribe`.
+     *
+     * Callbacks run in the thread that changes the knob.
+     */
+    std::size_t subscribe(strv path, std::function<void(const Knob&)> cb) {
+        detail::LiveCell& c = liveCell(path);
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.callbacks.emplace_back(c.nextId, std::move(cb));
+        return c.nextId++;
+    }
+
+    void unsubscribe(strv path, std::size_t id) {
+        detail::LiveCell& c = liveCell(path);
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.callbacks.erase(std::remove_if(std::begin(c.callbacks), std::end(c.callbacks),
+            [id](const auto& id_cb){return id_cb.first == id;}), std::end(c.callbacks));
+    }
+
+    Group& getGroup(strv groupName) {
         auto g = groups_.find(groupName);
         if (g == std::end(groups_)) {
-            auto [ig, inserted] = groups_.emplace(groupName,groupName);
+            const strv nm = pool_->intern(groupName);
+            auto [ig, inserted] = groups_.try_emplace(nm,pool_,nm);
+            if (inserted) {
+                ig->second.parent_ = this;
+                ig->second.path_ = detail::HashState(path_).add(nm).add(":");
+            }
             return (inserted)? ig->second : *this;
         }
         return g->second;
     }
 
-    std::tuple<bool,std::string,const Knob*> findKnob(const std::string& name) const
+    /** Find knob by leaf name anywhere in the sub-tree, no allocation.
+     *
+     * When several knobs have the same name, `KnobRef::ambiguous()`
+     * is true and `knob` is the one `findKnob` would return.
+     */
+    KnobRef lookup(strv name) const
+    {
+        KnobRef ref;
+        profile::lookup([&]{ ref = resolve(name); return ref.knob; });
+        if (ref and not ref.owner->derived_.empty()) ref.owner->refresh(*ref.knob);
+        return ref;
+    }
+
+    /// Path of the knob found by `lookup`, like `findKnob` returns.
+    std::string path(const KnobRef& ref) const
+    {
+        if (not ref) return "";
+        std::vector<const Group*> chain;
+        std::size_t len = ref.knob->name().size();
+        for (const Group* g = ref.owner; g != this and g != nullptr; g = g->parent_) {
+            chain.push_back(g); len += g->name_.size() + 1;
+        }
+        std::string p; p.reserve(len + name_.size() + 1);
+        p += name_;
+        for (auto g = chain.rbegin(); g != chain.rend(); ++g) { p += ':'; p += (*g)->name_; }
+        p += ':'; p += ref.knob->name();
+        return p;
+    }
+
+    std::tuple<bool,std::string,const Knob*> findKnob(strv name) const
+    {
+        std::tuple<bool,std::string,const Knob*> res(false, "", nullptr);
+        KnobRef ref;
+        profile::lookup([&]{
+            if (ref = resolve(name); ref) res = std::make_tuple(true, path(ref), ref.knob);
+            return ref.knob;
+        });
+        if (ref and not ref.owner->derived_.empty()) ref.owner->refresh(*ref.knob);
+        return res;
+    }
+
+    /** Call `visitor` for every knob of the sub-tree, depth-first.
+     *
+     * Own knobs are visited before knobs of subgroups, both in name order.
+     * Visitor is `f(const Knob&)` or `f(const Knob&, const Group& owner)`;
+     * if it returns `bool`, `false` stops the traversal.
+     *
+     * @return false if the traversal was stopped
+     */
+    template <typename F>
+    bool visit(F&& visitor) const
+    {
+        for (const auto& name_knob : knobs_) {
+            if (not derived_.empty()) refresh(name_knob.second);
+            if (not detail::visitKnob(visitor, name_knob.second, *this)) return false;
+        }
+        for (const auto& name_group : groups_) {
+            if (not name_group.second.visit(visitor)) return false;
+        }
+        return true;
+    }
+
+    using KnobIterator  = detail::ValueIterator<std::pmr::map<strv,Knob>::const_iterator, Knob>;
+    using GroupIterator = detail::ValueIterator<std::pmr::map<strv,Group>::const_iterator, Group>;
+
+    /// Own knobs of this group, in name order.
+    detail::Range<KnobIterator> knobs() const {
+        return {KnobIterator(std::begin(knobs_)), KnobIterator(std::end(knobs_))};
+    }
+
+    /// Own subgroups of this group, in name order.
+    detail::Range<GroupIterator> groups() const {
+        return {GroupIterator(std::begin(groups_)), GroupIterator(std::end(groups_))};
+    }
+
+    /// Parent group, `nullptr` for the root.
+    const Group* parent() const {return parent_;}
+
+    /** Depth-first iterator over knobs of a sub-tree, same order as `visit`.
+     *
+     * Iterator is two pointers, it does not allocate; current path is
+     * given by `owner()` and its parents up to the top of the traversal.
+     */
+    class TreeIterator
     {
-        if (const auto knob = knobs_.find(name); knob != std::end(knobs_)) {
-            return std::make_tuple(true, name_+":"+name, &(knob->second));
+        const Group* top_{nullptr};
+        const Group* g_{nullptr}; ///< `nullptr` at the end
+        std::pmr::map<strv,Knob>::const_iterator k_;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Knob;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Knob*;
+        using reference = const Knob&;
+
+        TreeIterator() = default;
+        explicit TreeIterator(const Group* top):top_(top),g_(top),k_(std::begin(top->knobs_)) {
+            settle();
+        }
+
+        reference operator*() const {return k_->second;}
+        pointer operator->() const {return &k_->second;}
+        TreeIterator& operator++() {++k_; settle(); return *this;}
+        TreeIterator operator++(int) {TreeIterator old = *this; ++*this; return old;}
+        bool operator==(const TreeIterator& other) const {
+            return g_ == other.g_ and (g_ == nullptr or k_ == other.k_);
+        }
+        bool operator!=(const TreeIterator& other) const {return not (*this == other);}
+
+        /// Group that holds current knob.
+        const Group& owner() const {return *g_;}
+
+        /// Number of groups between the top and the owner.
+        std::size_t depth() const {
+            std::size_t d = 0;
+            for (const Group* g = g_; g != top_; g = g->parent_) ++d;
+            return d;
+        }
+
+        /// Append path relative to the top, like `"a:b:knob"`, to `out`.
+        void appendPath(std::string& out) const {
+            appendGroups(g_, out);
+            out += k_->first;
         }
 
-        for (const auto& kv : groups_) {
-            if (auto [foundInSubgr, path, knob] = kv.second.findKnob(name); foundInSubgr) {
-                return std::make_tuple(true, name_+":"+path, knob);
+    private:
+        void appendGroups(const Group* g, std::string& out) const {
+            if (g == top_) return;
+            appendGroups(g->parent_, out);
+            out += g->name_; out += ':';
+        }
+
+        /// Move to the next knob in visit order if current group has no more.
+        void settle() {
+            while (g_ != nullptr and k_ == std::end(g_->knobs_)) {
+                if (not g_->groups_.empty()) {
+                    g_ = &std::begin(g_->groups_)->second;
+                } else {
+                    while (g_ != top_) {
+                        const Group* p = g_->parent_;
+                        auto next = std::next(p->groups_.find(g_->name_));
+                        if (next != std::end(p->groups_)) { g_ = &next->second; break; }
+                        g_ = p;
+                    }
+                    if (g_ == top_) { g_ = nullptr; return; }
+                }
+                k_ = std::begin(g_->knobs_);
             }
         }
+    };
+
+    /// All knobs of the sub-tree, depth-first; `break` stops early.
+    detail::Range<TreeIterator> tree() const {
+        return {TreeIterator(this), TreeIterator()};
+    }
+
+    /** Make the group immutable, only live knobs change after it.
+     *
+     * Throw `std::invalid_argument` if an input of a derived knob does
+     * not exist or derived knobs depend on each other in a cycle.
+     */
+    void finalize() {
+        if (const Group* r = root(); r->hasDerived_) {
+            std::lock_guard<std::recursive_mutex> lock(*r->derivedMutex_);
+            r->linkDerived();
+            r->checkCycles();
+        }
+        immutable_ = true;
+    }
+
+    /// Error of `changeValue` of a knob of immutable group.
+    static constexpr const char* immutableError = "group is immutable";
+
+    /** Change knob value from text, see `codec::decode` for formats.
+     *
+     * Numbers are checked against the range set with `constrain`.
+     * On error the knob keeps its value. Immutable group, after
+     * `finalize` or made so, keeps values of knobs that are not live
+     * and returns `immutableError` after the value is checked.
+     */
+    Status changeValue(const Knob* knob, strv s){
+        Group* owner = root()->holder(knob);
+        const bool live = owner != nullptr and owner->live_.count(knob->name()) != 0;
+        const Range* r = (owner == nullptr)? nullptr : owner->rangeOf(knob->name());
+        detail::KnobValue v;
+        const Status st = knob->decode(s, r? *r : Range(), v);
+        if (not st) return st;
+        if (live) {
+            owner->changeLive(*knob, std::move(v));
+            return st;
+        }
+        if (immutable_) return Status(immutableError);
+        const Fingerprint was = (owner == nullptr)? Fingerprint() : owner->hashOf(*knob);
+        const_cast<Knob*>(knob)->v = std::move(v);
+        if (owner != nullptr) {
+            owner->overridden(*knob);
+            owner->rehashed(was, owner->hashOf(*knob));
+        }
+        return st;
+    }
+
+    /** Restrict values of numeric knob `path` to `r`, also sets its unit.
+     *
+     * Range of array knob applies to each element. Throw
+     * `std::invalid_argument` if the knob is not a number or an array
+     * or its current value is outside of `r`.
+     */
+    Group& constrain(strv path, const Range& r) {
+        const auto [g, name] = splitPath(path);
+        const Knob& k = g->at(name);
+        const bool in = std::visit([&](const auto& x) {
+            using V = std::decay_t<decltype(x)>;
+            if constexpr (std::is_same_v<V,bool> or std::is_same_v<V,std::string>) return false;
+            else if constexpr (std::is_arithmetic_v<V>) return r.contains(static_cast<double>(x));
+            else return std::all_of(x.begin(), x.end(), [&](auto e){ return r.contains(static_cast<double>(e)); });
+        }, k.v);
+        if (not in) {
+            throw std::invalid_argument("knb::Group::constrain: knob '" + std::string(path) +
+                "' is not a number in range");
+        }
+        const_cast<Group*>(g)->ranges_.insert_or_assign(k.name(), r);
+        return *this;
+    }
+
+    /// Range of knob `path` set with `constrain` or `nullptr`.
+    const Range* range(strv path) const {
+        const auto [g, name] = splitPath(path);
+        return g->rangeOf(name);
+    }
+
+    /** Content hash of the sub-tree: paths, types and values of its knobs.
+     *
+     * Paths are taken from the root, so equal trees built in any order,
+     * in any run, have equal fingerprints; empty groups do not count.
+     * It is kept up to date by `addKnob`, `changeValue` and `setLive`,
+     * getting it costs nothing. Derived knob adds its expression (empty
+     * for callables) instead of its value, which follows from its inputs.
+     */
+    const Fingerprint& fingerprint() const {return fingerprint_;}
+
+    /** Part of `fingerprint()` that knob `path` with the value of `k` adds.
+     *
+     * Fingerprint of the tree with a different value of one knob, without
+     * changing it: `fingerprint() - knobFingerprint(p, at(p)) + knobFingerprint(p, other)`.
+     * Derived knob adds its type and expression, not its value, so `k` does not matter.
+     */
+    Fingerprint knobFingerprint(strv path, const Knob& k) const {
+        const auto [g, name] = splitPath(path);
+        if (not g->derived_.empty() and g->derived_.count(name) != 0) return g->hashOf(g->knobs_.find(name)->second);
+        return k.hashed(detail::HashState(g->path_).add(name));
+    }
+
+private:
+    Group* root() {
+        Group* g = this;
+        while (g->parent_ != nullptr) g = g->parent_;
+        return g;
+    }
+    const Group* root() const {return const_cast<Group*>(this)->root();}
+
+    /// Group of the path `"a:b:knob"` and the knob name, group is `nullptr` if it does not exist; not profiled.
+    std::pair<const Group*,strv> locate(strv path) const {
+        const Group* g = this;
+        for (auto pos = path.find(':'); pos != strv::npos; pos = path.find(':')) {
+            const auto sub = g->groups_.find(path.substr(0, pos));
+            if (sub == std::end(g->groups_)) return {nullptr, path};
+            g = &sub->second;
+            path.remove_prefix(pos + 1);
+        }
+        return {g, path};
+    }
+
+    /// Group of the path `"a:b:knob"` and the knob name.
+    std::pair<const Group*,strv> splitPath(strv path) const {
+        const auto pos = path.rfind(':');
+        if (pos == strv::npos) return {this, path};
+        const Group* g = this;
+        for (strv groups = path.substr(0, pos); not groups.empty();) {
+            const auto p = groups.find(':');
+            g = &g->gr(groups.substr(0, p));
+            groups = (p == strv::npos)? strv() : groups.substr(p + 1);
+        }
+        return {g, path.substr(pos + 1)};
+    }
+
+    const Range* rangeOf(strv name) const {
+        if (ranges_.empty()) return nullptr;
+        const auto r = ranges_.find(name);
+        return (r == std::end(ranges_))? nullptr : &r->second;
+    }
+
+    detail::LiveCell& liveCell(strv path) {
+        const auto [g, name] = splitPath(path);
+        const auto c = const_cast<Group*>(g)->live_.find(name);
+        if (c == std::end(g->live_)) {
+            throw std::invalid_argument("knb::Group: knob '" + std::string(path) + "' is not live");
+        }
+        return c->second;
+    }
+
+    /** Give live knob `k` of this group value `v`, publish it to readers and subscribers.
+     *
+     * Changes of live knobs of the tree are serialized; subscribers are
+     * called after the lock is released, with a copy of the knob.
+     */
+    void changeLive(const Knob& k, detail::KnobValue v) {
+        detail::LiveCell& c = live_.find(k.name())->second;
+        Knob now;
+        {
+            std::lock_guard<std::mutex> lock(*root()->liveMutex_);
+            const Fingerprint was = hashOf(k);
+            const_cast<Knob&>(k).v = std::move(v);
+            overridden(k);
+            rehashed(was, hashOf(k));
+            c.store(k);
+            now = k;
+        }
+        c.notify(now);
+    }
 
-        return std::make_tuple(false, "", nullptr);
+    /// Group of the sub-tree that holds `knob`.
+    Group* holder(const Knob* knob) {
+        if (auto ref = resolve(knob->name()); ref.knob == knob) return const_cast<Group*>(ref.owner);
+        return search(knob);
     }
 
-    void visit(std::function<void(const Knob&)> visitor) const
+    Group* search(const Knob* knob) {
+        if (auto k = knobs_.find(knob->name()); k != std::end(knobs_) and &k->second == knob) {
+            return this;
+        }
+        for (auto& name_group : groups_) {
+            if (Group* g = name_group.second.search(knob)) return g;
+        }
+        return nullptr;
+    }
+
+    /// Lookup by the root index, see `lookup`; not counted by the profiler.
+    KnobRef resolve(strv name) const
     {
-        for (const auto& name_knob : knobs_) visitor(name_knob.second);
-        for (const auto& name_group : groups_) name_group.second.visit(visitor);
+        const Group* r = root();
+        const auto e = r->index_.find(name);
+        if (e == std::end(r->index_)) return KnobRef{};
+        const KnobRef ref{e->second.knob, e->second.owner, e->second.matches};
+        if (r == this) return ref;
+        if (ref.matches == 1) return contains(ref.owner)? ref : KnobRef{};
+        KnobRef sub; scan(name, sub);
+        return sub;
+    }
+
+    /// Hash of own knob `k` with its path.
+    Fingerprint hashOf(const Knob& k) const {
+        detail::HashState h(path_);
+        h.add(k.name());
+        if (not derived_.empty()) {
+            if (const auto c = derived_.find(k.name()); c != std::end(derived_)) {
+                // value follows from the inputs, hash how it is computed
+                const char type = static_cast<char>(k.typeId());
+                return h.add("=").add(strv(&type, 1)).add(c->second.formula).finish();
+            }
+        }
+        return k.hashed(h);
+    }
+
+    /// Add knob `k` and make it derived, see `addDerived`.
+    Group& addDerivedCell(const Knob& k, std::vector<std::string> inputs,
+                          detail::DerivedCell::Compute compute, std::string formula) {
+        addKnob(k);
+        const auto it = knobs_.find(k.name());
+        const Fingerprint was = hashOf(it->second);
+        Group* r = root();
+        r->dropGraph();
+        r->setHasDerived(true);
+        derived_.insert_or_assign(it->first,
+            detail::DerivedCell(std::move(inputs), std::move(compute), std::move(formula)));
+        rehashed(was, hashOf(it->second));
+        return *this;
+    }
+
+    /// Compute derived knob `k` of this group unless its value is up to date.
+    void refresh(const Knob& k) const {
+        const auto c = derived_.find(k.name());
+        if (c == std::end(derived_) or c->second.valid.load(std::memory_order_acquire)) return;
+        const Group* r = root();
+        std::lock_guard<std::recursive_mutex> lock(*r->derivedMutex_);
+        r->linkDerived();
+        computeDerived(const_cast<detail::DerivedCell&>(c->second));
+    }
+
+    /// Compute `c` after its derived inputs, caller holds `derivedMutex_` of the root.
+    static void computeDerived(detail::DerivedCell& c) {
+        if (c.valid.load(std::memory_order_relaxed)) return;
+        if (c.evaluating) {
+            throw std::invalid_argument("knb::Group: derived knob '" + std::string(c.knob->name()) +
+                "' depends on itself");
+        }
+        c.evaluating = true;
+        try {
+            for (detail::DerivedCell* in : c.argCells) {
+                if (in != nullptr) computeDerived(*in);
+            }
+            c.knob->v = c.compute(DerivedInputs(c.args.data(), c.args.size()));
+        } catch (...) {
+            c.evaluating = false;
+            throw;
+        }
+        c.evaluating = false;
+        c.valid.store(true, std::memory_order_release);
+    }
+
+    /// Build dependency graph of derived knobs of the tree if there is none, root only.
+    void linkDerived() const {
+        if (graph_) return;
+        auto graph = std::make_unique<detail::DerivedGraph>();
+        collectDerived(*graph);
+        graph_ = std::move(graph);
+    }
+
+    /// Resolve inputs of derived knobs of the sub-tree and add them to `graph`.
+    void collectDerived(detail::DerivedGraph& graph) const {
+        for (const auto& [name, cell] : derived_) {
+            auto& c = const_cast<detail::DerivedCell&>(cell);
+            c.knob = const_cast<Knob*>(&knobs_.find(name)->second);
+            c.args.clear();
+            c.argCells.clear();
+            for (const std::string& in : c.inputs) {
+                const Knob* k = nullptr;
+                const detail::DerivedCell* d = nullptr;
+                bool live = false;
+                if (const auto [g, leaf] = locate(in); g != nullptr) {
+                    if (const auto it = g->knobs_.find(leaf); it != std::end(g->knobs_)) k = &it->second;
+                    if (const auto it = g->derived_.find(leaf); it != std::end(g->derived_)) d = &it->second;
+                    live = g->live_.count(leaf) != 0;
+                }
+                if (k == nullptr) {
+                    throw std::invalid_argument("knb::Group: input '" + in + "' of derived knob '" +
+                        std::string(name) + "' does not exist");
+                }
+                if (live) {
+                    throw std::invalid_argument("knb::Group: input '" + in + "' of derived knob '" +
+                        std::string(name) + "' is live");
+                }
+                c.args.push_back(k);
+                c.argCells.push_back(const_cast<detail::DerivedCell*>(d));
+                graph.dependents[k].push_back(&c);
+            }
+            graph.cells.push_back(&c);
+        }
+        for (const auto& name_group : groups_) name_group.second.collectDerived(graph);
+    }
+
+    /// Throw `std::invalid_argument` if derived knobs of the graph form a cycle, root only.
+    void checkCycles() const {
+        std::unordered_map<const detail::DerivedCell*,int> state; // 1 on the path, 2 done
+        std::vector<const detail::DerivedCell*> path;
+        for (const detail::DerivedCell* c : graph_->cells) checkCycles(c, state, path);
+    }
+
+    static void checkCycles(const detail::DerivedCell* c,
+                            std::unordered_map<const detail::DerivedCell*,int>& state,
+                            std::vector<const detail::DerivedCell*>& path) {
+        if (const int s = state[c]; s == 2) {
+            return;
+        } else if (s == 1) {
+            std::string cycle;
+            for (auto it = std::find(std::begin(path), std::end(path), c); it != std::end(path); ++it) {
+                cycle += (*it)->knob->name(); cycle += " -> ";
+            }
+            cycle += c->knob->name();
+            throw std::invalid_argument("knb::Group: derived knobs form a cycle: " + cycle);
+        }
+        state[c] = 1;
+        path.push_back(c);
+        for (const detail::DerivedCell* in : c->argCells) {
+            if (in != nullptr) checkCycles(in, state, path);
+        }
+        path.pop_back();
+        state[c] = 2;
+    }
+
+    /** Own knob `k` got a new value: derived knob becomes ordinary,
+     *  derived knobs that read it are computed again on next read.
+     */
+    void overridden(const Knob& k) {
+        Group* r = root();
+        if (not r->hasDerived_) return;
+        std::lock_guard<std::recursive_mutex> lock(*r->derivedMutex_);
+        if (const auto c = derived_.find(k.name()); c != std::end(derived_)) {
+            r->dropGraph();
+            derived_.erase(c);
+        } else if (r->graph_) {
+            r->invalidate(&k);
+        }
+    }
+
+    /// Mark derived knobs that read `k`, directly or not, out of date, root only.
+    void invalidate(const Knob* k) {
+        const auto d = graph_->dependents.find(k);
+        if (d == std::end(graph_->dependents)) return;
+        for (detail::DerivedCell* c : d->second) {
+            // out of date cell has no up to date dependents
+            if (c->valid.load(std::memory_order_relaxed)) {
+                c->valid.store(false, std::memory_order_relaxed);
+                invalidate(c->knob);
+            }
+        }
+    }
+
+    /// Tree has derived knobs, create the mutex that guards them, root only.
+    void setHasDerived(bool derived) {
+        hasDerived_ = derived;
+        if (derived and not derivedMutex_) derivedMutex_ = std::make_unique<std::recursive_mutex>();
+    }
+
+    /// Make existing scalar knob `name` live.
+    Group& makeLive(strv name) {
+        auto k = knobs_.find(name);
+        live_.try_emplace(k->first, k->second);
+        root()->setHasLive();
+        if (Group* r = root(); r->hasDerived_) {
+            // derived knobs that read it are refused when they are resolved again
+            std::lock_guard<std::recursive_mutex> lock(*r->derivedMutex_);
+            r->dropGraph();
+        }
+        return *this;
+    }
+
+    /// Tree has live knobs, create the mutex that serializes their changes, root only.
+    void setHasLive() {
+        if (not liveMutex_) liveMutex_ = std::make_unique<std::mutex>();
+    }
+
+    /// Has this sub-tree live knobs.
+    bool hasLive() const {
+        if (not live_.empty()) return true;
+        for (const auto& name_group : groups_) {
+            if (name_group.second.hasLive()) return true;
+        }
+        return false;
+    }
+
+    /// Forget dependency graph and all derived values after a change of derived knobs, root only.
+    void dropGraph() {
+        if (not graph_) return;
+        for (detail::DerivedCell* c : graph_->cells) c->valid.store(false, std::memory_order_relaxed);
+        graph_.reset();
     }
 
-    void finalize() { immutable_ = true; }
+    /// Replace hash `was` of a knob of this group with `now` up to the root.
+    void rehashed(const Fingerprint& was, const Fingerprint& now) {
+        for (Group* g = this; g != nullptr; g = g->parent_) {
+            g->fingerprint_ -= was;
+            g->fingerprint_ += now;
+        }
+    }
+
+    /** Recompute paths and fingerprints of the sub-tree at `path`, forget derived values.
+     *
+     * @return true if the sub-tree has derived knobs
+     */
+    bool rehashTree(const detail::HashState& path) {
+        path_ = path;
+        fingerprint_ = Fingerprint();
+        for (const auto& name_knob : knobs_) fingerprint_ += hashOf(name_knob.second);
+        for (auto& name_cell : derived_) name_cell.second.valid.store(false, std::memory_order_relaxed);
+        bool derived = not derived_.empty();
+        for (auto& [name, g] : groups_) {
+            derived = g.rehashTree(detail::HashState(path_).add(name).add(":")) or derived;
+            fingerprint_ += g.fingerprint_;
+        }
+        return derived;
+    }
+
+    /// Is group `g` this group or its descendant.
+    bool contains(const Group* g) const {
+        while (g != nullptr and g != this) g = g->parent_;
+        return g == this;
+    }
+
+    /// Add new knob `kb` of this group to the index of the root.
+    void indexKnob(strv name, const Knob& kb) {
+        Group* r = root();
+        auto [e, inserted] = r->index_.try_emplace(name, IndexEntry{&kb, this, 1});
+        if (not inserted) {
+            ++e->second.matches;
+            if (r->visitsBefore(this, e->second.owner)) {
+                e->second.knob = &kb; e->second.owner = this;
+            }
+        }
+    }
+
+    /// Is knob of group `a` visited before knob of group `b`, both in sub-tree.
+    bool visitsBefore(const Group* a, const Group* b) const {
+        if (a == this or b == this) return a == this;
+        auto childOf = [](const Group* g, const Group* top) {
+            while (g->parent_ != top) g = g->parent_;
+            return g;
+        };
+        const Group* ca = childOf(a, this);
+        const Group* cb = childOf(b, this);
+        return (ca == cb)? ca->visitsBefore(a, b) : ca->name_ < cb->name_;
+    }
+
+    /// Search sub-tree without index, first match in visit order.
+    void scan(strv name, KnobRef& ref) const {
+        if (auto k = knobs_.find(name); k != std::end(knobs_)) {
+            if (not ref) { ref.knob = &k->second; ref.owner = this; }
+            ++ref.matches;
+        }
+        for (const auto& name_group : groups_) name_group.second.scan(name, ref);
+    }
+
+    /// Point children to this group, only root has index.
+    void relink() {
+        for (auto& name_group : groups_) {
+            name_group.second.parent_ = this;
+            name_group.second.index_.clear();
+        }
+    }
+
+    /// Rebuild index, fingerprints and derived knobs graph of the whole tree, only root has them.
+    void reindex() {
+        index_.clear();
+        graph_.reset();
+        if (parent_ == nullptr) {
+            indexTree(*this);
+            setHasDerived(rehashTree(detail::HashState()));
+            if (hasLive()) setHasLive();
+        }
+    }
 
-    void changeValue(const Knob* knob, const std::string& s){
-        if (immutable_) return;
-        Knob* mutant = const_cast<Knob*>(knob);
-        switch (mutant->type()){
-        case Knob::T::Bool:   mutant->v = !s.empty(); break;
-        case Knob::T::Int:    mutant->v = std::stoi(s); break;
-        case Knob::T::Float:  mutant->v = std::stof(s); break;
-        case Knob::T::String: mutant->v = s; break; 
+    void indexTree(const Group& g) {
+        for (const auto& [name, knob] : g.knobs_) {
+            auto [e, inserted] = index_.try_emplace(name, IndexEntry{&knob, &g, 1});
+            if (not inserted) ++e->second.matches;
         }
+        for (const auto& name_group : g.groups_) indexTree(name_group.second);
     }
 };
 
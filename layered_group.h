@@ -0,0 +1,276 @@
+/**
+ * @file
+ * @brief     LayeredGroup - stack of Group overlays resolved without copying
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Effective configuration usually comes from several sources:
+ * compiled defaults, site file, per-run file, environment, argv.
+ * Each source is a Group layer with only the knobs it sets, layers
+ * are stacked and a knob is taken from the topmost layer that has it:
+ * ~~~{.cpp}
+ * knb::LayeredGroup config("config");
+ * config.push(defaults, "defaults").push(site, "site").push(args, "argv");
+ * int max = config.at("max").asInt();          // from argv if set there
+ * std::cout << config.label(config.layerOf("max")); // "argv"
+ * knb::FrozenGroup frozen(config.flatten());   // merge once for hot lookups
+ * ~~~
+ * Layers are referenced, not copied; they must outlive the LayeredGroup.
+ * Names of the layer root groups are ignored, paths are relative to them.
+ *
+ * Derived knob (see `Group::addDerived`) of a layer is computed from
+ * the effective inputs, so an override in an upper layer is seen by
+ * derived knobs of lower layers; the value is kept until one of its
+ * inputs changes. `at` and `find` return the kept knob, and the first
+ * read after an input changed computes it again in place, like
+ * `Group::changeValue` changes a knob in place: a thread must not hold
+ * such a reference while layers change and other threads read. `value`
+ * returns a copy and is safe then.
+ */
+#pragma once
+#ifndef KNOBCPP_LAYERED_GROUP_H_INCLUDED
+#define KNOBCPP_LAYERED_GROUP_H_INCLUDED
+
+#include <mutex>
+#include <ostream>
+
+#include "knob.h"
+
+namespace knb {
+
+class LayeredGroup
+{
+    struct Layer {
+        const Group* group;
+        std::string label;
+    };
+
+    /// Derived knob computed over the layers and the inputs it was computed from.
+    struct Derived {
+        Knob value;
+        std::vector<Knob> inputs;
+        bool computed{false};
+    };
+
+    /// Values of derived knobs, copy of LayeredGroup starts with none.
+    struct DerivedMemo {
+        std::recursive_mutex mutex; ///< `value` holds it while inputs are computed
+        std::map<std::string,Derived,std::less<>> values;
+
+        DerivedMemo() = default;
+        DerivedMemo(const DerivedMemo&) {}
+        DerivedMemo& operator=(const DerivedMemo&) {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            values.clear();
+            return *this;
+        }
+    };
+
+    std::string name_;
+    std::vector<Layer> layers_; ///< bottom to top
+    mutable DerivedMemo derived_;
+
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit LayeredGroup(std::string name):name_(std::move(name)){}
+
+    const std::string& name() const {return name_;}
+
+    /// Put `layer` on top of the stack; label defaults to its name.
+    LayeredGroup& push(const Group& layer, strv label = "") {
+        layers_.push_back(Layer{&layer, std::string(label.empty()? layer.name() : label)});
+        return *this;
+    }
+
+    /// Number of layers.
+    std::size_t size() const {return layers_.size();}
+
+    const Group& layer(std::size_t i) const {return *layers_.at(i).group;}
+    const std::string& label(std::size_t i) const {return layers_.at(i).label;}
+
+    /// Knob by path from the topmost layer that has it or `nullptr`.
+    const Knob* find(strv path) const {
+        const std::size_t i = layerOf(path);
+        if (i == npos) return nullptr;
+        const Group& g = *layers_[i].group;
+        return g.isDerived(path)? derived(g, path) : g.findPath(path);
+    }
+
+    /// Knob by path, throw `std::out_of_range` if no layer has it.
+    const Knob& at(strv path) const {
+        if (const Knob* k = find(path)) return *k;
+        throw std::out_of_range("knb::LayeredGroup::at: " + std::string(path));
+    }
+
+    /// Copy of knob `path`, derived knob is copied under the memo lock; throw like `at`.
+    Knob value(strv path) const {
+        const std::size_t i = layerOf(path);
+        if (i == npos) throw std::out_of_range("knb::LayeredGroup::value: " + std::string(path));
+        const Group& g = *layers_[i].group;
+        if (not g.isDerived(path)) return *g.findPath(path);
+        std::lock_guard<std::recursive_mutex> lock(derived_.mutex);
+        return *derived(g, path);
+    }
+
+    /// Index of the topmost layer that has knob `path` or `npos`, for auditing.
+    std::size_t layerOf(strv path) const {
+        for (std::size_t i = layers_.size(); i-- > 0;) {
+            if (layers_[i].group->findPath(path) != nullptr) return i;
+        }
+        return npos;
+    }
+
+    /** Find knob by leaf name, first match in `visit` order.
+     *
+     * Path starts with the name of the LayeredGroup, like `Group::findKnob`,
+     * the knob is the one `at` returns for the path. Walks the merged tree.
+     */
+    std::tuple<bool,std::string,const Knob*> findKnob(strv name) const {
+        std::vector<const Group*> level;
+        for (const Layer& l : layers_) level.push_back(l.group);
+        std::string path, found;
+        const Knob* knob = nullptr;
+        merge(level,
+            [&](const Knob& k, std::size_t i){
+                if (knob != nullptr or k.name() != name) return;
+                knob = &effective(k, i, path);
+                found = name_ + ':' + path + std::string(name);
+            },
+            [&](strv g){ path.append(g); path += ':'; },
+            [&]{ path.erase(path.rfind(':', path.size() - 2) + 1); });
+        return std::make_tuple(knob != nullptr, found, knob);
+    }
+
+    /** Visit effective knobs in the same order as `Group::visit`.
+     *
+     * Each path is visited once, with the knob of the topmost layer.
+     */
+    template <typename F>
+    void visit(F&& visitor) const {
+        std::vector<const Group*> level;
+        for (const Layer& l : layers_) level.push_back(l.group);
+        std::string path;
+        merge(level,
+            [&](const Knob& k, std::size_t i){ visitor(effective(k, i, path)); },
+            [&](strv g){ path.append(g); path += ':'; },
+            [&]{ path.erase(path.rfind(':', path.size() - 2) + 1); });
+    }
+
+    /// Print `path = value  # layer` for every effective knob.
+    void audit(std::ostream& o) const {
+        std::vector<const Group*> level;
+        for (const Layer& l : layers_) level.push_back(l.group);
+        std::string path;
+        merge(level,
+            [&](const Knob& k, std::size_t i){
+                o << path << k.name() << " = " << effective(k, i, path).asString() << "  # " << layers_[i].label << '\n';
+            },
+            [&](strv g){ path.append(g); path += ':'; },
+            [&]{ path.erase(path.rfind(':', path.size() - 2) + 1); });
+    }
+
+    /** Merge layers into one finalized Group.
+     *
+     * Do it once when lookups are hot, `FrozenGroup(layered.flatten())`
+     * gives O(1) lookups. Derived knobs stay derived in the merged tree.
+     * Knob is live if it is live in the layer it is taken from, and it
+     * keeps the range of the topmost layer that constrains its path;
+     * throw `std::invalid_argument` if its value is outside that range.
+     * Subscribers of live knobs are not carried over.
+     */
+    Group flatten() const {
+        Group root(name_);
+        std::vector<Group*> stack{&root};
+        std::vector<const Group*> level;
+        for (const Layer& l : layers_) level.push_back(l.group);
+        std::string path;
+        merge(level,
+            [&](const Knob& k, std::size_t i){
+                const Group* owner = layers_[i].group;
+                const std::string p = path + std::string(k.name());
+                const auto [g, name] = owner->locate(p);
+                if (const auto c = g->derived_.find(name); c != std::end(g->derived_)) {
+                    stack.back()->addDerivedCell(k, c->second.inputs, c->second.compute, c->second.formula);
+                } else {
+                    Group& to = *stack.back();
+                    to.addKnob(k);
+                    if (g->live_.count(name) != 0) to.makeLive(k.name());
+                    if (const Range* r = rangeOf(p)) to.constrain(k.name(), *r);
+                }
+            },
+            [&](strv g){ stack.push_back(&stack.back()->getGroup(g)); path.append(g); path += ':'; },
+            [&]{ stack.pop_back(); path.erase(path.rfind(':', path.size() - 2) + 1); });
+        root.finalize();
+        return root;
+    }
+
+private:
+    /// Knob `k` of layer `i` at `path`, computed over the layers if it is derived.
+    const Knob& effective(const Knob& k, std::size_t i, const std::string& path) const {
+        const Group& g = *layers_[i].group;
+        const std::string p = path + std::string(k.name());
+        return g.isDerived(p)? *derived(g, p) : k;
+    }
+
+    /// Range of `path` from the topmost layer that constrains it or `nullptr`.
+    const Range* rangeOf(strv path) const {
+        for (std::size_t i = layers_.size(); i-- > 0;) {
+            const auto [g, name] = layers_[i].group->locate(path);
+            if (g == nullptr) continue;
+            if (const Range* r = g->rangeOf(name)) return r;
+        }
+        return nullptr;
+    }
+
+    /// Derived knob `path` of layer `g` with inputs from the topmost layers.
+    const Knob* derived(const Group& g, strv path) const {
+        std::vector<const Knob*> args;
+        for (const std::string& in : g.derivedInputs(path)) args.push_back(&at(in));
+        std::lock_guard<std::recursive_mutex> lock(derived_.mutex);
+        Derived& d = derived_.values[std::string(path)];
+        const bool same = d.computed and d.inputs.size() == args.size() and
+            std::equal(std::begin(args), std::end(args), std::begin(d.inputs),
+                       [](const Knob* a, const Knob& b){ return *a == b; });
+        if (not same) {
+            g.derive(path, DerivedInputs(args.data(), args.size()), d.value);
+            d.inputs.clear();
+            for (const Knob* a : args) d.inputs.push_back(*a);
+            d.computed = true;
+        }
+        return &d.value;
+    }
+
+    /** Walk merged tree: knobs of a level first, then subgroups, by name.
+     *
+     * `level[i]` is the group of layer `i` at this level or `nullptr`.
+     */
+    template <typename OnKnob, typename Enter, typename Leave>
+    static void merge(const std::vector<const Group*>& level,
+                      const OnKnob& onKnob, const Enter& enter, const Leave& leave)
+    {
+        std::map<strv,std::size_t> knobs; // name to topmost layer
+        std::map<strv,bool> groups;
+        for (std::size_t i = 0; i < level.size(); ++i) {
+            if (level[i] == nullptr) continue;
+            for (const auto& name_knob : level[i]->knobs_) knobs[name_knob.first] = i;
+            for (const auto& name_group : level[i]->groups_) groups[name_group.first] = true;
+        }
+        for (const auto& [name, i] : knobs) onKnob(level[i]->knobs_.find(name)->second, i);
+
+        std::vector<const Group*> sub(level.size());
+        for (const auto& name_group : groups) {
+            const strv name = name_group.first;
+            for (std::size_t i = 0; i < level.size(); ++i) {
+                sub[i] = (level[i] == nullptr)? nullptr : level[i]->findGroup(name);
+            }
+            enter(name);
+            merge(sub, onKnob, enter, leave);
+            leave();
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @brief     parallelVisit - read-only traversal of a big Group on many threads
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Analysis of very large trees (statistics, validation, fingerprints)
+ * only reads knobs, so groups can be visited concurrently:
+ * ~~~{.cpp}
+ * std::atomic<std::size_t> ints{0};
+ * knb::parallelVisit(knobs, [&](const knb::Knob& k) {
+ *     if (k.type() == knb::Knob::T::Int) ++ints;
+ * });
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_PARALLEL_VISIT_H_INCLUDED
+#define KNOBCPP_PARALLEL_VISIT_H_INCLUDED
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "knob.h"
+
+namespace knb {
+
+/** Call `visitor` for every knob of `root` on `threads` threads.
+ *
+ * Visitor has the same forms as for `Group::visit` and must be
+ * thread safe; knobs of one group are visited by one thread in name
+ * order, there is no order between groups. `false` returned by the
+ * visitor stops all threads. The first exception is rethrown.
+ * Tree must not change during the traversal.
+ *
+ * @return false if the traversal was stopped
+ */
+template <typename F>
+bool parallelVisit(const Group& root, F&& visitor, unsigned threads = 0)
+{
+    root.evaluate(); // threads read knobs directly, derived ones must be up to date
+    std::vector<const Group*> groups;
+    auto collect = [&groups](const Group& g, auto& self) -> void {
+        if (not g.knobs().empty()) groups.push_back(&g);
+        for (const Group& sub : g.groups()) self(sub, self);
+    };
+    collect(root, collect);
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(groups.size(), 1)));
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> stopped{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]{
+        try {
+            for (std::size_t i; not stopped.load(std::memory_order_relaxed) and
+                                (i = next.fetch_add(1, std::memory_order_relaxed)) < groups.size();) {
+                for (const Knob& k : groups[i]->knobs()) {
+                    if (not detail::visitKnob(visitor, k, *groups[i])) { stopped = true; break; }
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (not error) error = std::current_exception();
+            stopped = true;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+    return not stopped;
+}
+
+}
+
+#endif
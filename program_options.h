@@ -19,9 +19,12 @@
 #ifndef KNOBCPP_PROGRAM_OPTIONS_H_INCLUDED
 #define KNOBCPP_PROGRAM_OPTIONS_H_INCLUDED
 
+#include <cstdio>
 #include <iostream>
+#include <memory>
 
 #include "knob.h"
+#include "serializer.h"
 
 namespace knb {
 
@@ -31,6 +34,8 @@ namespace knb {
  *  1. `--knob-name`
  *  2. default knob value that also suggests the type
  *  3. decsription string
+ *
+ * Text is rendered by `Serializer` and written with one call.
  */
 inline
 void printOptions(
@@ -39,31 +44,184 @@ void printOptions(
     std::size_t width = 50 // terminal window size
 )
 {
-    auto pstr = [](std::ostream& o, const Knob& k) {
-        o << k.name() << " [\"" << k.asString() << "\"]"; };
-    auto pb = [](std::ostream& o, const Knob& k) {
-        if (!k.asBool()) {o << "no-";}; o << k.name(); };
-    auto pn = [](std::ostream& o, const Knob& k) {
-        o << k.name() << " [" << k.asString() << "]"; };
-
-    auto printer = [&](const Knob& knob) {
-        o << "--";
-        if (Knob::T t=knob.type(); t == Knob::T::String) {pstr(o,knob);}
-        else if (t == Knob::T::Bool) {pb(o,knob);}
-        else {pn(o,knob);}
-        o << std::endl;
-        for (std::size_t ln = 0, numln=(knob.desc().size()+width)/width; ln < numln; ++ln) {
-            o << "  " << knob.desc().substr(ln*width, width) << std::endl;
-        }
-    };
-    knobs.visit(printer);
+    thread_local Serializer s;
+    s.dump(knobs, Format::Help, o, width);
 }
 
+/** Command line parser that works on views of `argv`, no copies.
+ *
+ * Formats:
+ *  - `--name value`, `--name=value`, `--bool-name`, `--no-bool-name`;
+ *  - `name` is knob leaf name or path like `feature-A:A-val1`;
+ *  - `@file` reads more arguments from response file, arguments are
+ *    separated by white space, `"quoted args"` may contain spaces;
+ *  - `--` stops option parsing, the rest is not consumed;
+ *  - values are converted by `Group::changeValue`: units like
+ *    `--cache-size=64KiB` and knob ranges, see `codec.h`.
+ *
+ * Names are resolved with `Group::lookup`, O(1) from the root group.
+ * Parsing does not stop on the first error: unknown options and
+ * arguments are collected in `nonConsumed()`, bad values, leaf names
+ * of several knobs (use the path then) and missing response files
+ * in `errors()`.
+ *
+ * ~~~{.cpp}
+ * knb::OptionParser parser;
+ * if (!parser.parse(argc, argv, knobs)) {
+ *     for (auto& e : parser.errors()) std::cerr << e << std::endl;
+ * }
+ * ~~~
+ */
+class OptionParser
+{
+    static constexpr unsigned maxNesting = 8; ///< of response files
+
+    std::vector<std::unique_ptr<std::string>> files_; ///< response files content
+    std::vector<strv> nonConsumed_;
+    std::vector<strv> unknown_;
+    std::vector<std::string> errors_;
+    const Knob* pending_{nullptr}; ///< option waiting for its value
+    strv pendingOp_;
+    bool endOfOptions_{false};
+
+public:
+    /// Parse `argv[0..argc)`, return `true` if there were no errors.
+    bool parse(int argc, char* argv[], Group& knobs)
+    {
+        for (int i = 0; i < argc and argv[i] != nullptr; ++i) {
+            arg(argv[i], knobs, 0);
+        }
+        return finish();
+    }
+
+    /// Parse array of views, views must outlive the parser.
+    bool parse(const std::vector<strv>& args, Group& knobs)
+    {
+        for (strv a : args) arg(a, knobs, 0);
+        return finish();
+    }
+
+    /// Arguments not consumed by knobs, in the input order.
+    const std::vector<strv>& nonConsumed() const {return nonConsumed_;}
+
+    /// Options that look like `--name` but there is no such knob.
+    const std::vector<strv>& unknown() const {return unknown_;}
+
+    /// Conversion errors, missing values, ambiguous names and unreadable response files.
+    const std::vector<std::string>& errors() const {return errors_;}
+
+private:
+    /// End of input or of options, option can't wait for value anymore.
+    bool finish()
+    {
+        if (pending_ != nullptr) {
+            error(pendingOp_, "value is missing");
+            nonConsumed_.push_back(pendingOp_);
+            pending_ = nullptr;
+        }
+        return errors_.empty();
+    }
+
+    void error(strv op, const char* what)
+    {
+        errors_.push_back(std::string(op) + ": " + what);
+    }
+
+    void arg(strv a, Group& knobs, unsigned depth)
+    {
+        if (pending_ != nullptr and a != "--") {
+            const Knob* k = pending_; pending_ = nullptr;
+            set(knobs, *k, pendingOp_, a);
+            return;
+        }
+        if (endOfOptions_) { nonConsumed_.push_back(a); return; }
+        if (a == "--") { finish(); endOfOptions_ = true; return; }
+        if (a.size() > 1 and a.front() == '@') { responseFile(a, knobs, depth); return; }
+        if (a.size() < 3 or a.substr(0, 2) != "--") { nonConsumed_.push_back(a); return; }
+
+        strv name = a.substr(2), val;
+        const auto eq = name.find('=');
+        if (eq != strv::npos) { val = name.substr(eq + 1); name = name.substr(0, eq); }
+
+        KnobRef ref;
+        if (name.substr(0, 3) == "no-" and eq == strv::npos) {
+            ref = find(knobs, name.substr(3));
+            if (ref and ref.knob->type() == Knob::T::Bool) {
+                if (ref.ambiguous()) { ambiguous(a); return; }
+                set(knobs, *ref.knob, a, "false"); return;
+            }
+        }
+        if (ref = find(knobs, name); not ref) {
+            unknown_.push_back(a); nonConsumed_.push_back(a); return;
+        }
+        if (ref.ambiguous()) { ambiguous(a); return; }
+        const Knob* k = ref.knob;
+        if (eq != strv::npos) { set(knobs, *k, a, val); }
+        else if (k->type() == Knob::T::Bool) { set(knobs, *k, a, "true"); }
+        else { pending_ = k; pendingOp_ = a; }
+    }
+
+    static KnobRef find(const Group& knobs, strv name)
+    {
+        if (name.find(':') == strv::npos) return knobs.lookup(name);
+        const Knob* k = knobs.findPath(name);
+        return KnobRef{k, nullptr, (k == nullptr)? 0u : 1u};
+    }
+
+    /// Leaf name of several knobs, `--name value` leaves the value as a plain argument.
+    void ambiguous(strv op)
+    {
+        error(op, "ambiguous name, use the knob path");
+        nonConsumed_.push_back(op);
+    }
+
+    void set(Group& knobs, const Knob& k, strv op, strv val)
+    {
+        if (Status st = knobs.changeValue(&k, val); not st) {
+            error(op, st.what());
+            nonConsumed_.push_back(op);
+        }
+    }
+
+    void responseFile(strv a, Group& knobs, unsigned depth)
+    {
+        if (depth == maxNesting) { error(a, "response files nested too deep"); return; }
+        const std::string path(a.substr(1));
+        std::unique_ptr<std::FILE, int(*)(std::FILE*)> f(std::fopen(path.c_str(), "rb"), &std::fclose);
+        if (not f) { error(a, "can't open response file"); return; }
+
+        auto text = std::make_unique<std::string>();
+        char buf[64 * 1024];
+        while (std::size_t n = std::fread(buf, 1, sizeof(buf), f.get())) text->append(buf, n);
+        if (std::ferror(f.get())) { error(a, "can't read response file"); return; }
+        strv s = *files_.emplace_back(std::move(text));
+
+        auto space = [](char c){return c == ' ' or c == '\t' or c == '\n' or c == '\r';};
+        while (true) {
+            while (not s.empty() and space(s.front())) s.remove_prefix(1);
+            if (s.empty()) break;
+            std::size_t n = 0;
+            if (s.front() == '"') {
+                s.remove_prefix(1);
+                n = std::min(s.find('"'), s.size());
+                arg(s.substr(0, n), knobs, depth + 1);
+                s.remove_prefix(std::min(n + 1, s.size()));
+            } else {
+                while (n < s.size() and not space(s[n])) ++n;
+                arg(s.substr(0, n), knobs, depth + 1);
+                s.remove_prefix(n);
+            }
+        }
+    }
+};
+
 /** Parse program options.
  *
- * Format: `--op1 op1val --op2 op2val --feature-a-bool --no-feature-b`
+ * Format: `--op1 op1val --op2 op2val --feature-a-bool --no-feature-b`,
+ * see OptionParser for all formats.
  *
- * @return tuple<ok,non-consumed-options>
+ * @return tuple<ok,non-consumed-options>, `ok` is false if some values
+ *         could not be converted, such options are not consumed
  */
 inline
 std::tuple<bool,std::vector<std::string> >
@@ -72,25 +230,10 @@ parseOptions(
     knb::Group& knobs ///< [in,out] changes per option
 )
 {
-    std::vector<std::string> non_consumed;
-    auto is_op = [](const std::string& s){
-        return s.find("--") == 0;
-    };
-    bool waiting_for_val(false); const Knob* knob{nullptr};
-    for (const auto& op : options) {
-        if (waiting_for_val) { waiting_for_val = false;
-            if (knob) knobs.changeValue(knob, op);
-        } else if (is_op(op)) {
-            auto knob_name = op.substr((op.find("--no-")==0)? 5:2);
-            if (auto [found,p,k] = knobs.findKnob(knob_name); found){
-                knob = k; knob_name = p;
-                if (waiting_for_val = (k->type()!=Knob::T::Bool); !waiting_for_val) {
-                    knobs.changeValue(knob, (op.find("--no-")==0)? "":"true");
-                }
-            } else { non_consumed.push_back(op); }
-        } else { non_consumed.push_back(op); }
-    }
-    return std::make_tuple(true, non_consumed);
+    OptionParser parser;
+    const bool ok = parser.parse(std::vector<strv>(std::begin(options), std::end(options)), knobs);
+    return std::make_tuple(ok, std::vector<std::string>(
+        std::begin(parser.nonConsumed()), std::end(parser.nonConsumed())));
 }
 
 /** Parse program options `(int argc, char** argv)`
@@ -100,11 +243,10 @@ inline
 std::tuple<bool,std::vector<std::string> >
 parseOptions(int argc, char* argv[], knb::Group& knobs)
 {
-    std::vector<std::string> options;
-    for (int i = 0; i < argc and argv[i] != nullptr; ++i) {
-        options.push_back(argv[i]);
-    }
-    return parseOptions(options, knobs);
+    OptionParser parser;
+    const bool ok = parser.parse(argc, argv, knobs);
+    return std::make_tuple(ok, std::vector<std::string>(
+        std::begin(parser.nonConsumed()), std::end(parser.nonConsumed())));
 }
 
 }
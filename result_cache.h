@@ -0,0 +1,117 @@
+/**
+ * @file
+ * @brief     On-disk cache of run artifacts keyed by configuration Fingerprint
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Each cached run is a directory named by the fingerprint of its
+ * configuration. A run writes its artifacts into a staging directory
+ * that is renamed into place when the run is done, so an interrupted
+ * run leaves no entry and parallel runs of the same point do not mix
+ * their files. Re-running a sweep executes only the new points:
+ * ~~~{.cpp}
+ * knb::ResultCache cache("results");
+ * sweep.run([&](const knb::SweepPoint& p) {
+ *     const knb::Fingerprint fp = p.fingerprint();
+ *     if (cache.find(fp)) return;
+ *     const std::string dir = cache.stage(fp);
+ *     simulate(p, dir);              // writes files into dir
+ *     cache.commit(fp, dir);
+ * });
+ * ~~~
+ */
+#pragma once
+#ifndef KNOBCPP_RESULT_CACHE_H_INCLUDED
+#define KNOBCPP_RESULT_CACHE_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "serializer.h"
+
+namespace knb {
+
+class ResultCache
+{
+    std::filesystem::path dir_;
+    std::atomic<unsigned> staged_; ///< suffix of the next staging directory
+
+public:
+    /// Cache in directory `dir`, created if needed; throws `std::runtime_error`.
+    explicit ResultCache(const std::string& dir):dir_(dir),
+        staged_(static_cast<unsigned>(detail::mix(static_cast<std::uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count()))))
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        if (ec or not std::filesystem::is_directory(dir_)) {
+            throw std::runtime_error("knb::ResultCache: can't create directory " + dir);
+        }
+    }
+
+    /// Directory of entry `fp`, it exists only if the entry was committed.
+    std::string path(const Fingerprint& fp) const {return (dir_ / fp.hex()).string();}
+
+    /// Artifact directory of a committed run of `fp`.
+    std::optional<std::string> find(const Fingerprint& fp) const {
+        std::error_code ec;
+        std::string p = path(fp);
+        if (std::filesystem::is_directory(p, ec)) return p;
+        return std::nullopt;
+    }
+
+    /// Create new empty staging directory for a run of `fp`, throw `std::runtime_error`.
+    std::string stage(const Fingerprint& fp) {
+        for (unsigned attempt = 0; attempt < 1000; ++attempt) {
+            const unsigned n = staged_.fetch_add(1, std::memory_order_relaxed);
+            const std::filesystem::path p = dir_ / (fp.hex() + ".tmp" + std::to_string(n));
+            std::error_code ec;
+            if (std::filesystem::create_directory(p, ec)) return p.string();
+        }
+        throw std::runtime_error("knb::ResultCache: can't create staging directory in " + dir_.string());
+    }
+
+    /** Make staged directory the entry of `fp`.
+     *
+     * If `config` is given, its `Format::KeyValue` dump is saved in the
+     * entry as `config.txt`. Return false if the entry already exists
+     * (another run committed first) or on I/O error; the staged directory
+     * is removed then.
+     */
+    bool commit(const Fingerprint& fp, const std::string& staged, const Group* config = nullptr) {
+        std::error_code ec;
+        if (config != nullptr) {
+            std::string text;
+            serialize(*config, Format::KeyValue, text);
+            std::ofstream f(std::filesystem::path(staged) / "config.txt", std::ios::binary);
+            f.write(text.data(), static_cast<std::streamsize>(text.size()));
+            if (not f.flush()) { discard(staged); return false; }
+        }
+        if (find(fp)) { discard(staged); return false; }
+        std::filesystem::rename(staged, path(fp), ec);
+        if (ec) { discard(staged); return false; }
+        return true;
+    }
+
+    /// Remove staged directory of a failed run.
+    void discard(const std::string& staged) {
+        std::error_code ec;
+        std::filesystem::remove_all(staged, ec);
+    }
+
+    /// Remove entry `fp`, return false if there was none.
+    bool erase(const Fingerprint& fp) {
+        std::error_code ec;
+        return std::filesystem::remove_all(path(fp), ec) > 0;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file
+ * @brief     Render Group as help text, `key = value` lines or JSON
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Full effective configuration is logged for every experiment run.
+ * Whole tree is rendered into one growable buffer, numbers are
+ * formatted with `std::to_chars`, and the buffer is written out
+ * at once; keeping the buffer between dumps avoids allocations:
+ * ~~~{.cpp}
+ * knb::Serializer s;
+ * s.dump(knobs, knb::Format::Json, logFile);   // one write
+ * ~~~
+ * `Format::KeyValue` output can be read back with `loadConfig` into a Group
+ * that already declares these knobs; knob types come from that Group, a new
+ * tree would guess them from the text (float `1` would become Int).
+ */
+#pragma once
+#ifndef KNOBCPP_SERIALIZER_H_INCLUDED
+#define KNOBCPP_SERIALIZER_H_INCLUDED
+
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+#include "knob.h"
+
+namespace knb {
+
+enum class Format {
+    Help,     ///< `--name [value]` and wrapped description, see `printOptions`
+    KeyValue, ///< `path:name = value` per line
+    Json      ///< nested objects, one per group
+};
+
+namespace detail {
+
+/// Value as `Knob::asString` shows it, floats in shortest form.
+inline void appendValue(std::string& out, const Knob& k)
+{
+    switch (k.type()){
+    case Knob::T::Bool:   out += k.asBool()? "true" : "false"; break;
+    case Knob::T::Int:    codec::append(out, k.asInt()); break;
+    case Knob::T::Float:  codec::append(out, k.asFloat()); break;
+    case Knob::T::String: out += *k.bind<std::string>(); break;
+    case Knob::T::Int64:  codec::append(out, k.asInt64()); break;
+    case Knob::T::UInt64: codec::append(out, k.asUInt64()); break;
+    case Knob::T::Double: codec::append(out, k.asDouble()); break;
+    case Knob::T::Int64Array:  codec::append(out, k.asInt64Array()); break;
+    case Knob::T::DoubleArray: codec::append(out, k.asDoubleArray()); break;
+    }
+}
+
+inline void appendJsonString(std::string& out, strv s)
+{
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                const char hex[] = "0123456789abcdef";
+                out += "\\u00"; out += hex[(c >> 4) & 0xf]; out += hex[c & 0xf];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+/// Number, `null` for infinity and NaN that JSON does not have.
+template <typename N>
+void appendJsonNumber(std::string& out, N n)
+{
+    if constexpr (std::is_floating_point_v<N>) {
+        if (not std::isfinite(n)) { out += "null"; return; }
+    }
+    codec::append(out, n);
+}
+
+inline void appendHelp(std::string& out, const Group& g, std::size_t width)
+{
+    g.visit([&](const Knob& k) {
+        out += "--";
+        switch (k.type()){
+        case Knob::T::String:
+            out += k.name(); out += " [\""; appendValue(out, k); out += "\"]"; break;
+        case Knob::T::Bool:
+            if (not k.asBool()) out += "no-";
+            out += k.name(); break;
+        default:
+            out += k.name(); out += " ["; appendValue(out, k); out += ']'; break;
+        }
+        out += '\n';
+        const strv desc = k.desc();
+        for (std::size_t ln = 0, numln = (desc.size() + width) / width; ln < numln; ++ln) {
+            out += "  ";
+            out += desc.substr(std::min(ln * width, desc.size()), width);
+            out += '\n';
+        }
+    });
+}
+
+/// Quoted string with escapes that `loadConfig` reads back.
+inline void appendConfigString(std::string& out, strv s)
+{
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:   out += c; break;
+        }
+    }
+    out += '"';
+}
+
+inline void appendKeyValues(std::string& out, const Group& g)
+{
+    for (auto it = g.tree().begin(), end = g.tree().end(); it != end; ++it) {
+        it.appendPath(out);
+        out += " = ";
+        if (it->type() == Knob::T::String) {
+            appendConfigString(out, *it->bind<std::string>());
+        } else {
+            appendValue(out, *it);
+        }
+        out += '\n';
+    }
+}
+
+inline void appendJson(std::string& out, const Group& g, std::size_t indent)
+{
+    out += "{\n";
+    bool first = true;
+    auto key = [&](strv name) {
+        if (not first) out += ",\n";
+        first = false;
+        out.append(indent + 2, ' ');
+        appendJsonString(out, name);
+        out += ": ";
+    };
+    for (const Knob& k : g.knobs()) {
+        key(k.name());
+        switch (k.type()){
+        case Knob::T::String: appendJsonString(out, *k.bind<std::string>()); break;
+        case Knob::T::Float:  appendJsonNumber(out, k.asFloat()); break;
+        case Knob::T::Double: appendJsonNumber(out, k.asDouble()); break;
+        case Knob::T::Int64Array:
+        case Knob::T::DoubleArray:
+            out += '[';
+            if (k.type() == Knob::T::Int64Array) {
+                for (std::int64_t e : k.asInt64Array()) { appendJsonNumber(out, e); out += ", "; }
+            } else {
+                for (double e : k.asDoubleArray()) { appendJsonNumber(out, e); out += ", "; }
+            }
+            if (out.back() == ' ') out.resize(out.size() - 2);
+            out += ']';
+            break;
+        default: appendValue(out, k); break;
+        }
+    }
+    for (const Group& sub : g.groups()) {
+        key(sub.name());
+        appendJson(out, sub, indent + 2);
+    }
+    if (not first) out += '\n';
+    out.append(indent, ' ');
+    out += '}';
+}
+
+} // namespace detail
+
+/** Append rendering of `g` to `out`.
+ *
+ * `width` is the description line width of `Format::Help`.
+ */
+inline void serialize(const Group& g, Format f, std::string& out, std::size_t width = 50)
+{
+    profile::Pause pause;
+    g.evaluate();
+    switch (f) {
+    case Format::Help:     detail::appendHelp(out, g, width); break;
+    case Format::KeyValue: detail::appendKeyValues(out, g); break;
+    case Format::Json:     detail::appendJson(out, g, 0); out += '\n'; break;
+    }
+}
+
+/// Renders groups into a buffer that is reused from dump to dump.
+class Serializer
+{
+    std::string buf_;
+
+public:
+    /// Render `g`, the view is valid until the next call.
+    strv render(const Group& g, Format f, std::size_t width = 50) {
+        buf_.clear();
+        serialize(g, f, buf_, width);
+        return buf_;
+    }
+
+    /// Render `g` and write it with one call.
+    void dump(const Group& g, Format f, std::ostream& o, std::size_t width = 50) {
+        const strv s = render(g, f, width);
+        o.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    void dump(const Group& g, Format f, std::FILE* file, std::size_t width = 50) {
+        const strv s = render(g, f, width);
+        std::fwrite(s.data(), 1, s.size(), file);
+    }
+
+    /// Bytes kept for the next dump.
+    std::size_t capacity() const {return buf_.capacity();}
+};
+
+}
+
+#endif
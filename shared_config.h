@@ -0,0 +1,270 @@
+/**
+ * @file
+ * @brief     Snapshot of configuration in POSIX shared memory, for worker processes
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Controller places the snapshot image (see snapshot.h) of a finalized
+ * Group into a shared memory segment; every worker maps the same pages
+ * read-only, so memory does not grow with the number of workers and
+ * a worker starts without parsing anything:
+ * ~~~{.cpp}
+ * knb::SharedConfigWriter shm("/sim-config", knobs);   // controller
+ * ...
+ * knb::SharedConfig config("/sim-config");             // worker
+ * int ways = config.root().gr("cache").at("ways").asInt();
+ * ~~~
+ * Controller can publish new values of scalar knobs, Bool and numbers,
+ * while workers run. Updates are guarded by a sequence counter (seqlock):
+ * the writer makes it odd, changes values in place and makes it even
+ * again; `SharedConfig::read` retries when the counter moved, so a group
+ * of values read together is consistent. Workers poll `version()` to
+ * find out that something changed. Structure, strings and arrays can't
+ * change, controller creates a new segment for that.
+ *
+ * Segment layout: header with magic and image size, sequence counter
+ * alone on the next cache line, snapshot image from offset 128.
+ */
+#pragma once
+#ifndef KNOBCPP_SHARED_CONFIG_H_INCLUDED
+#define KNOBCPP_SHARED_CONFIG_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "snapshot.h"
+
+namespace knb {
+
+namespace detail {
+
+constexpr char sharedMagic[8] = {'K','N','O','B','S','H','M','1'};
+
+inline std::uint64_t sharedMagicWord()
+{
+    std::uint64_t m;
+    std::memcpy(&m, sharedMagic, sizeof(m));
+    return m;
+}
+
+struct SharedHeader {
+    std::atomic<std::uint64_t> magic; ///< stored last, with release, when the image is complete
+    std::uint32_t imageOff;
+    std::uint32_t imageSize;
+    alignas(64) std::atomic<std::uint64_t> seq; ///< odd while values change
+};
+
+static_assert(sizeof(SharedHeader) == 128);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "sequence counter is shared between processes");
+
+/// Knob types that `SharedConfigWriter::publish` changes in place.
+inline bool sharedScalar(std::uint32_t type)
+{
+    switch (static_cast<Knob::T>(type)) {
+    case Knob::T::Bool: case Knob::T::Int: case Knob::T::Float:
+    case Knob::T::Int64: case Knob::T::UInt64: case Knob::T::Double:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace detail
+
+/** Worker side: segment mapped read-only.
+ *
+ * Constructor throws `std::runtime_error` if the segment does not exist
+ * or does not hold a valid image.
+ */
+class SharedConfig
+{
+    void* addr_{nullptr};
+    std::size_t size_{0};
+    SnapshotView view_;
+
+public:
+    /// Map segment `name`, like `"/sim-config"`, see `shm_open`.
+    explicit SharedConfig(const std::string& name)
+    {
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) throw std::runtime_error("knb::SharedConfig: can't open " + name);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 or static_cast<std::size_t>(st.st_size) < sizeof(detail::SharedHeader)) {
+            ::close(fd);
+            throw std::runtime_error("knb::SharedConfig: can't stat " + name);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        addr_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr_ == MAP_FAILED) {
+            addr_ = nullptr;
+            throw std::runtime_error("knb::SharedConfig: can't mmap " + name);
+        }
+        try {
+            const auto& h = header();
+            if (h.magic.load(std::memory_order_acquire) != detail::sharedMagicWord() or
+                std::uint64_t(h.imageOff) + h.imageSize > size_) {
+                throw std::runtime_error("knb::SharedConfig: bad segment " + name);
+            }
+            view_ = SnapshotView(static_cast<const char*>(addr_) + h.imageOff, h.imageSize);
+        } catch (...) {
+            ::munmap(addr_, size_);
+            throw;
+        }
+    }
+    ~SharedConfig() { if (addr_ != nullptr) ::munmap(addr_, size_); }
+    SharedConfig(const SharedConfig&) = delete;
+    SharedConfig& operator=(const SharedConfig&) = delete;
+
+    /// Root group; values read without `read` may be torn by a concurrent `publish`.
+    SnapshotGroupView root() const {return view_.root();}
+
+    const SnapshotView& view() const {return view_;}
+
+    /// Number of publishes so far, changes when values change.
+    std::uint64_t version() const {
+        return header().seq.load(std::memory_order_acquire) / 2;
+    }
+
+    /** Call `f(root())` and return its result, consistent with one version.
+     *
+     * `f` is called again if the controller published during the call,
+     * so it must only read; values it returns must be copies, not views.
+     */
+    template <typename F>
+    auto read(F&& f) const {
+        const auto& seq = header().seq;
+        for (;;) {
+            const std::uint64_t before = seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            auto result = f(root());
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) return result;
+        }
+    }
+
+private:
+    const detail::SharedHeader& header() const {
+        return *static_cast<const detail::SharedHeader*>(addr_);
+    }
+};
+
+/** Controller side: creates the segment and publishes new values.
+ *
+ * There is one writer per segment. The segment stays after the writer
+ * is destroyed, until `unlink`.
+ */
+class SharedConfigWriter
+{
+    std::string name_;
+    void* addr_{nullptr};
+    std::size_t size_{0};
+
+public:
+    /** Create segment `name` with image of `root`, throw `std::runtime_error`.
+     *
+     * Existing segment with this name is unlinked, not overwritten: workers
+     * that mapped it keep the old image until they open `name` again.
+     */
+    SharedConfigWriter(const std::string& name, const Group& root):name_(name)
+    {
+        const std::string image = makeSnapshot(root);
+        size_ = sizeof(detail::SharedHeader) + image.size();
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) throw std::runtime_error("knb::SharedConfigWriter: can't create " + name);
+        if (::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("knb::SharedConfigWriter: can't resize " + name);
+        }
+        addr_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr_ == MAP_FAILED) {
+            addr_ = nullptr;
+            throw std::runtime_error("knb::SharedConfigWriter: can't mmap " + name);
+        }
+        auto* h = new (addr_) detail::SharedHeader{};
+        std::memcpy(imageBase(), image.data(), image.size());
+        h->imageOff = sizeof(detail::SharedHeader);
+        h->imageSize = static_cast<std::uint32_t>(image.size());
+        h->magic.store(detail::sharedMagicWord(), std::memory_order_release);
+    }
+    ~SharedConfigWriter() { if (addr_ != nullptr) ::munmap(addr_, size_); }
+    SharedConfigWriter(const SharedConfigWriter&) = delete;
+    SharedConfigWriter& operator=(const SharedConfigWriter&) = delete;
+
+    const std::string& name() const {return name_;}
+
+    std::uint64_t version() const {
+        return header().seq.load(std::memory_order_relaxed) / 2;
+    }
+
+    /** Write values of scalar knobs of `root` into the segment.
+     *
+     * `root` must have the same groups and knobs, types, strings
+     * and arrays as the tree the segment was created from, otherwise
+     * `std::invalid_argument` is thrown and nothing changes.
+     * Version is bumped only if some value changed.
+     *
+     * @return number of changed knobs
+     */
+    std::size_t publish(const Group& root) {
+        using namespace detail;
+        const std::string image = makeSnapshot(root);
+        const char* now = image.data();
+        const char* was = imageBase();
+        const auto& h = *reinterpret_cast<const SnapshotHeader*>(was);
+        auto fail = [this](const char* why) {
+            throw std::invalid_argument("knb::SharedConfigWriter::publish: " + std::string(why) +
+                " in " + name_ + ", create a new segment");
+        };
+        if (image.size() != header().imageSize or std::memcmp(now, was, h.knobsOff) != 0) {
+            fail("groups or knobs changed");
+        }
+        std::vector<std::uint32_t> changed;
+        const auto* nk = reinterpret_cast<const SnapshotKnob*>(now + h.knobsOff);
+        const auto* wk = reinterpret_cast<const SnapshotKnob*>(was + h.knobsOff);
+        for (std::uint32_t i = 0; i < h.numKnobs; ++i) {
+            if (std::memcmp(&nk[i], &wk[i], offsetof(SnapshotKnob, value)) != 0) fail("knobs changed");
+            if (std::memcmp(nk[i].value, wk[i].value, sizeof(wk[i].value)) == 0) continue;
+            if (not sharedScalar(nk[i].type)) fail("string or array value changed");
+            changed.push_back(i);
+        }
+        if (std::memcmp(now + h.slotsOff, was + h.slotsOff, image.size() - h.slotsOff) != 0) {
+            fail("string or array value changed");
+        }
+        if (changed.empty()) return 0;
+
+        auto& seq = header().seq;
+        const std::uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        auto* records = reinterpret_cast<SnapshotKnob*>(imageBase() + h.knobsOff);
+        for (std::uint32_t i : changed) std::memcpy(records[i].value, nk[i].value, sizeof(nk[i].value));
+        seq.store(s + 2, std::memory_order_release);
+        return changed.size();
+    }
+
+    /// Remove segment `name`, mapped segments stay valid; return false if there was none.
+    static bool unlink(const std::string& name) {return ::shm_unlink(name.c_str()) == 0;}
+
+private:
+    detail::SharedHeader& header() const {return *static_cast<detail::SharedHeader*>(addr_);}
+    char* imageBase() const {return static_cast<char*>(addr_) + sizeof(detail::SharedHeader);}
+};
+
+}
+
+#endif
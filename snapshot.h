@@ -0,0 +1,617 @@
+/**
+ * @file
+ * @brief     Binary snapshot of configuration tree, queried in place
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Simulators rebuild the same Group from text on every run.
+ * Snapshot is a position independent image of a finalized Group
+ * (offsets, no pointers) that can be saved to a file, `mmap`ed
+ * and queried in place: loading costs one `mmap` call, a check of the
+ * tables (optional for trusted files) and page faults for the pages that
+ * are actually touched.
+ *
+ * ~~~{.cpp}
+ * knb::saveSnapshot(knobs, "config.knb");
+ * ...
+ * knb::MappedSnapshot snap("config.knb");
+ * int v = snap.root().gr("feature-A").at("A-val1").asInt();
+ * ~~~
+ *
+ * Image layout, all numbers are native endian `uint32_t`:
+ *  1. header: magic, version, counts and offsets of the tables;
+ *  2. group table, groups in breadth-first order, so children
+ *     of a group are contiguous and sorted by name;
+ *  3. knob table, knobs of a group are contiguous and sorted by name;
+ *  4. open addressing hash table: leaf name to first knob in visit order;
+ *  5. string area, each distinct string is stored once;
+ *     array knob elements are stored there too, 64-byte aligned
+ *     from the image start.
+ *
+ * Version 2 added 64-bit and array types, version 3 hashes names with
+ * `detail::hash`; older images are rejected, make them again.
+ */
+#pragma once
+#ifndef KNOBCPP_SNAPSHOT_H_INCLUDED
+#define KNOBCPP_SNAPSHOT_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "knob.h"
+
+namespace knb {
+
+namespace detail {
+
+constexpr char snapshotMagic[8] = {'K','N','O','B','S','N','A','P'};
+constexpr std::uint32_t snapshotVersion = 3;
+constexpr std::uint32_t snapshotNone = static_cast<std::uint32_t>(-1);
+constexpr std::uint32_t snapshotMaxDepth = 256; ///< levels of nested groups
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t size;       ///< whole image size in bytes
+    std::uint32_t numGroups, groupsOff;
+    std::uint32_t numKnobs,  knobsOff;
+    std::uint32_t numSlots,  slotsOff; ///< number of slots is power of 2
+};
+
+struct SnapshotStr { std::uint32_t off, len; };
+
+struct SnapshotGroup {
+    SnapshotStr   name;
+    std::uint32_t parent;
+    std::uint32_t firstKnob, numKnobs;
+    std::uint32_t firstChild, numChildren;
+};
+
+struct SnapshotKnob {
+    SnapshotStr   name;
+    SnapshotStr   desc;
+    std::uint32_t group;
+    std::uint32_t type;
+    std::uint32_t sameName; ///< next knob with the same name in visit order
+    std::uint32_t value[2]; ///< scalar bits, string {off,len} or array {off,count}
+};
+
+static_assert(sizeof(SnapshotHeader) == 40);
+static_assert(sizeof(SnapshotGroup) == 28);
+static_assert(sizeof(SnapshotKnob) == 36);
+
+/// Hash of leaf names in the slot table, lower half of `detail::hash`.
+constexpr std::uint32_t snapshotHash(strv s)
+{
+    return static_cast<std::uint32_t>(hash(s));
+}
+
+struct SnapshotWriter;
+
+} // namespace detail
+
+class SnapshotGroupView;
+
+/// Read-only view of a knob inside snapshot image.
+class SnapshotKnobView
+{
+    const char* base_{nullptr};
+    const detail::SnapshotKnob* k_{nullptr};
+
+    friend class SnapshotGroupView;
+    SnapshotKnobView(const char* base, const detail::SnapshotKnob* k):base_(base),k_(k){}
+    strv string(detail::SnapshotStr s) const {return strv(base_ + s.off, s.len);}
+public:
+    SnapshotKnobView() = default;
+
+    explicit operator bool() const {return k_ != nullptr;}
+
+    strv name() const {return string(k_->name);}
+    strv desc() const {return string(k_->desc);}
+    Knob::T type() const {return static_cast<Knob::T>(k_->type);}
+    std::size_t typeId() const {return k_->type;}
+
+    bool asBool() const {check(Knob::T::Bool); return k_->value[0] != 0;}
+    int asInt() const {
+        check(Knob::T::Int);
+        int i; std::memcpy(&i, &k_->value[0], sizeof(i)); return i;
+    }
+    float asFloat() const {
+        check(Knob::T::Float);
+        float f; std::memcpy(&f, &k_->value[0], sizeof(f)); return f;
+    }
+    std::int64_t asInt64() const {check(Knob::T::Int64); return wide<std::int64_t>();}
+    std::uint64_t asUInt64() const {check(Knob::T::UInt64); return wide<std::uint64_t>();}
+    double asDouble() const {check(Knob::T::Double); return wide<double>();}
+    /// Value of string knob as view into the image.
+    strv asStringView() const {
+        check(Knob::T::String);
+        return strv(base_ + k_->value[0], k_->value[1]);
+    }
+    /// Elements of array knob in the image, aligned if the image is.
+    Span<const std::int64_t> asInt64Array() const {
+        check(Knob::T::Int64Array);
+        return {reinterpret_cast<const std::int64_t*>(base_ + k_->value[0]), k_->value[1]};
+    }
+    Span<const double> asDoubleArray() const {
+        check(Knob::T::DoubleArray);
+        return {reinterpret_cast<const double*>(base_ + k_->value[0]), k_->value[1]};
+    }
+    str asString() const {
+        if (type() == Knob::T::String) return str(asStringView());
+        return knob().asString();
+    }
+
+    /// Materialize knob, for example to put it back into a Group.
+    Knob knob() const {
+        const str nm(name()), d(desc());
+        switch (type()){
+        case Knob::T::Bool:   return Knob(nm, asBool(), d);
+        case Knob::T::Int:    return Knob(nm, asInt(), d);
+        case Knob::T::Float:  return Knob(nm, asFloat(), d);
+        case Knob::T::String: return Knob(nm, asString(), d);
+        case Knob::T::Int64:  return Knob(nm, asInt64(), d);
+        case Knob::T::UInt64: return Knob(nm, asUInt64(), d);
+        case Knob::T::Double: return Knob(nm, asDouble(), d);
+        case Knob::T::Int64Array: {
+            auto a = asInt64Array();
+            return Knob(nm, std::vector<std::int64_t>(a.begin(), a.end()), d);
+        }
+        case Knob::T::DoubleArray: {
+            auto a = asDoubleArray();
+            return Knob(nm, std::vector<double>(a.begin(), a.end()), d);
+        }
+        }
+        return Knob();
+    }
+
+private:
+    void check(Knob::T t) const {
+        if (type() != t) throw std::bad_variant_access();
+    }
+
+    template <typename W>
+    W wide() const {W w; std::memcpy(&w, k_->value, sizeof(w)); return w;}
+};
+
+/// Read-only view of a group inside snapshot image, mirrors Group API.
+class SnapshotGroupView
+{
+    const char* base_{nullptr};
+    std::uint32_t id_{0};
+
+    friend class SnapshotView;
+    SnapshotGroupView(const char* base, std::uint32_t id):base_(base),id_(id){}
+
+    const detail::SnapshotHeader& header() const {
+        return *reinterpret_cast<const detail::SnapshotHeader*>(base_);
+    }
+    const detail::SnapshotGroup& group(std::uint32_t id) const {
+        return reinterpret_cast<const detail::SnapshotGroup*>(base_ + header().groupsOff)[id];
+    }
+    const detail::SnapshotKnob& knob(std::uint32_t id) const {
+        return reinterpret_cast<const detail::SnapshotKnob*>(base_ + header().knobsOff)[id];
+    }
+    strv string(detail::SnapshotStr s) const {return strv(base_ + s.off, s.len);}
+
+public:
+    strv name() const {return string(group(id_).name);}
+
+    /// Knob of this group, throw `std::out_of_range` if there is no such knob.
+    SnapshotKnobView at(strv knobName) const
+    {
+        const auto& g = group(id_);
+        const auto* first = &knob(g.firstKnob);
+        const auto* last = first + g.numKnobs;
+        const auto* k = std::lower_bound(first, last, knobName,
+            [this](const detail::SnapshotKnob& kb, strv nm){return string(kb.name) < nm;});
+        if (k == last or string(k->name) != knobName) {
+            throw std::out_of_range("knb::SnapshotGroupView::at: " + std::string(knobName));
+        }
+        return SnapshotKnobView(base_, k);
+    }
+
+    /// Subgroup, throw `std::out_of_range` if there is no such group.
+    SnapshotGroupView gr(strv groupName) const
+    {
+        const auto& g = group(id_);
+        std::uint32_t lo = g.firstChild, hi = g.firstChild + g.numChildren;
+        while (lo < hi) {
+            std::uint32_t mid = lo + (hi - lo) / 2;
+            if (string(group(mid).name) < groupName) lo = mid + 1; else hi = mid;
+        }
+        if (lo == g.firstChild + g.numChildren or string(group(lo).name) != groupName) {
+            throw std::out_of_range("knb::SnapshotGroupView::gr: " + std::string(groupName));
+        }
+        return SnapshotGroupView(base_, lo);
+    }
+
+    /** Find knob by leaf name anywhere in the sub-tree, like `Group::findKnob`.
+     *
+     * Returns path from this group and the first match in visit order.
+     */
+    std::tuple<bool,std::string,SnapshotKnobView> findKnob(strv knobName) const
+    {
+        const auto& h = header();
+        const auto* slots = reinterpret_cast<const std::uint32_t*>(base_ + h.slotsOff);
+        const std::uint32_t mask = h.numSlots - 1;
+        std::uint32_t id = detail::snapshotNone;
+        for (std::uint32_t s = detail::snapshotHash(knobName) & mask;; s = (s + 1) & mask) {
+            if (slots[s] == detail::snapshotNone) break;
+            if (string(knob(slots[s]).name) == knobName) { id = slots[s]; break; }
+        }
+        // first knob with this name that belongs to sub-tree of this group
+        for (; id != detail::snapshotNone; id = knob(id).sameName) {
+            std::uint32_t g = knob(id).group;
+            std::size_t len = knobName.size();
+            while (g != id_ and g != detail::snapshotNone) {
+                len += group(g).name.len + 1; g = group(g).parent;
+            }
+            if (g != id_) continue;
+            std::string path; path.resize(len + group(id_).name.len + 1);
+            std::size_t pos = path.size() - knobName.size();
+            path.replace(pos, knobName.size(), knobName);
+            for (g = knob(id).group; ; g = group(g).parent) {
+                strv gn = string(group(g).name);
+                path[--pos] = ':'; pos -= gn.size();
+                path.replace(pos, gn.size(), gn);
+                if (g == id_) break;
+            }
+            return std::make_tuple(true, path, SnapshotKnobView(base_, &knob(id)));
+        }
+        return std::make_tuple(false, "", SnapshotKnobView());
+    }
+
+    /// Visit knobs of the sub-tree in the same order as `Group::visit`.
+    template <typename F>
+    void visit(F&& visitor) const
+    {
+        const auto& g = group(id_);
+        for (std::uint32_t k = g.firstKnob; k < g.firstKnob + g.numKnobs; ++k) {
+            visitor(SnapshotKnobView(base_, &knob(k)));
+        }
+        for (std::uint32_t c = g.firstChild; c < g.firstChild + g.numChildren; ++c) {
+            SnapshotGroupView(base_, c).visit(visitor);
+        }
+    }
+};
+
+/** View of snapshot image in memory, the image is not copied.
+ *
+ * Constructor checks the header only and opens in constant time,
+ * fine for images the program made itself. `verify = true` also checks
+ * every record of the tables: strings and arrays are inside the image,
+ * group, knob and slot indices are in range, links go forward and
+ * groups are nested at most `snapshotMaxDepth` levels, so a corrupt or
+ * foreign image can't make queries read outside of it, loop or recurse
+ * too deep. That touches all tables once, strings are not read.
+ * Throws `std::runtime_error` if the image is not valid.
+ */
+class SnapshotView
+{
+    const char* base_{nullptr};
+    std::size_t size_{0};
+public:
+    SnapshotView() = default;
+    SnapshotView(const void* data, std::size_t size, bool verify = false):
+        base_(static_cast<const char*>(data)),size_(size)
+    {
+        using namespace detail;
+        auto fail = [](const char* why){
+            throw std::runtime_error(std::string("knb::SnapshotView: ") + why);
+        };
+        if (size < sizeof(SnapshotHeader)) fail("image is too small");
+        const auto& h = *reinterpret_cast<const SnapshotHeader*>(base_);
+        if (std::memcmp(h.magic, snapshotMagic, sizeof(h.magic)) != 0) fail("bad magic");
+        if (h.version != snapshotVersion) fail("unsupported version");
+        if (h.size != size) fail("image size mismatch");
+        auto fits = [size](std::uint64_t off, std::uint64_t n, std::size_t recSize) {
+            return off + n * recSize <= size;
+        };
+        if (h.numGroups == 0 or not fits(h.groupsOff, h.numGroups, sizeof(SnapshotGroup)) or
+            not fits(h.knobsOff, h.numKnobs, sizeof(SnapshotKnob)) or
+            not fits(h.slotsOff, h.numSlots, sizeof(std::uint32_t)) or
+            h.numSlots == 0 or (h.numSlots & (h.numSlots - 1)) != 0) {
+            fail("corrupted tables");
+        }
+        if (verify) validate(h, fail);
+    }
+
+    const void* data() const {return base_;}
+    std::size_t size() const {return size_;}
+
+    SnapshotGroupView root() const {return SnapshotGroupView(base_, 0);}
+
+private:
+    template <typename Fail>
+    void validate(const detail::SnapshotHeader& h, Fail fail) const
+    {
+        using namespace detail;
+        const auto* groups = reinterpret_cast<const SnapshotGroup*>(base_ + h.groupsOff);
+        const auto* knobs = reinterpret_cast<const SnapshotKnob*>(base_ + h.knobsOff);
+        const auto* slots = reinterpret_cast<const std::uint32_t*>(base_ + h.slotsOff);
+        auto inside = [this](std::uint64_t off, std::uint64_t n, std::size_t elemSize) {
+            return off + n * elemSize <= size_;
+        };
+
+        // groups are numbered breadth-first: parents and children are
+        // on the right side of the group, traversals end
+        for (std::uint32_t gi = 0; gi < h.numGroups; ++gi) {
+            const SnapshotGroup& g = groups[gi];
+            if (not inside(g.name.off, g.name.len, 1) or
+                (gi == 0? g.parent != snapshotNone : g.parent >= gi) or
+                std::uint64_t(g.firstKnob) + g.numKnobs > h.numKnobs or
+                std::uint64_t(g.firstChild) + g.numChildren > h.numGroups or
+                (g.numChildren != 0 and g.firstChild <= gi)) {
+                fail("corrupted group record");
+            }
+        }
+
+        // position of each knob in visit order, `sameName` links go forward;
+        // depth-first walk with own stack of {group, depth}, children pushed
+        // in reverse to pop them in visit order
+        std::vector<std::uint32_t> order(h.numKnobs, snapshotNone);
+        std::vector<bool> seen(h.numGroups, false);
+        std::vector<std::pair<std::uint32_t,std::uint32_t>> stack{{0, 0}};
+        std::uint32_t next = 0;
+        while (not stack.empty()) {
+            const auto [gi, depth] = stack.back();
+            stack.pop_back();
+            if (seen[gi]) fail("corrupted group record");
+            if (depth > snapshotMaxDepth) fail("groups are nested too deep");
+            seen[gi] = true;
+            const SnapshotGroup& g = groups[gi];
+            for (std::uint32_t k = g.firstKnob; k < g.firstKnob + g.numKnobs; ++k) {
+                if (order[k] != snapshotNone or knobs[k].group != gi) fail("corrupted knob record");
+                order[k] = next++;
+            }
+            for (std::uint32_t c = g.firstChild + g.numChildren; c-- > g.firstChild;) {
+                stack.emplace_back(c, depth + 1);
+            }
+        }
+
+        for (std::uint32_t ki = 0; ki < h.numKnobs; ++ki) {
+            const SnapshotKnob& k = knobs[ki];
+            bool ok = order[ki] != snapshotNone and
+                      inside(k.name.off, k.name.len, 1) and inside(k.desc.off, k.desc.len, 1) and
+                      (k.sameName == snapshotNone or
+                       (k.sameName < h.numKnobs and order[k.sameName] > order[ki]));
+            switch (static_cast<Knob::T>(k.type)) {
+            case Knob::T::Bool: case Knob::T::Int: case Knob::T::Float:
+            case Knob::T::Int64: case Knob::T::UInt64: case Knob::T::Double:
+                break;
+            case Knob::T::String:
+                ok = ok and inside(k.value[0], k.value[1], 1);
+                break;
+            case Knob::T::Int64Array:
+            case Knob::T::DoubleArray:
+                ok = ok and k.value[0] % alignof(std::int64_t) == 0 and inside(k.value[0], k.value[1], 8);
+                break;
+            default:
+                ok = false;
+            }
+            if (not ok) fail("corrupted knob record");
+        }
+
+        // lookup probes until an empty slot, there must be one
+        std::uint32_t used = 0;
+        for (std::uint32_t s = 0; s < h.numSlots; ++s) {
+            if (slots[s] == snapshotNone) continue;
+            if (slots[s] >= h.numKnobs) fail("corrupted hash slot");
+            ++used;
+        }
+        if (used == h.numSlots) fail("corrupted hash slot");
+    }
+};
+
+/// Snapshot file mapped read-only into memory.
+class MappedSnapshot
+{
+    void* addr_{nullptr};
+    std::size_t size_{0};
+    SnapshotView view_;
+public:
+    /// Map file `path`, see SnapshotView about `verify`.
+    explicit MappedSnapshot(const std::string& path, bool verify = false)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("knb::MappedSnapshot: can't open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 or st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("knb::MappedSnapshot: can't stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        addr_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr_ == MAP_FAILED) {
+            addr_ = nullptr;
+            throw std::runtime_error("knb::MappedSnapshot: can't mmap " + path);
+        }
+        try { view_ = SnapshotView(addr_, size_, verify); }
+        catch (...) { ::munmap(addr_, size_); throw; }
+    }
+    ~MappedSnapshot() { if (addr_ != nullptr) ::munmap(addr_, size_); }
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    const SnapshotView& view() const {return view_;}
+    SnapshotGroupView root() const {return view_.root();}
+};
+
+namespace detail {
+
+/// Serializes Group into snapshot image.
+struct SnapshotWriter
+{
+    std::vector<const Group*> groups;
+    std::vector<const Knob*> knobs;
+    std::vector<SnapshotGroup> grecs;
+    std::vector<SnapshotKnob> krecs;
+    std::string strings;
+    std::unordered_map<strv,std::uint32_t> stringOff;
+    std::uint32_t stringsOff{0};
+
+    /// Image offsets and counts are 32-bit, throw `std::length_error` if `n` does not fit.
+    static std::uint32_t fit(std::uint64_t n) {
+        if (n > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("knb::makeSnapshot: image does not fit 32-bit offsets");
+        }
+        return static_cast<std::uint32_t>(n);
+    }
+
+    SnapshotStr intern(strv s) {
+        auto [it, inserted] = stringOff.try_emplace(s, static_cast<std::uint32_t>(strings.size()));
+        if (inserted) strings.append(s);
+        return SnapshotStr{stringsOff + it->second, static_cast<std::uint32_t>(s.size())};
+    }
+
+    /// Copy array elements to the string area, return {off,count}.
+    template <typename E>
+    SnapshotStr array(Span<const E> a) {
+        while ((stringsOff + strings.size()) % Buffer<E>::alignment != 0) strings += '\0';
+        const auto off = static_cast<std::uint32_t>(stringsOff + strings.size());
+        strings.append(reinterpret_cast<const char*>(a.data()), a.size() * sizeof(E));
+        return SnapshotStr{off, static_cast<std::uint32_t>(a.size())};
+    }
+
+    std::string write(const Group& root)
+    {
+        // breadth-first numbering of groups and knobs
+        groups.push_back(&root);
+        grecs.push_back(SnapshotGroup{{}, snapshotNone, 0, 0, 0, 0});
+        std::vector<std::uint32_t> depth{0};
+        for (std::size_t gi = 0; gi < groups.size(); ++gi) {
+            const Group& g = *groups[gi];
+            if (depth[gi] > snapshotMaxDepth) {
+                throw std::length_error("knb::makeSnapshot: groups are nested too deep");
+            }
+            grecs[gi].firstKnob = static_cast<std::uint32_t>(knobs.size());
+            grecs[gi].numKnobs = static_cast<std::uint32_t>(g.knobs_.size());
+            for (const auto& name_knob : g.knobs_) knobs.push_back(&name_knob.second);
+            grecs[gi].firstChild = static_cast<std::uint32_t>(groups.size());
+            grecs[gi].numChildren = static_cast<std::uint32_t>(g.groups_.size());
+            for (const auto& name_group : g.groups_) {
+                groups.push_back(&name_group.second);
+                grecs.push_back(SnapshotGroup{{}, static_cast<std::uint32_t>(gi), 0, 0, 0, 0});
+                depth.push_back(depth[gi] + 1);
+            }
+        }
+
+        std::uint64_t slotCount = 1;
+        while (slotCount < 2 * std::uint64_t(knobs.size())) slotCount *= 2;
+
+        // table sizes are checked here, offsets into the string area by the image size
+        SnapshotHeader h{};
+        std::memcpy(h.magic, snapshotMagic, sizeof(h.magic));
+        h.version = snapshotVersion;
+        h.numGroups = fit(groups.size());
+        h.groupsOff = sizeof(SnapshotHeader);
+        h.numKnobs = fit(knobs.size());
+        h.knobsOff = fit(h.groupsOff + std::uint64_t(h.numGroups) * sizeof(SnapshotGroup));
+        h.numSlots = fit(slotCount);
+        h.slotsOff = fit(h.knobsOff + std::uint64_t(h.numKnobs) * sizeof(SnapshotKnob));
+        stringsOff = fit(h.slotsOff + slotCount * sizeof(std::uint32_t));
+        const std::uint32_t numSlots = h.numSlots;
+
+        for (std::size_t gi = 0; gi < groups.size(); ++gi) {
+            grecs[gi].name = intern(groups[gi]->name());
+            for (std::uint32_t k = grecs[gi].firstKnob; k < grecs[gi].firstKnob + grecs[gi].numKnobs; ++k) {
+                const Knob& kb = *knobs[k];
+                SnapshotKnob rec{intern(kb.name()), intern(kb.desc()), static_cast<std::uint32_t>(gi),
+                                 static_cast<std::uint32_t>(kb.typeId()), snapshotNone, {0, 0}};
+                switch (kb.type()){
+                case Knob::T::Bool:   rec.value[0] = kb.asBool(); break;
+                case Knob::T::Int:    { int i = kb.asInt(); std::memcpy(rec.value, &i, sizeof(i)); } break;
+                case Knob::T::Float:  { float f = kb.asFloat(); std::memcpy(rec.value, &f, sizeof(f)); } break;
+                case Knob::T::String: {
+                    auto s = intern(kb.bind<std::string>().get());
+                    rec.value[0] = s.off; rec.value[1] = s.len;
+                } break;
+                case Knob::T::Int64:  { auto v = kb.asInt64(); std::memcpy(rec.value, &v, sizeof(v)); } break;
+                case Knob::T::UInt64: { auto v = kb.asUInt64(); std::memcpy(rec.value, &v, sizeof(v)); } break;
+                case Knob::T::Double: { auto v = kb.asDouble(); std::memcpy(rec.value, &v, sizeof(v)); } break;
+                case Knob::T::Int64Array: {
+                    auto a = array(kb.asInt64Array());
+                    rec.value[0] = a.off; rec.value[1] = a.len;
+                } break;
+                case Knob::T::DoubleArray: {
+                    auto a = array(kb.asDoubleArray());
+                    rec.value[0] = a.off; rec.value[1] = a.len;
+                } break;
+                }
+                krecs.push_back(rec);
+            }
+        }
+
+        // hash of leaf names, knobs are inserted in visit order
+        std::vector<std::uint32_t> slots(numSlots, snapshotNone);
+        std::vector<std::uint32_t> lastSameName(knobs.size(), snapshotNone);
+        std::function<void(std::uint32_t)> index = [&](std::uint32_t gi) {
+            const auto& g = grecs[gi];
+            for (std::uint32_t k = g.firstKnob; k < g.firstKnob + g.numKnobs; ++k) {
+                const strv nm = knobs[k]->name();
+                for (std::uint32_t s = snapshotHash(nm) & (numSlots - 1);; s = (s + 1) & (numSlots - 1)) {
+                    if (slots[s] == snapshotNone) { slots[s] = k; lastSameName[k] = k; break; }
+                    if (knobs[slots[s]]->name() == nm) {
+                        std::uint32_t first = slots[s];
+                        krecs[lastSameName[first]].sameName = k;
+                        lastSameName[first] = k;
+                        break;
+                    }
+                }
+            }
+            for (std::uint32_t c = g.firstChild; c < g.firstChild + g.numChildren; ++c) index(c);
+        };
+        index(0);
+
+        h.size = fit(std::uint64_t(stringsOff) + strings.size());
+        std::string image;
+        image.reserve(h.size);
+        image.append(reinterpret_cast<const char*>(&h), sizeof(h));
+        image.append(reinterpret_cast<const char*>(grecs.data()), grecs.size() * sizeof(SnapshotGroup));
+        image.append(reinterpret_cast<const char*>(krecs.data()), krecs.size() * sizeof(SnapshotKnob));
+        image.append(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(std::uint32_t));
+        image.append(strings);
+        return image;
+    }
+};
+
+} // namespace detail
+
+/** Serialize finalized Group into snapshot image.
+ *
+ * Throw `std::length_error` if it does not fit 32-bit offsets or groups
+ * are nested deeper than `detail::snapshotMaxDepth` levels.
+ */
+inline
+std::string makeSnapshot(const Group& root)
+{
+    profile::Pause pause;
+    root.evaluate();
+    return detail::SnapshotWriter().write(root);
+}
+
+/// Save snapshot image of `root` to file, return false on I/O error.
+inline
+bool saveSnapshot(const Group& root, const std::string& path)
+{
+    const std::string image = makeSnapshot(root);
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(image.data(), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(f);
+}
+
+}
+
+#endif
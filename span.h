@@ -0,0 +1,126 @@
+/**
+ * @file
+ * @brief     Span and aligned Buffer - storage of array-valued knobs
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Array knob (latency table, per-core weights) keeps its elements
+ * in one contiguous Buffer aligned to a cache line, and hands them
+ * out as a Span, so a kernel reads them directly, without parsing:
+ * ~~~{.cpp}
+ * knobs.addKnob("weights", std::vector<double>{0.5, 0.25, 0.25});
+ * knb::Span<const double> w = knobs.at("weights").asDoubleArray();
+ * for (std::size_t i = 0; i < w.size(); ++i) sum += w[i] * x[i];
+ * ~~~
+ * Buffer is padded with zeros to a multiple of its alignment,
+ * vector loads of the last partial block stay inside the buffer.
+ */
+#pragma once
+#ifndef KNOBCPP_SPAN_H_INCLUDED
+#define KNOBCPP_SPAN_H_INCLUDED
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace knb {
+
+/// Pointer and size, like C++20 `std::span<T>`.
+template <typename T>
+class Span
+{
+    T* data_{nullptr};
+    std::size_t size_{0};
+
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() = default;
+    constexpr Span(T* data, std::size_t size):data_(data),size_(size){}
+
+    /// View of a container with contiguous storage, like `std::vector`.
+    template <typename C, typename = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+    constexpr Span(C& c):data_(c.data()),size_(c.size()){}
+
+    constexpr T* data() const {return data_;}
+    constexpr std::size_t size() const {return size_;}
+    constexpr bool empty() const {return size_ == 0;}
+
+    constexpr T* begin() const {return data_;}
+    constexpr T* end() const {return data_ + size_;}
+
+    constexpr T& operator[](std::size_t i) const {return data_[i];}
+    constexpr T& front() const {return data_[0];}
+    constexpr T& back() const {return data_[size_ - 1];}
+
+    constexpr Span subspan(std::size_t offset, std::size_t count) const {
+        return Span(data_ + offset, std::min(count, size_ - offset));
+    }
+};
+
+/** Immutable array of trivially copyable `T`, 64-byte aligned.
+ *
+ * Copies share the storage, copying a knob does not copy its array.
+ */
+template <typename T>
+class Buffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "buffer element is trivially copyable");
+
+    std::shared_ptr<const T> data_;
+    std::size_t size_{0};
+
+public:
+    static constexpr std::size_t alignment = 64;
+
+    Buffer() = default;
+
+    Buffer(const T* first, std::size_t n):size_(n) {
+        if (n == 0) return;
+        const std::size_t bytes = (n * sizeof(T) + alignment - 1) / alignment * alignment;
+        void* p = ::operator new(bytes, std::align_val_t(alignment));
+        std::memcpy(p, first, n * sizeof(T));
+        std::memset(static_cast<char*>(p) + n * sizeof(T), 0, bytes - n * sizeof(T));
+        data_.reset(static_cast<const T*>(p), [](const T* q) {
+            ::operator delete(const_cast<T*>(q), std::align_val_t(alignment));
+        });
+    }
+    Buffer(std::initializer_list<T> l):Buffer(l.begin(), l.size()){}
+    explicit Buffer(const std::vector<T>& v):Buffer(v.data(), v.size()){}
+    explicit Buffer(Span<const T> s):Buffer(s.data(), s.size()){}
+
+    const T* data() const {return data_.get();}
+    std::size_t size() const {return size_;}
+    bool empty() const {return size_ == 0;}
+
+    const T* begin() const {return data();}
+    const T* end() const {return data() + size_;}
+    const T& operator[](std::size_t i) const {return data()[i];}
+
+    /// View of the elements, valid as long as some copy of the buffer lives.
+    Span<const T> span() const {return Span<const T>(data(), size_);}
+
+    std::vector<T> toVector() const {return std::vector<T>(begin(), end());}
+
+    friend bool operator==(const Buffer& a, const Buffer& b) {
+        return a.size_ == b.size_ and std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const Buffer& a, const Buffer& b) {return not (a == b);}
+    friend bool operator<(const Buffer& a, const Buffer& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+    friend bool operator>(const Buffer& a, const Buffer& b) {return b < a;}
+    friend bool operator<=(const Buffer& a, const Buffer& b) {return not (b < a);}
+    friend bool operator>=(const Buffer& a, const Buffer& b) {return not (a < b);}
+};
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @brief     StringPool - interned strings for knob names and descriptions
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Large generated configurations have many thousands of knobs,
+ * most of their memory is names and descriptions, and the same
+ * descriptions repeat over and over. StringPool stores each distinct
+ * string once in big chunks of memory, knobs keep `string_view`s.
+ * Two strings interned in the same pool are equal if and only if
+ * their views point to the same memory.
+ */
+#pragma once
+#ifndef KNOBCPP_STRING_POOL_H_INCLUDED
+#define KNOBCPP_STRING_POOL_H_INCLUDED
+
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace knb {
+
+/** Append-only storage of distinct strings.
+ *
+ * Views returned by `intern` stay valid as long as the pool lives,
+ * that is why pool is shared with `std::shared_ptr` by everybody
+ * who keeps the views. Interning is thread safe.
+ */
+class StringPool
+{
+    static constexpr std::size_t blockSize = 16 * 1024;
+
+    std::pmr::memory_resource* mr_;
+    std::pmr::vector<std::pair<char*,std::size_t>> blocks_;
+    char* cur_{nullptr};
+    std::size_t left_{0};
+    std::size_t bytes_{0};
+    std::pmr::unordered_set<std::string_view> strings_;
+    mutable std::mutex mutex_;
+
+public:
+    using Ptr = std::shared_ptr<StringPool>;
+
+    /// Pool that takes memory from `mr`.
+    explicit StringPool(std::pmr::memory_resource* mr = std::pmr::get_default_resource()):
+        mr_(mr),blocks_(mr),strings_(mr){}
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    ~StringPool() {
+        for (auto [p, n] : blocks_) mr_->deallocate(p, n, 1);
+    }
+
+    /// Make pool that lives in `mr`, with its control block.
+    static Ptr make(std::pmr::memory_resource* mr) {
+        return std::allocate_shared<StringPool>(
+            std::pmr::polymorphic_allocator<StringPool>(mr), mr);
+    }
+
+    /// Return view of the pooled copy of `s`, copy it to the pool if new.
+    std::string_view intern(std::string_view s)
+    {
+        if (s.empty()) return std::string_view();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = strings_.find(s); it != std::end(strings_)) return *it;
+        std::string_view pooled(store(s), s.size());
+        strings_.insert(pooled);
+        return pooled;
+    }
+
+    /// Is `s` a view of a string from this pool.
+    bool owns(std::string_view s) const
+    {
+        if (s.empty()) return true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = strings_.find(s);
+        return it != std::end(strings_) and it->data() == s.data();
+    }
+
+    /// Number of distinct strings.
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return strings_.size();
+    }
+
+    /// Bytes taken by string storage and by the hash set of views.
+    std::size_t bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_ + strings_.bucket_count() * sizeof(void*) +
+               strings_.size() * (sizeof(std::string_view) + 2 * sizeof(void*));
+    }
+
+private:
+    const char* store(std::string_view s)
+    {
+        if (s.size() > blockSize / 4) { // big strings get own block
+            return static_cast<const char*>(std::memcpy(allocate(s.size()), s.data(), s.size()));
+        }
+        if (s.size() > left_) {
+            cur_ = allocate(blockSize); left_ = blockSize;
+        }
+        char* p = cur_;
+        std::memcpy(p, s.data(), s.size());
+        cur_ += s.size(); left_ -= s.size();
+        return p;
+    }
+
+    char* allocate(std::size_t n)
+    {
+        char* p = static_cast<char*>(mr_->allocate(n, 1));
+        blocks_.emplace_back(p, n);
+        bytes_ += n;
+        return p;
+    }
+};
+
+}
+
+#endif
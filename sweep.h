@@ -0,0 +1,419 @@
+/**
+ * @file
+ * @brief     Sweep - parallel multi-parameter experiments over a Group
+ * @author    Igor Lesik
+ * @copyright 2018 Igor Lesik
+ *
+ * Sweep takes a finalized base configuration and a few axes, knob
+ * paths with values to try, and runs user callback for every point
+ * of the sweep on a pool of threads:
+ * ~~~{.cpp}
+ * knb::Sweep sweep(knobs);
+ * sweep.range("cache:ways", 1, 16, 1)                 // grid axes
+ *      .values("cache:policy", {"lru", "fifo"})
+ *      .uniform("cache:ratio", 0.1, 0.9)              // sampled axis
+ *      .samples(1000, knb::Sweep::Sampling::LatinHypercube);
+ * sweep.run([](const knb::SweepPoint& p) {
+ *     simulate(p.at("cache:ways").asInt(), p.at("max").asInt(), ...);
+ * });
+ * ~~~
+ * Points are numbered and decoded from the number when they are run,
+ * nothing is enumerated up front. A point holds only the swept knobs,
+ * other knobs are read from the base tree, so memory does not grow
+ * with the number of points.
+ */
+#pragma once
+#ifndef KNOBCPP_SWEEP_H_INCLUDED
+#define KNOBCPP_SWEEP_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "frozen_group.h"
+
+namespace knb {
+
+class Sweep;
+
+/// One configuration of a Sweep: swept knobs over the base Group.
+class SweepPoint
+{
+    const Sweep& sweep_;
+    std::size_t index_{0};
+    std::vector<Knob> values_; ///< one per axis, copies of base knobs
+    mutable std::map<std::string,Knob,std::less<>> derived_; ///< derived knobs read at this point
+
+    friend class Sweep;
+
+    // Only value changes, name and pool are not touched.
+    template <typename T>
+    void assign(std::size_t axis, T v) {values_[axis].v = v;}
+    void assign(std::size_t axis, const Knob& k) {values_[axis].v = k.v;}
+
+public:
+    /// Point of `sweep`, fill it with `Sweep::point`.
+    explicit SweepPoint(const Sweep& sweep);
+
+    /// Number of the point, `0 <= index < Sweep::size()`.
+    std::size_t index() const {return index_;}
+
+    /// Value of axis number `axis`, in order of declaration.
+    const Knob& operator[](std::size_t axis) const {return values_[axis];}
+
+    std::size_t axes() const {return values_.size();}
+
+    /// Knob by path relative to the base group, swept or not; derived knobs see swept inputs.
+    const Knob& at(strv path) const;
+
+    /// Deep copy of the base group with values of this point.
+    Group group() const;
+
+    /** Fingerprint of the base with values of this point, O(number of axes).
+     *
+     * Same as `group().fingerprint()` if the base is a root group.
+     */
+    Fingerprint fingerprint() const;
+};
+
+/** Sweep over a base Group.
+ *
+ * Grid axes (`values`, `range`) make cartesian product; if there are
+ * sampled axes (`uniform`), each grid point is combined with `samples`
+ * random or Latin hypercube samples of them. Axis knob must exist
+ * in the base and value type must match knob type.
+ * Base group must not change while the sweep runs.
+ */
+class Sweep
+{
+public:
+    enum class Sampling { Random, LatinHypercube };
+
+private:
+    enum class Kind { List, Range, Uniform };
+
+    struct Axis {
+        std::string path;
+        const Knob* knob;      ///< base knob
+        Kind kind;
+        std::vector<Knob> list;
+        double from{0}, step{0}; ///< Range
+        double lo{0}, hi{0};     ///< Uniform
+        std::size_t count{1};    ///< number of grid values
+        std::size_t dim{0};      ///< sampled dimension of Uniform
+    };
+
+    const Group& base_;
+    std::vector<Axis> axes_;
+    std::size_t dims_{0};    ///< number of sampled axes
+    std::size_t samples_{1};
+    Sampling sampling_{Sampling::LatinHypercube};
+    std::uint64_t seed_{1};
+
+    friend class SweepPoint;
+
+public:
+    explicit Sweep(const Group& base):base_(base){}
+
+    const Group& base() const {return base_;}
+
+    /// Grid axis: knob takes each of `vs`.
+    template <typename T>
+    Sweep& values(strv path, const std::vector<T>& vs) {
+        Axis& a = addAxis(path, Kind::List, typeOf<T>());
+        for (const T& v : vs) a.list.emplace_back(a.knob->pool(), a.knob->name(), v, a.knob->desc());
+        a.count = vs.size();
+        return *this;
+    }
+
+    Sweep& values(strv path, std::initializer_list<const char*> vs) {
+        return values(path, std::vector<std::string>(std::begin(vs), std::end(vs)));
+    }
+
+    /// Grid axis: numeric knob takes `from, from+step, ...` up to `to` inclusive.
+    template <typename T>
+    Sweep& range(strv path, T from, T to, T step) {
+        static_assert(std::is_arithmetic_v<T> and not std::is_same_v<T,bool>, "range of numbers");
+        if (not (step > 0) or to < from) {
+            throw std::invalid_argument("knb::Sweep::range: empty range for '" + std::string(path) + "'");
+        }
+        Axis& a = addAxis(path, Kind::Range, typeOf<T>());
+        a.from = from; a.step = step;
+        a.count = static_cast<std::size_t>(std::floor((double(to) - from) / step + 1e-9)) + 1;
+        return *this;
+    }
+
+    /// Sampled axis: numeric knob gets values from `[lo, hi]`, integers are uniform too.
+    Sweep& uniform(strv path, double lo, double hi) {
+        const Knob::T t = base_.atPath(path).type();
+        Axis& a = addAxis(path, Kind::Uniform, isNumber(t)? t : Knob::T::Float);
+        a.lo = lo; a.hi = hi; a.dim = dims_++;
+        return *this;
+    }
+
+    /// Number of samples of `uniform` axes per grid point.
+    Sweep& samples(std::size_t n, Sampling s = Sampling::LatinHypercube, std::uint64_t seed = 1) {
+        samples_ = std::max<std::size_t>(n, 1); sampling_ = s; seed_ = seed;
+        return *this;
+    }
+
+    /// Number of points.
+    std::size_t size() const {
+        std::size_t n = (dims_ != 0)? samples_ : 1;
+        for (const Axis& a : axes_) n *= a.count;
+        return n;
+    }
+
+    /// Decode point number `i` into `p`, axes added after `p` was made are added to it.
+    void point(std::size_t i, SweepPoint& p) const;
+
+    /** Call `f(const SweepPoint&)` for every point on `threads` threads.
+     *
+     * Calling thread is one of them; `0` means one per core. Each thread
+     * takes small chunks of points from its own share and steals half of
+     * the rest from another thread when its share is done. If `f` throws,
+     * remaining points are skipped and the first exception is rethrown.
+     */
+    template <typename F>
+    void run(F&& f, unsigned threads = 0) const;
+
+private:
+    /// Add axis for knob `path` with values of type `t`.
+    Axis& addAxis(strv path, Kind kind, Knob::T t) {
+        const Knob& k = base_.atPath(path);
+        if (base_.isDerived(path)) {
+            throw std::invalid_argument("knb::Sweep: knob '" + std::string(path) + "' is derived, sweep its inputs");
+        }
+        if (k.type() != t) {
+            throw std::invalid_argument("knb::Sweep: knob '" + std::string(path) + "' has type id " +
+                std::to_string(k.typeId()) + ", axis values type id " +
+                std::to_string(static_cast<std::size_t>(t)));
+        }
+        axes_.push_back(Axis{std::string(path), &k, kind});
+        return axes_.back();
+    }
+
+    template <typename T>
+    static constexpr Knob::T typeOf() {return Knob::typeOf<T>();}
+
+    static bool isNumber(Knob::T t) {
+        return t == Knob::T::Int or t == Knob::T::Float or t == Knob::T::Int64 or
+               t == Knob::T::UInt64 or t == Knob::T::Double;
+    }
+
+    static bool isInteger(Knob::T t) {
+        return t == Knob::T::Int or t == Knob::T::Int64 or t == Knob::T::UInt64;
+    }
+
+    /// Assign `x` converted to numeric type `t`, integers are already whole.
+    static void assignNumber(SweepPoint& p, std::size_t axis, Knob::T t, double x) {
+        switch (t) {
+        case Knob::T::Int:    p.assign(axis, static_cast<int>(x)); break;
+        case Knob::T::Int64:  p.assign(axis, static_cast<std::int64_t>(x)); break;
+        case Knob::T::UInt64: p.assign(axis, static_cast<std::uint64_t>(x)); break;
+        case Knob::T::Double: p.assign(axis, x); break;
+        default:              p.assign(axis, static_cast<float>(x)); break;
+        }
+    }
+
+    /// Value in `[0,1)` of sampled dimension `dim` for sample `j`.
+    double sample(std::size_t j, std::size_t dim) const {
+        const std::uint64_t key = seed_ * 0x9e3779b97f4a7c15ull + dim;
+        const double jitter = (detail::mix(key ^ detail::mix(j)) >> 11) * 0x1.0p-53;
+        if (sampling_ == Sampling::Random) return jitter;
+        return (permute(j, samples_, key) + jitter) / samples_;
+    }
+
+    /** Random permutation of `[0,n)` without a table.
+     *
+     * Feistel network over the smallest even number of bits that
+     * covers `n` is a bijection; values `>= n` are walked again
+     * until they fall into the range (cycle walking).
+     */
+    static std::uint64_t permute(std::uint64_t x, std::uint64_t n, std::uint64_t key) {
+        unsigned bits = 2;
+        while ((std::uint64_t(1) << bits) < n) bits += 2;
+        const unsigned half = bits / 2;
+        const std::uint64_t mask = (std::uint64_t(1) << half) - 1;
+        do {
+            std::uint64_t l = x >> half, r = x & mask;
+            for (std::uint64_t round = 0; round < 4; ++round) {
+                const std::uint64_t t = l ^ (detail::mix(r ^ (key + round * 0x632be59bd9b4e019ull)) & mask);
+                l = r; r = t;
+            }
+            x = (l << half) | r;
+        } while (x >= n);
+        return x;
+    }
+};
+
+inline
+SweepPoint::SweepPoint(const Sweep& sweep):sweep_(sweep)
+{
+    for (const auto& a : sweep.axes_) values_.push_back(*a.knob);
+}
+
+inline
+const Knob& SweepPoint::at(strv path) const
+{
+    for (std::size_t a = 0; a < values_.size(); ++a) {
+        if (sweep_.axes_[a].path == path) return values_[a];
+    }
+    const Group& base = sweep_.base_;
+    if (not base.isDerived(path)) return base.atPath(path);
+    if (const auto d = derived_.find(path); d != std::end(derived_)) return d->second;
+    std::vector<const Knob*> args;
+    for (const std::string& in : base.derivedInputs(path)) args.push_back(&at(in));
+    Knob& k = derived_[std::string(path)];
+    base.derive(path, DerivedInputs(args.data(), args.size()), k);
+    return k;
+}
+
+inline
+Group SweepPoint::group() const
+{
+    Group g(sweep_.base_);
+    for (std::size_t a = 0; a < values_.size(); ++a) {
+        strv path = sweep_.axes_[a].path;
+        Group* owner = &g;
+        for (auto pos = path.find(':'); pos != strv::npos; pos = path.find(':')) {
+            owner = &owner->getGroup(path.substr(0, pos));
+            path.remove_prefix(pos + 1);
+        }
+        owner->addKnob(values_[a]);
+    }
+    return g;
+}
+
+inline
+Fingerprint SweepPoint::fingerprint() const
+{
+    const Group& base = sweep_.base_;
+    Fingerprint fp = base.fingerprint();
+    for (std::size_t a = 0; a < values_.size(); ++a) {
+        const Sweep::Axis& axis = sweep_.axes_[a];
+        fp -= base.knobFingerprint(axis.path, *axis.knob);
+        fp += base.knobFingerprint(axis.path, values_[a]);
+    }
+    return fp;
+}
+
+inline
+void Sweep::point(std::size_t i, SweepPoint& p) const
+{
+    p.index_ = i;
+    p.derived_.clear();
+    // axes added after the point was made
+    for (std::size_t n = p.values_.size(); n < axes_.size(); ++n) p.values_.push_back(*axes_[n].knob);
+    const std::size_t j = (dims_ != 0)? i % samples_ : 0;
+    std::size_t g = (dims_ != 0)? i / samples_ : i;
+    for (std::size_t n = 0; n < axes_.size(); ++n) {
+        const Axis& a = axes_[n];
+        if (a.kind == Kind::Uniform) {
+            const double u = sample(j, a.dim);
+            if (isInteger(a.knob->type())) {
+                const double span = std::floor(a.hi) - std::ceil(a.lo) + 1;
+                assignNumber(p, n, a.knob->type(), std::ceil(a.lo) + std::min(std::floor(u * span), span - 1));
+            } else {
+                assignNumber(p, n, a.knob->type(), a.lo + u * (a.hi - a.lo));
+            }
+            continue;
+        }
+        const std::size_t k = g % a.count;
+        g /= a.count;
+        if (a.kind == Kind::List) {
+            p.assign(n, a.list[k]);
+        } else if (isInteger(a.knob->type())) {
+            assignNumber(p, n, a.knob->type(), std::round(a.from + k * a.step));
+        } else {
+            assignNumber(p, n, a.knob->type(), a.from + k * a.step);
+        }
+    }
+}
+
+namespace detail {
+
+/// Share of points of one sweep thread, on its own cache line.
+struct alignas(64) SweepRange {
+    std::mutex mutex;
+    std::size_t begin{0}, end{0};
+};
+
+} // namespace detail
+
+template <typename F>
+void Sweep::run(F&& f, unsigned threads) const
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t n = size();
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(n, 1)));
+    const std::size_t chunk = std::clamp<std::size_t>(n / (threads * 64), 1, 256);
+
+    std::vector<detail::SweepRange> ranges(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        ranges[t].begin = n * t / threads;
+        ranges[t].end = n * (t + 1) / threads;
+    }
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    // Take chunk from own range, or steal upper half of another range.
+    auto next = [&](unsigned w, std::size_t& b, std::size_t& e) {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(ranges[w].mutex);
+                if (ranges[w].begin < ranges[w].end) {
+                    b = ranges[w].begin;
+                    e = std::min(b + chunk, ranges[w].end);
+                    ranges[w].begin = e;
+                    return true;
+                }
+            }
+            bool stolen = false;
+            for (unsigned k = 1; k < threads and not stolen; ++k) {
+                detail::SweepRange& victim = ranges[(w + k) % threads];
+                std::size_t sb, se;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (victim.end - victim.begin == 0) continue;
+                    sb = victim.begin + (victim.end - victim.begin) / 2;
+                    se = victim.end;
+                    victim.end = sb;
+                }
+                std::lock_guard<std::mutex> lock(ranges[w].mutex);
+                ranges[w].begin = sb; ranges[w].end = se;
+                stolen = true;
+            }
+            if (not stolen) return false;
+        }
+    };
+
+    auto worker = [&](unsigned w) {
+        try {
+            SweepPoint p(*this);
+            std::size_t b, e;
+            while (not failed.load(std::memory_order_relaxed) and next(w, b, e)) {
+                for (std::size_t i = b; i < e; ++i) { point(i, p); f(p); }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (not error) error = std::current_exception();
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+}
+
+#endif
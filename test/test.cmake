@@ -2,6 +2,42 @@ add_executable (test_static_knob test/test_static_knob.cpp)
 add_executable (test_runtime_knob test/test_runtime_knob.cpp)
 add_executable (test_group test/test_group.cpp)
 add_executable (test_program_options test/test_program_options.cpp)
+add_executable (test_frozen_group test/test_frozen_group.cpp)
+add_executable (test_string_pool test/test_string_pool.cpp)
+add_executable (test_snapshot test/test_snapshot.cpp)
+add_executable (test_config_file test/test_config_file.cpp)
+add_executable (test_config_handle test/test_config_handle.cpp)
+add_executable (test_config_struct test/test_config_struct.cpp)
+add_executable (test_dispatch test/test_dispatch.cpp)
+add_executable (test_sweep test/test_sweep.cpp)
+add_executable (test_layered_group test/test_layered_group.cpp)
+add_executable (test_parallel_visit test/test_parallel_visit.cpp)
+add_executable (test_serializer test/test_serializer.cpp)
+add_executable (test_codec test/test_codec.cpp)
+add_executable (test_span test/test_span.cpp)
+add_executable (test_access_profile test/test_access_profile.cpp)
+add_executable (test_fingerprint test/test_fingerprint.cpp)
+add_executable (test_derived test/test_derived.cpp)
+add_executable (test_shared_config test/test_shared_config.cpp)
+add_executable (test_group_builder test/test_group_builder.cpp)
+
+target_link_libraries(test_group Threads::Threads)
+target_link_libraries(test_config_handle Threads::Threads)
+target_link_libraries(test_sweep Threads::Threads)
+target_link_libraries(test_parallel_visit Threads::Threads)
+target_link_libraries(test_access_profile Threads::Threads)
+target_link_libraries(test_fingerprint Threads::Threads)
+target_link_libraries(test_derived Threads::Threads)
+target_link_libraries(test_shared_config Threads::Threads)
+
+# shm_open is in librt before glibc 2.34.
+find_library(KNOBCPP_RT_LIBRARY rt)
+if (KNOBCPP_RT_LIBRARY)
+    target_link_libraries(test_shared_config ${KNOBCPP_RT_LIBRARY})
+endif()
+
+# Knob and Group count accesses only when built with KNOBCPP_PROFILE.
+target_compile_definitions(test_access_profile PRIVATE KNOBCPP_PROFILE)
 
 
 # After enablig testing we can do `make test`
@@ -25,3 +61,75 @@ add_test(NAME test_program_options
     COMMAND test_program_options
 )
 
+
+add_test(NAME test_frozen_group
+    COMMAND test_frozen_group
+)
+
+add_test(NAME test_string_pool
+    COMMAND test_string_pool
+)
+
+add_test(NAME test_snapshot
+    COMMAND test_snapshot
+)
+
+add_test(NAME test_config_file
+    COMMAND test_config_file
+)
+
+add_test(NAME test_config_handle
+    COMMAND test_config_handle
+)
+
+add_test(NAME test_config_struct
+    COMMAND test_config_struct
+)
+
+add_test(NAME test_dispatch
+    COMMAND test_dispatch
+)
+
+add_test(NAME test_sweep
+    COMMAND test_sweep
+)
+
+add_test(NAME test_layered_group
+    COMMAND test_layered_group
+)
+
+add_test(NAME test_parallel_visit
+    COMMAND test_parallel_visit
+)
+
+add_test(NAME test_serializer
+    COMMAND test_serializer
+)
+
+add_test(NAME test_codec
+    COMMAND test_codec
+)
+
+add_test(NAME test_span
+    COMMAND test_span
+)
+
+add_test(NAME test_access_profile
+    COMMAND test_access_profile
+)
+
+add_test(NAME test_fingerprint
+    COMMAND test_fingerprint
+)
+
+add_test(NAME test_derived
+    COMMAND test_derived
+)
+
+add_test(NAME test_shared_config
+    COMMAND test_shared_config
+)
+
+add_test(NAME test_group_builder
+    COMMAND test_group_builder
+)
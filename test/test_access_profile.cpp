@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+#include "../access_report.h"
+#include "../frozen_group.h"
+#include "../serializer.h"
+
+using namespace knb;
+
+static_assert(profileKnobAccess == true, "test is built with KNOBCPP_PROFILE");
+
+[[maybe_unused]] static const AccessRecord* record(const std::vector<AccessRecord>& recs, strv path)
+{
+    for (const AccessRecord& r : recs) if (r.path == path) return &r;
+    return nullptr;
+}
+
+bool test_AccessProfile_counts()
+{
+    Group knobs("sim", false);
+    knobs.addKnob("ways", 8).addKnob("trace", false).addKnob("dead", 1).addKnob("name", "run");
+    knobs.getGroup("cache").addKnob("size", 32768).addKnob("unused-too", 0.5f);
+    profile::reset();
+
+    // counted reads are checked outside of assert, they must happen with NDEBUG too
+    for (int i = 0; i < 100; ++i) if (knobs.at("ways").asInt() != 8) return false;
+    if (knobs.gr("cache").at("size").asInt() != 32768) return false;
+    if (not std::get<0>(knobs.findKnob("trace"))) return false;
+    if (knobs.find("nope") != nullptr) return false;
+    [[maybe_unused]] KnobHandle<std::string> name = knobs.bind<std::string>("name");
+    for (int i = 0; i < 10; ++i) assert(*name == "run"); // handle reads are not counted
+
+    // library reads of every knob are not counted
+    std::string text;
+    serialize(knobs, Format::KeyValue, text);
+    FrozenGroup frozen(knobs);
+
+    const profile::Counters counters = profile::counters();
+    [[maybe_unused]] const profile::Counter& ways = counters.at(&knobs.at("ways"));
+    assert(ways.reads == 100 and ways.lookups == 100 and ways.firstNs >= 0);
+    assert(counters.at(&knobs.gr("cache")).lookups == 1);
+    assert(counters.at(&knobs.at("trace")).reads == 0);
+    assert(counters.at(&knobs.at("name")).reads == 1);
+
+    AccessReport report = accessReport(knobs, counters);
+    assert(report.knobs.size() == 4 and report.knobs[0].path == "ways");
+    assert(record(report.knobs, "cache:size")->count.accesses() == 2);
+    assert(report.groups.size() == 1 and report.groups[0].path == "cache");
+    assert(report.unused == std::vector<std::string>({"dead", "cache:unused-too"}));
+
+    std::ostringstream o;
+    report.print(o, 2);
+    const std::string s = o.str();
+    assert(s.find("used knobs: 4\n") != std::string::npos);
+    assert(s.find("  ways\n") != std::string::npos and s.find("  trace\n") == std::string::npos);
+    assert(s.find("unused knobs: 2\n  dead\n  cache:unused-too\n") != std::string::npos);
+
+    return true;
+}
+
+bool test_AccessProfile_threads()
+{
+    Group knobs("sim", false);
+    knobs.addKnob("hot", 1).addKnob("cold", 2);
+    profile::reset();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&]{
+            [[maybe_unused]] const Knob& k = knobs.at("hot");
+            for (int i = 0; i < 1000; ++i) assert(k.asInt() == 1);
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    AccessReport report = accessReport(knobs);
+    assert(report.knobs.size() == 1);
+    assert(report.knobs[0].count.reads == 4000 and report.knobs[0].count.lookups == 4);
+    assert(report.unused == std::vector<std::string>({"cold"}));
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_AccessProfile_counts(); !ok) return 1;
+    if (auto ok=test_AccessProfile_threads(); !ok) return 1;
+
+    return 0;
+}
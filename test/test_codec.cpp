@@ -0,0 +1,152 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <random>
+
+#include "../codec.h"
+#include "../knob.h"
+#include "../program_options.h"
+#include "../config_file.h"
+
+using namespace knb;
+
+[[maybe_unused]] static bool fails(Status st, const char* what) { return not st and std::strcmp(st.what(), what) == 0; }
+
+bool test_Codec_decode()
+{
+    [[maybe_unused]] int i = 0;
+    assert(codec::decode("42", i) and i == 42);
+    assert(codec::decode("+42", i) and i == 42);
+    assert(codec::decode("-7", i) and i == -7);
+    assert(codec::decode("64KiB", i) and i == 64 * 1024);
+    assert(codec::decode("64Ki", i) and i == 64 * 1024);
+    assert(codec::decode("4kB", i) and i == 4000);
+    assert(codec::decode("1.5G", i) and i == 1500000000);
+    assert(codec::decode("1e3", i) and i == 1000);
+    assert(codec::decode("1MiB", i) and i == 1 << 20);
+    assert(fails(codec::decode("2GiB", i), "out of range") and i == 1 << 20);
+    assert(fails(codec::decode("99999999999", i), "out of range"));
+    assert(fails(codec::decode("1.5", i), "not an integer"));
+    assert(fails(codec::decode("12abc", i), "unknown unit"));
+    assert(fails(codec::decode("12 ", i), "unknown unit"));
+    assert(fails(codec::decode("abc", i), "not a number"));
+    assert(fails(codec::decode("", i), "empty value"));
+    assert(fails(codec::decode("10ms", i), "unknown unit")); // no time unit
+
+    // time, converted to the unit of the knob
+    assert(codec::decode("10ms", i, {0, 1e9, Unit::Microseconds}) and i == 10000);
+    assert(codec::decode("2min", i, {0, 1e9, Unit::Seconds}) and i == 120);
+    assert(codec::decode("250", i, {0, 1e9, Unit::Milliseconds}) and i == 250);
+    assert(fails(codec::decode("10us", i, {0, 1e9, Unit::Milliseconds}), "not an integer"));
+    assert(fails(codec::decode("10KiB", i, {0, 1e9, Unit::Seconds}), "unknown time unit"));
+    [[maybe_unused]] float f = 0;
+    assert(codec::decode("10ms", f, {0, 1e9, Unit::Seconds}) and f == 0.01f);
+
+    // range
+    assert(codec::decode("16", i, {1, 16}) and i == 16);
+    assert(fails(codec::decode("17", i, {1, 16}), "outside of knob range") and i == 16);
+    assert(fails(codec::decode("0", i, {1, 16}), "outside of knob range"));
+
+    assert(codec::decode("0.25", f) and f == 0.25f);
+    assert(codec::decode(".5", f) and f == 0.5f);
+    assert(codec::decode("1.5K", f) and f == 1500.0f);
+    assert(codec::decode("inf", f) and std::isinf(f));
+    assert(fails(codec::decode("1e60", f), "out of range"));
+    assert(fails(codec::decode("0.5x", f), "unknown unit"));
+
+    [[maybe_unused]] bool b = false;
+    assert(codec::decode("true", b) and b);
+    assert(codec::decode("off", b) and not b);
+    assert(codec::decode("yes", b) and b);
+    assert(codec::decode("", b) and not b);
+    assert(fails(codec::decode("maybe", b), "not a boolean") and not b);
+
+    return true;
+}
+
+bool test_Codec_roundtrip()
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::uint32_t> bits;
+    for (int n = 0; n < 100000; ++n) {
+        std::uint32_t u = bits(rng);
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        if (not std::isfinite(f)) continue;
+        [[maybe_unused]] float back;
+        assert(codec::decode(codec::encode(f), back) and back == f);
+    }
+    assert(codec::encode(0.1f) == "0.1");
+    assert(codec::encode(-3) == "-3");
+    assert(Knob("r", 0.1f).asString() == "0.1");
+    assert(Knob("n", 2147483647).asString() == "2147483647");
+
+    return true;
+}
+
+bool test_Codec_group()
+{
+    Group knobs("sim", false);
+    knobs.addKnob("ways", 8, "Cache ways").addKnob("ratio", 0.5f).addKnob("trace", false)
+         .addKnob("name", "run");
+    knobs.getGroup("cache").addKnob("size", 32768).addKnob("latency", 100);
+    knobs.constrain("ways", {1, 64}).constrain("cache:size", {1024, 1 << 30, Unit::Bytes})
+         .constrain("cache:latency", {0, 1e6, Unit::Nanoseconds});
+
+    assert(knobs.range("ways")->max == 64 and knobs.range("ratio") == nullptr);
+    assert(knobs.range("cache:size")->unit == Unit::Bytes);
+
+    assert(knobs.changeValue(&knobs.at("ways"), "16") and knobs.at("ways").asInt() == 16);
+    assert(fails(knobs.changeValue(&knobs.at("ways"), "128"), "outside of knob range"));
+    assert(knobs.at("ways").asInt() == 16);
+    assert(fails(knobs.changeValue(&knobs.at("ways"), "many"), "not a number"));
+    assert(knobs.changeValue(&knobs.at("trace"), "on") and knobs.at("trace").asBool());
+    assert(knobs.changeValue(&knobs.at("trace"), "false") and not knobs.at("trace").asBool());
+    assert(fails(knobs.changeValue(&knobs.at("trace"), "sure"), "not a boolean"));
+    assert(knobs.changeValue(&knobs.at("name"), "other") and knobs.at("name").asString() == "other");
+
+    [[maybe_unused]] const Knob& size = knobs.atPath("cache:size");
+    assert(knobs.changeValue(&size, "64KiB") and size.asInt() == 65536);
+    assert(knobs.changeValue(&knobs.atPath("cache:latency"), "2us"));
+    assert(knobs.atPath("cache:latency").asInt() == 2000);
+
+    [[maybe_unused]] bool thrown = false;
+    try { knobs.constrain("ways", {32, 64}); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+    thrown = false;
+    try { knobs.constrain("name", {}); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+
+    // ranges are copied with the tree
+    Group copy(knobs);
+    assert(copy.range("cache:size") != nullptr);
+    assert(not copy.changeValue(&copy.atPath("cache:size"), "512"));
+
+    // finalized group checks value, but does not change it
+    copy.finalize();
+    assert(fails(copy.changeValue(&copy.at("ways"), "4"), Group::immutableError));
+    assert(copy.at("ways").asInt() == 16);
+    assert(not copy.changeValue(&copy.at("ways"), "4x"));
+
+    // options and configuration files use the same codec
+    OptionParser parser;
+    assert(not parser.parse({"--size=2MiB", "--ways=99", "--ratio", "1e-3"}, knobs));
+    assert(size.asInt() == 2 << 20 and knobs.at("ratio").asFloat() == 1e-3f);
+    assert(parser.errors().size() == 1 and parser.errors()[0] == "--ways=99: outside of knob range");
+
+    auto [ok, errors] = loadConfig("[cache]\nsize = 1GiB\nlatency = 1ms\n", knobs);
+    assert(ok and size.asInt() == 1 << 30 and knobs.atPath("cache:latency").asInt() == 1000000);
+    std::tie(ok, errors) = loadConfig("[cache]\nsize = 2GiB\n", knobs);
+    assert(not ok and errors[0] == "line 2: can't convert '2GiB' to type of knob 'size': out of range");
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Codec_decode(); !ok) return 1;
+    if (auto ok=test_Codec_roundtrip(); !ok) return 1;
+    if (auto ok=test_Codec_group(); !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+#include "../config_file.h"
+
+using namespace knb;
+
+const char* config = R"(# test configuration
+version = "1.2.3"   # quoted string
+max = 100
+ratio = 0.5
+enabled = true
+
+[feature-A]
+A-val1 = 345
+A-X:A-X-val2 = 987
+
+[feature-B:B-X]   ; nested section
+policy = lru
+name = "a # b"
+big = 1e3
+)";
+
+bool test_Config_load()
+{
+    Group knobs("root");
+    auto [ok, errors] = loadConfig(config, knobs);
+    assert(ok and errors.empty());
+
+    assert(knobs.at("version").asString() == "1.2.3");
+    assert(knobs.at("max").asInt() == 100);
+    assert(knobs.at("ratio").asFloat() == 0.5f);
+    assert(knobs.at("enabled").asBool() == true);
+    assert(knobs.atPath("feature-A:A-val1").asInt() == 345);
+    assert(knobs.atPath("feature-A:A-X:A-X-val2").asInt() == 987);
+    assert(knobs.atPath("feature-B:B-X:policy").asString() == "lru");
+    assert(knobs.atPath("feature-B:B-X:name").asString() == "a # b");
+    assert(knobs.atPath("feature-B:B-X:big").asFloat() == 1000.0f);
+
+    return true;
+}
+
+bool test_Config_existing()
+{
+    Group knobs("root", false);
+    knobs.addKnob("max", 1, "max value")
+         .addKnob("ratio", 0.1f)
+         .addKnob("name", "x")
+         .addKnob("enabled", false);
+    knobs.getGroup("g").addKnob("v", 2);
+    [[maybe_unused]] KnobHandle<int> h = knobs.bind<int>("max");
+
+    auto [ok, errors] = loadConfig(
+        "max = 200\nratio = 3\nname = 42\nenabled = 1\n[g]\nv = oops\nbroken line\n[x\n", knobs);
+    assert(not ok and errors.size() == 3);
+    assert(errors[0] == "line 6: can't convert 'oops' to type of knob 'v': not a number");
+    assert(errors[1].find("line 7:") == 0 and errors[2].find("line 8:") == 0);
+
+    // existing knobs keep their type and description
+    assert(knobs.at("max").asInt() == 200 and knobs.at("max").desc() == "max value");
+    assert(h.get() == 200);
+    assert(knobs.at("ratio").asFloat() == 3.0f);
+    assert(knobs.at("name").asString() == "42");
+    assert(knobs.at("enabled").asBool() == true);
+    assert(knobs.gr("g").at("v").asInt() == 2);
+
+    return true;
+}
+
+bool test_Config_reload()
+{
+    Group knobs("root", false);
+    knobs.addLiveKnob("rate", 10).getGroup("g").addKnob("v", 2);
+    knobs.constrain("g:v", {0, 100});
+    [[maybe_unused]] LiveKnob<int> rate = knobs.live<int>("rate");
+    int seen = 0;
+    knobs.subscribe("rate", [&](const Knob& k) { seen = k.asInt(); });
+
+    // reload goes through changeValue: live readers, subscribers and ranges
+    auto [ok, errors] = loadConfig("rate = 20\n[g]\nv = 500\n", knobs);
+    assert(not ok and errors.size() == 1);
+    assert(errors[0] == "line 3: can't convert '500' to type of knob 'v': outside of knob range");
+    assert(rate.get() == 20 and seen == 20 and knobs.at("rate").asInt() == 20);
+    assert(knobs.gr("g").at("v").asInt() == 2);
+
+    // finalized tree keeps its values, live knobs still change
+    knobs.finalize();
+    std::tie(ok, errors) = loadConfig("rate = 30\n[g]\nv = 5\n", knobs);
+    assert(not ok and errors.size() == 1 and errors[0] == "line 3: can't change knob 'v': group is immutable");
+    assert(rate.get() == 30 and knobs.gr("g").at("v").asInt() == 2);
+
+    return true;
+}
+
+bool test_Config_chunks()
+{
+    // every chunk size must give the same tree
+    Group whole("root");
+    loadConfig(config, whole);
+    std::vector<std::string> expected;
+    whole.visit([&](const Knob& k){ expected.push_back(std::string(k.name()) + "=" + k.asString()); });
+
+    const std::string file = "test_config_file.ini";
+    std::ofstream(file) << config << "last = 7"; // no final new line
+
+    for (std::size_t chunk : {1, 2, 3, 7, 16, 1000}) {
+        Group knobs("root");
+        auto [ok, errors] = loadConfigFile(file, knobs, chunk);
+        assert(ok);
+        std::vector<std::string> got;
+        knobs.visit([&](const Knob& k){
+            if (k.name() != "last") got.push_back(std::string(k.name()) + "=" + k.asString());
+        });
+        assert(got == expected);
+        assert(knobs.atPath("feature-B:B-X:last").asInt() == 7);
+    }
+    std::remove(file.c_str());
+
+    Group knobs("root");
+    assert(not std::get<0>(loadConfigFile("no-such-file.ini", knobs)));
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Config_load();     !ok) return 1;
+    if (auto ok=test_Config_existing(); !ok) return 1;
+    if (auto ok=test_Config_reload(); !ok) return 1;
+    if (auto ok=test_Config_chunks();   !ok) return 1;
+
+    return 0;
+}
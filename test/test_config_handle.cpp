@@ -0,0 +1,107 @@
+#include <cassert>
+#include <thread>
+
+#include "../config_handle.h"
+
+static knb::Group makeConfig(int version)
+{
+    knb::Group knobs("config", false);
+    knobs.addKnob("version", version)
+         .addKnob("a", version)
+         .getGroup("sub").addKnob("b", version);
+    return knobs;
+}
+
+static void test_ConfigHandle_publish()
+{
+    knb::ConfigHandle config(makeConfig(0));
+    knb::ConfigHandle::Reader reader(config);
+
+    {
+        auto cfg = reader.read();
+        assert(cfg->at("version").asInt() == 0);
+
+        config.publish(makeConfig(1));
+        assert(config.version() == 1);
+
+        // old snapshot is alive while reader holds it
+        assert(cfg->at("version").asInt() == 0);
+        assert(config.collect() == 1);
+
+        // nested read sees the same snapshot
+        auto again = reader.read();
+        assert(&*again == &*cfg);
+    }
+    assert(config.collect() == 0);
+
+    auto cfg = reader.read();
+    assert(cfg->at("version").asInt() == 1);
+    assert(cfg->atPath("sub:b").asInt() == 1);
+
+    // published snapshot is immutable
+    knb::Group& g = const_cast<knb::Group&>(*cfg);
+    g.changeValue(&g.at("a"), "5");
+    assert(cfg->at("a").asInt() == 1);
+}
+
+static void test_ConfigHandle_threads()
+{
+    knb::ConfigHandle config(makeConfig(0));
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]{
+            knb::ConfigHandle::Reader reader(config);
+            [[maybe_unused]] int last = 0;
+            while (not stop.load()) {
+                auto cfg = reader.read();
+                const int v = cfg->at("version").asInt();
+                assert(v >= last);
+                assert(cfg->at("a").asInt() == v);
+                assert(cfg->atPath("sub:b").asInt() == v);
+                last = v;
+            }
+        });
+    }
+    for (int v = 1; v <= 200; ++v) {
+        config.publish(makeConfig(v));
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    assert(config.collect() == 0);
+    knb::ConfigHandle::Reader reader(config);
+    assert(reader.read()->at("version").asInt() == 200);
+}
+
+static void test_ConfigHandle_derived()
+{
+    std::atomic<int> calls{0};
+    auto make = [&](int ways) {
+        knb::Group knobs("config", false);
+        knobs.addKnob("size", 32768).addKnob("ways", ways);
+        knobs.addDerived("way-size", {"size", "ways"}, [&](const knb::DerivedInputs& in) {
+            ++calls; return in[0].asInt() / in[1].asInt();
+        });
+        return knobs;
+    };
+
+    // derived knobs are computed when a snapshot is published, not by readers
+    knb::ConfigHandle config(make(8));
+    assert(calls == 1);
+    config.publish(make(4));
+    assert(calls == 2);
+    knb::ConfigHandle::Reader reader(config);
+    assert(reader.read()->at("way-size").asInt() == 8192 and calls == 2);
+}
+
+int main(int argc, char* argv[])
+{
+    test_ConfigHandle_publish();
+    test_ConfigHandle_threads();
+    test_ConfigHandle_derived();
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+
+#include "../config_struct.h"
+#include "../program_options.h"
+
+using namespace knb;
+
+struct CacheCfg {
+    int ways = 8;
+    bool prefetch = true;
+    float ratio = 0.5f;
+    std::string policy = "lru";
+};
+
+const auto binding = StructBinding<CacheCfg>()
+    .field("cache:ways",     &CacheCfg::ways,     "Number of ways")
+    .field("cache:prefetch", &CacheCfg::prefetch, "Enable prefetcher")
+    .field("cache:ratio",    &CacheCfg::ratio)
+    .field("policy",         &CacheCfg::policy,   "Replacement policy");
+
+bool test_Struct_load()
+{
+    Group knobs("root", false);
+    binding.addKnobs(knobs);
+    assert(knobs.atPath("cache:ways").asInt() == 8);
+    assert(knobs.atPath("cache:ways").desc() == "Number of ways");
+    assert(knobs.at("policy").asString() == "lru");
+
+    std::ostringstream help;
+    printOptions(knobs, help);
+    assert(help.str().find("--ways [8]") != std::string::npos);
+    assert(help.str().find("Replacement policy") != std::string::npos);
+
+    std::vector<std::string> options{"--ways", "16", "--no-prefetch", "--policy", "random"};
+    parseOptions(options, knobs);
+    knobs.finalize();
+
+    CacheCfg cfg = binding.load(knobs);
+    assert(cfg.ways == 16 and not cfg.prefetch and cfg.ratio == 0.5f and cfg.policy == "random");
+
+    return true;
+}
+
+bool test_Struct_errors()
+{
+    Group knobs("root");
+    knobs.getGroup("cache").addKnob("ways", 4.0f).addKnob("prefetch", false);
+    knobs.addKnob("policy", 1);
+
+    CacheCfg cfg;
+    try {
+        binding.load(knobs, cfg);
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        const std::string what = e.what();
+        assert(what.find("cache:ways") != std::string::npos);
+        assert(what.find("cache:ratio: no such knob") != std::string::npos);
+        assert(what.find("policy") != std::string::npos);
+        assert(what.find("prefetch") == std::string::npos);
+    }
+    // nothing is copied on error
+    assert(cfg.prefetch and cfg.ways == 8);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Struct_load();   !ok) return 1;
+    if (auto ok=test_Struct_errors(); !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <thread>
+
+#include "../diff.h"
+#include "../layered_group.h"
+#include "../sweep.h"
+
+using namespace knb;
+
+bool test_Expression()
+{
+    detail::Expression<std::int64_t> e("size / (ways * line) - 1");
+    assert(e.inputs() == std::vector<std::string>({"size", "ways", "line"}));
+    [[maybe_unused]] const std::int64_t in[] = {32768, 8, 64};
+    assert(e.eval(in) == 63);
+
+    detail::Expression<std::int64_t> units("64KiB / cache:line-size + -2 * (3 % 2)");
+    assert(units.inputs() == std::vector<std::string>({"cache:line-size"}));
+    [[maybe_unused]] const std::int64_t line[] = {64};
+    assert(units.eval(line) == 1022);
+
+    detail::Expression<double> d("1e-3 * rate");
+    [[maybe_unused]] const double rate[] = {2000.0};
+    assert(d.eval(rate) == 2.0);
+
+    const std::int64_t zero[] = {0};
+    [[maybe_unused]] bool threw = false;
+    try { detail::Expression<std::int64_t>("1 / x").eval(zero); } catch (const std::domain_error&) { threw = true; }
+    assert(threw);
+
+    for (const char* bad : {"", "a +", "(a", "a b", "2 * )", "1x"}) {
+        threw = false;
+        try { detail::Expression<std::int64_t> x(bad); } catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+    }
+
+    return true;
+}
+
+bool test_Derived_lazy()
+{
+    Group g("sim", false);
+    g.getGroup("cache").addKnob("size", 32768).addKnob("ways", 8).addKnob("line", 64);
+    g.getGroup("cache").addDerived<int>("sets", "size / (ways * line)", "number of sets");
+
+    int calls = 0;
+    g.addDerived("label", {"cache:sets", "cache:ways"}, [&](const DerivedInputs& in) {
+        ++calls;
+        return std::to_string(in[0].asInt()) + "x" + std::to_string(in.number<int>(1));
+    });
+    assert(g.isDerived("label") and g.isDerived("cache:sets") and not g.isDerived("cache:size"));
+    assert(g.derivedInputs("cache:sets") == std::vector<std::string>({"cache:size", "cache:ways", "cache:line"}));
+
+    // computed on first read, then kept
+    assert(calls == 0);
+    assert(g.at("label").asString() == "64x8" and calls == 1);
+    assert(g.atPath("cache:sets").asInt() == 64 and g.gr("cache").at("sets").desc() == "number of sets");
+    assert(g.lookup("label").knob->asString() == "64x8" and calls == 1);
+
+    // change of an input recomputes only what reads it
+    g.changeValue(&g.atPath("cache:ways"), "4");
+    assert(g.atPath("cache:sets").asInt() == 128 and calls == 1);
+    assert(std::get<2>(g.findKnob("label"))->asString() == "128x4" and calls == 2);
+    g.changeValue(&g.atPath("cache:line"), "64");
+    assert(g.at("label").asString() == "128x4" and calls == 3);
+
+    // visit and serializers see computed values
+    g.changeValue(&g.atPath("cache:size"), "64KiB");
+    int sets = 0;
+    g.visit([&](const Knob& k) { if (k.name() == "sets") sets = k.asInt(); });
+    assert(sets == 256);
+    g.changeValue(&g.atPath("cache:size"), "128KiB");
+    g.evaluate();
+    assert(g.gr("cache").find("sets")->asInt() == 512);
+
+    // assigning a derived knob makes it ordinary
+    g.changeValue(&g.atPath("cache:sets"), "7");
+    assert(not g.isDerived("cache:sets") and g.atPath("cache:sets").asInt() == 7);
+    assert(g.at("label").asString() == "7x4");
+    g.changeValue(&g.atPath("cache:size"), "1");
+    assert(g.atPath("cache:sets").asInt() == 7);
+
+    // vector and double results
+    g.addKnob("base", 2.0);
+    g.addDerived("steps", {"base"}, [](const DerivedInputs& in) {
+        return std::vector<double>{in[0].asDouble(), in[0].asDouble() * 2};
+    });
+    g.addDerived<double>("half", "base / 4");
+    assert(g.at("steps").asDoubleArray().size() == 2 and g.at("steps").asDoubleArray()[1] == 4.0);
+    assert(g.at("half").asDouble() == 0.5);
+
+    // copies compute their own values
+    Group copy(g);
+    copy.changeValue(&copy.at("base"), "8");
+    assert(copy.at("half").asDouble() == 2.0 and g.at("half").asDouble() == 0.5);
+    Group moved(std::move(copy));
+    assert(moved.at("half").asDouble() == 2.0 and moved.isDerived("half"));
+    moved.changeValue(&moved.at("base"), "4");
+    assert(moved.at("half").asDouble() == 1.0);
+
+    return true;
+}
+
+bool test_Derived_finalize()
+{
+    Group missing("sim", false);
+    missing.addKnob("a", 1).addDerived<int>("b", "a + nope");
+    [[maybe_unused]] bool threw = false;
+    try { missing.finalize(); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    Group cycle("sim", false);
+    cycle.addKnob("a", 1).addDerived<int>("b", "a + d").addDerived<int>("c", "b * 2").addDerived<int>("d", "c - 1");
+    threw = false;
+    try { cycle.finalize(); } catch (const std::invalid_argument& e) {
+        threw = std::string(e.what()).find("b -> d -> c -> b") != std::string::npos;
+    }
+    assert(threw);
+    threw = false;
+    try { cycle.at("c"); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    Group ok("sim", false);
+    ok.addKnob("a", 3).addDerived<int>("b", "a * 2").addDerived<int>("c", "b + a");
+    ok.finalize();
+    assert(ok.at("c").asInt() == 9);
+
+    // live inputs are refused, a finalized derived value never changes
+    Group live("sim", false);
+    live.addLiveKnob("rate", 2.0f).addDerived<float>("period", "1 / rate");
+    threw = false;
+    try { live.finalize(); } catch (const std::invalid_argument& e) {
+        threw = std::string(e.what()).find("'rate' of derived knob 'period' is live") != std::string::npos;
+    }
+    assert(threw);
+    Group later("sim", false);
+    later.addKnob("rate", 2.0f).addDerived<float>("period", "1 / rate");
+    assert(later.at("period").asFloat() == 0.5f);
+    later.addLiveKnob("rate", 4.0f); // existing knob becomes live
+    threw = false;
+    try { later.at("period"); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    return true;
+}
+
+bool test_Derived_fingerprint()
+{
+    Group a("sim", false), b("sim", false);
+    a.addKnob("x", 2).addDerived<int>("y", "x * 2");
+    b.addKnob("x", 2).addDerived<int>("y", "x * 3");
+    assert(a.fingerprint() != b.fingerprint());
+    assert(diff(a, b) == std::vector<std::string>({"y"}));
+
+    // derived value does not count, its inputs do
+    [[maybe_unused]] const Fingerprint before = a.fingerprint();
+    assert(a.at("y").asInt() == 4 and a.fingerprint() == before);
+    assert(Group(a).fingerprint() == before);
+    b.addDerived<int>("y", "x * 2");
+    b.changeValue(&b.at("x"), "5");
+    assert(b.at("y").asInt() == 10);
+    assert(diff(a, b) == std::vector<std::string>({"x"}));
+
+    a.changeValue(&a.at("y"), "4");
+    assert(a.fingerprint() != before and Group(a).fingerprint() == a.fingerprint());
+
+    return true;
+}
+
+bool test_Derived_layers()
+{
+    Group defaults("defaults"), site("site", false);
+    defaults.getGroup("cache").addKnob("size", 32768).addKnob("ways", 8);
+    defaults.getGroup("cache").addDerived<int>("way-size", "size / ways");
+    site.getGroup("cache").addKnob("ways", 4);
+
+    LayeredGroup config("config");
+    config.push(defaults).push(site);
+    assert(config.at("cache:way-size").asInt() == 8192);
+    assert(defaults.atPath("cache:way-size").asInt() == 4096);
+
+    [[maybe_unused]] const Knob* first = config.find("cache:way-size");
+    assert(config.find("cache:way-size") == first);
+    const Knob copy = config.value("cache:way-size");
+    site.changeValue(&site.atPath("cache:ways"), "2");
+    assert(config.at("cache:way-size").asInt() == 16384);
+    // kept knob is computed again in place, a copy is not
+    assert(first->asInt() == 16384 and copy.asInt() == 8192);
+    assert(config.value("cache:ways").asInt() == 2);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]{
+            for (int i = 0; i < 100; ++i) assert(config.value("cache:way-size").asInt() == 16384);
+        });
+    }
+    for (auto& t : readers) t.join();
+
+    std::ostringstream audit;
+    config.audit(audit);
+    assert(audit.str().find("cache:way-size = 16384  # defaults") != std::string::npos);
+
+    Group flat = config.flatten();
+    assert(flat.isDerived("cache:way-size") and flat.atPath("cache:way-size").asInt() == 16384);
+
+    return true;
+}
+
+bool test_Derived_sweep()
+{
+    Group base("sim");
+    base.getGroup("cache").addKnob("size", 32768).addKnob("ways", 8);
+    base.getGroup("cache").addDerived<int>("way-size", "size / ways");
+    base.finalize();
+
+    Sweep sweep(base);
+    sweep.values("cache:ways", std::vector<int>{1, 2, 4});
+    [[maybe_unused]] bool threw = false;
+    try { sweep.values("cache:way-size", std::vector<int>{1}); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    SweepPoint p(sweep);
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        sweep.point(i, p);
+        [[maybe_unused]] const int ways = p.at("cache:ways").asInt();
+        assert(p.at("cache:way-size").asInt() == 32768 / ways);
+        assert(p.group().atPath("cache:way-size").asInt() == 32768 / ways);
+    }
+    assert(base.atPath("cache:way-size").asInt() == 4096);
+
+    // concurrent first reads compute once
+    Group g("sim", false);
+    g.addKnob("a", 6);
+    std::atomic<int> calls{0};
+    g.addDerived("b", {"a"}, [&](const DerivedInputs& in) { ++calls; return in[0].asInt() * 7; });
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) threads.emplace_back([&]{ assert(g.at("b").asInt() == 42); });
+    for (auto& t : threads) t.join();
+    assert(calls == 1);
+
+    return true;
+}
+
+bool test_Derived_lock()
+{
+    // each tree has its own lock, evaluation of one reads the other
+    Group base("base", false);
+    base.addKnob("size", 64).addDerived<int>("half", "size / 2");
+    Group top("top", false);
+    top.addKnob("ways", 4).addDerived("sets", {"ways"}, [&](const DerivedInputs& in) {
+        return base.at("half").asInt() / in[0].asInt();
+    });
+    assert(top.at("sets").asInt() == 8);
+
+    // reading another derived knob of the same tree does not deadlock
+    top.addDerived("twice", {"ways"}, [&](const DerivedInputs&) {
+        return top.at("sets").asInt() * 2;
+    });
+    assert(top.at("twice").asInt() == 16);
+
+    // a copy is a new tree with its own lock
+    Group copy(top);
+    assert(copy.at("ways").asInt() == 4 and copy.at("sets").asInt() == 8);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Expression(); !ok) return 1;
+    if (auto ok=test_Derived_lazy(); !ok) return 1;
+    if (auto ok=test_Derived_finalize(); !ok) return 1;
+    if (auto ok=test_Derived_fingerprint(); !ok) return 1;
+    if (auto ok=test_Derived_layers(); !ok) return 1;
+    if (auto ok=test_Derived_sweep(); !ok) return 1;
+    if (auto ok=test_Derived_lock(); !ok) return 1;
+
+    return 0;
+}
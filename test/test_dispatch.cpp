@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cassert>
+
+#include "../dispatch.h"
+
+using namespace knb;
+
+static constexpr char lru[] = "lru", fifo[] = "fifo";
+
+template <int Ways, bool Prefetch>
+int kernel() { return Ways * 10 + Prefetch; }
+
+bool test_Dispatch_one()
+{
+    Group knobs("root");
+    knobs.addKnob("ways", 4).addKnob("prefetch", true).addKnob("policy", "fifo");
+
+    [[maybe_unused]] int r = dispatch<1,2,4,8>(knobs.at("ways"), [](auto ways) {
+        static_assert(std::is_same_v<decltype(ways()), int>);
+        return kernel<ways, false>();
+    });
+    assert(r == 40);
+
+    r = dispatch<false,true>(knobs.at("prefetch"), [](auto on) { return on()? 1 : 0; });
+    assert(r == 1);
+
+    std::string chosen;
+    dispatch<lru,fifo>(knobs.at("policy"), [&](auto policy) {
+        if constexpr (policy() == fifo) chosen = "FIFO"; else chosen = "LRU";
+    });
+    assert(chosen == "FIFO");
+
+    try {
+        dispatch<1,2,8>(knobs.at("ways"), [](auto) {});
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        assert(std::string(e.what()).find("'ways' value 4 (type id 1) is not one of {1, 2, 8}")
+               != std::string::npos);
+    }
+    try {
+        dispatch<lru>(knobs.at("ways"), [](auto) {});
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        assert(std::string(e.what()).find("{\"lru\"}") != std::string::npos);
+    }
+
+    return true;
+}
+
+bool test_Dispatch_many()
+{
+    Group knobs("root");
+    knobs.addKnob("ways", 8).addKnob("prefetch", true).addKnob("policy", "lru");
+    const Knob& ways = knobs.at("ways");
+    const Knob& prefetch = knobs.at("prefetch");
+    const Knob& policy = knobs.at("policy");
+
+    [[maybe_unused]] int r = dispatch<Choices<1,2,4,8>, Choices<false,true>>(std::tie(ways, prefetch),
+        [](auto w, auto p) { return kernel<w, p>(); });
+    assert(r == 81);
+
+    r = dispatch<Choices<2,8>, Choices<true>, Choices<lru,fifo>>(std::tie(ways, prefetch, policy),
+        [](auto w, auto p, auto pol) { return kernel<w, p>() + (pol() == lru? 100 : 0); });
+    assert(r == 181);
+
+    try {
+        dispatch<Choices<8>, Choices<false>>(std::tie(ways, prefetch), [](auto, auto) {});
+        assert(false);
+    } catch (const std::invalid_argument& e) {
+        assert(std::string(e.what()).find("'prefetch'") != std::string::npos);
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Dispatch_one();  !ok) return 1;
+    if (auto ok=test_Dispatch_many(); !ok) return 1;
+
+    return 0;
+}
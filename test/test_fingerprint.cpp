@@ -0,0 +1,165 @@
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#include "../diff.h"
+#include "../result_cache.h"
+#include "../sweep.h"
+
+using namespace knb;
+
+static void build(Group& g, int ways)
+{
+    g.addKnob("ways", ways).addKnob("name", "run").addKnob("ratio", 0.5f);
+    g.getGroup("cache").addKnob("size", 32768).addKnob("lat", std::vector<std::int64_t>{4, 12});
+    g.getGroup("cache").getGroup("l2").addKnob("size", 1 << 20);
+}
+
+bool test_Fingerprint_incremental()
+{
+    Group a("sim", false), b("other-name", false);
+    build(a, 8);
+    // other order, other root name
+    b.getGroup("cache").getGroup("l2").addKnob("size", 1 << 20);
+    b.getGroup("cache").addKnob("lat", std::vector<std::int64_t>{4, 12}).addKnob("size", 32768);
+    b.addKnob("ratio", 0.5f).addKnob("name", "run").addKnob("ways", 8);
+    assert(a.fingerprint() == b.fingerprint());
+    assert(a.fingerprint().hex().size() == 32 and a.fingerprint().hex() != std::string(32, '0'));
+
+    // both lanes are computed byte by byte, paths are hashed piece by piece
+    [[maybe_unused]] const Fingerprint whole = detail::HashState().add("cache:size").finish();
+    assert(detail::HashState().add("cache:").add("size").finish() == whole);
+    assert(whole.lo == detail::mix(detail::hashMx("cache:size")));
+
+    [[maybe_unused]] const Fingerprint before = a.fingerprint();
+    if (not a.changeValue(&a.at("ways"), "16")) return false;
+    assert(a.fingerprint() != before);
+    assert(Group(a).fingerprint() == a.fingerprint()); // full recompute agrees
+    if (not a.changeValue(&a.at("ways"), "8")) return false;
+    assert(a.fingerprint() == before);
+
+    // path, type and value all count
+    Group c("sim", false);
+    build(c, 8);
+    c.getGroup("cache").addKnob(Knob("size", 65536));
+    assert(c.fingerprint() != before and Group(c).fingerprint() == c.fingerprint());
+    Group d("sim", false);
+    build(d, 8);
+    d.changeValue(&d.atPath("cache:l2:size"), "32768");
+    d.changeValue(&d.atPath("cache:size"), "1048576");
+    assert(d.fingerprint() != before);
+    Group e("sim"), f("sim");
+    e.addKnob("x", 1); f.addKnob("x", 1.0f);
+    assert(e.fingerprint() != f.fingerprint());
+    Group g("sim"), h("sim");
+    g.getGroup("a").addKnob("bc", 1); h.getGroup("ab").addKnob("c", 1);
+    assert(g.fingerprint() != h.fingerprint());
+    assert(Group("x").fingerprint() == Group("y").fingerprint());
+
+    // subgroup fingerprint covers its sub-tree, string and live knobs too
+    [[maybe_unused]] const Fingerprint cache = a.gr("cache").fingerprint();
+    if (not a.changeValue(&a.at("name"), "other")) return false;
+    assert(a.gr("cache").fingerprint() == cache);
+    if (not a.changeValue(&a.atPath("cache:l2:size"), "2MiB")) return false;
+    assert(a.gr("cache").fingerprint() != cache);
+    a.addLiveKnob("rate", 1.0f);
+    [[maybe_unused]] const Fingerprint live = a.fingerprint();
+    a.setLive("rate", 2.0f);
+    assert(a.fingerprint() != live and Group(a).fingerprint() == a.fingerprint());
+
+    // moved tree keeps it
+    [[maybe_unused]] const Fingerprint moved = a.fingerprint();
+    Group m(std::move(a));
+    assert(m.fingerprint() == moved);
+
+    return true;
+}
+
+bool test_Fingerprint_diff()
+{
+    Group a("sim", false), b("sim", false);
+    build(a, 8); build(b, 8);
+    assert(diff(a, b).empty());
+
+    b.changeValue(&b.at("ways"), "4");
+    b.changeValue(&b.atPath("cache:l2:size"), "1");
+    b.getGroup("tlb").addKnob("entries", 64);
+    a.addKnob("only-in-a", true);
+    b.getGroup("cache").addKnob(Knob("lat", 3));
+    const std::vector<std::string> expect{"only-in-a", "ways", "cache:lat", "cache:l2:size", "tlb:entries"};
+    assert(diff(a, b) == expect);
+    assert(diff(b, a) == expect);
+    assert(diff(a.gr("cache"), b.gr("cache")) == std::vector<std::string>({"lat", "l2:size"}));
+
+    return true;
+}
+
+bool test_Fingerprint_sweep_cache()
+{
+    Group base("sim");
+    build(base, 8);
+    Sweep sweep(base);
+    sweep.range("ways", 1, 4, 1).values("name", {"a", "b"});
+
+    std::set<Fingerprint> seen;
+    SweepPoint p(sweep);
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        sweep.point(i, p);
+        assert(p.fingerprint() == p.group().fingerprint());
+        seen.insert(p.fingerprint());
+    }
+    assert(seen.size() == sweep.size());
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "knobcpp_test_result_cache";
+    std::filesystem::remove_all(dir);
+    ResultCache cache(dir.string());
+    std::atomic<int> executed{0};
+    auto run = [&](const SweepPoint& pt) {
+        const Fingerprint fp = pt.fingerprint();
+        if (cache.find(fp)) return;
+        ++executed;
+        const std::string staged = cache.stage(fp);
+        std::ofstream(std::filesystem::path(staged) / "result") << pt.at("ways").asInt();
+        const Group g = pt.group();
+        [[maybe_unused]] const bool committed = cache.commit(fp, staged, &g);
+        assert(committed);
+    };
+    sweep.run(run, 1);
+    assert(executed == 8);
+    sweep.run(run, 2);
+    assert(executed == 8); // all cached
+
+    // points with the base cache size are the old ones
+    sweep.range("cache:size", 32768, 65536, 32768);
+    sweep.run(run, 2);
+    assert(executed == 16);
+    sweep.point(0, p);
+    const auto entry = cache.find(p.fingerprint());
+    if (not entry) return false;
+    assert(std::filesystem::exists(*entry + "/config.txt"));
+    int ways = 0;
+    std::ifstream(*entry + "/result") >> ways;
+    assert(ways == p.at("ways").asInt());
+
+    // second commit of the same point loses, staged files are removed
+    const std::string staged = cache.stage(p.fingerprint());
+    std::ofstream(std::filesystem::path(staged) / "result") << -1;
+    if (cache.commit(p.fingerprint(), staged)) return false;
+    assert(not std::filesystem::exists(staged));
+    if (not cache.erase(p.fingerprint())) return false;
+    assert(not cache.find(p.fingerprint()));
+
+    std::filesystem::remove_all(dir);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Fingerprint_incremental(); !ok) return 1;
+    if (auto ok=test_Fingerprint_diff(); !ok) return 1;
+    if (auto ok=test_Fingerprint_sweep_cache(); !ok) return 1;
+
+    return 0;
+}
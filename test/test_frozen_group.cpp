@@ -0,0 +1,105 @@
+#include <iostream>
+#include <cassert>
+
+#include "../frozen_group.h"
+
+using namespace knb;
+
+bool test_FrozenGroup_lookup()
+{
+    Group knobs("root");
+    knobs.addKnob("version","1.2.3", "Program version")
+         .addKnob("max", 100)
+         .addKnob("feature-A", true)
+    ;
+    knobs.getGroup("feature-A")
+        .addKnob("A-val1", 345)
+        .getGroup("A-X")
+            .addKnob("A-X-val2", 987)
+            .addKnob("ratio", 0.5f)
+    ;
+    knobs.getGroup("feature-B")
+        .addKnob("A-val1", 1)
+    ;
+    knobs.finalize();
+
+    FrozenGroup frozen(knobs);
+    assert(frozen.size() == 7);
+
+    assert(frozen.asString(frozen.at("version")) == "1.2.3");
+    assert(frozen.desc(frozen.at("version")) == "Program version");
+    assert(frozen.asInt(frozen.at("max")) == 100);
+    assert(frozen.asBool(frozen.at("feature-A")) == true);
+    assert(frozen.asFloat(frozen.at("ratio")) == 0.5f);
+
+    // leaf name resolves to the same knob as Group::findKnob
+    [[maybe_unused]] auto [ok, path, id] = frozen.findKnob("A-X-val2");
+    assert(ok and path == "root:feature-A:A-X:A-X-val2");
+    assert(frozen.asInt(id) == 987);
+    assert(frozen.name(id) == "A-X-val2");
+    assert(frozen.at("feature-A:A-X:A-X-val2") == id);
+
+    auto [gok, gpath, gknob] = knobs.findKnob("A-val1");
+    assert(gok and frozen.path(frozen.at("A-val1")) == gpath);
+    assert(frozen.asInt(frozen.at("A-val1")) == gknob->asInt());
+    assert(frozen.asInt(frozen.at("feature-B:A-val1")) == 1);
+
+    assert(frozen.find("unknown") == FrozenGroup::npos);
+    assert(frozen.find("feature-C:A-val1") == FrozenGroup::npos);
+    try { frozen.at("unknown"); assert(false); } catch (const std::out_of_range&) {}
+    try { frozen.asInt(frozen.at("version")); assert(false); }
+    catch (const std::bad_variant_access&) {}
+
+    [[maybe_unused]] KnobHandle<int> h = frozen.bind<int>("feature-A:A-X:A-X-val2");
+    assert(h.get() == 987);
+    assert(frozen.bind<std::string>("version").get() == "1.2.3");
+    assert(*frozen.bind<float>("ratio") == 0.5f);
+    try { frozen.bind<bool>("max"); assert(false); }
+    catch (const std::invalid_argument&) {}
+
+    Knob k = frozen.knob(frozen.at("version"));
+    assert(k.name() == "version" and k.asString() == "1.2.3");
+
+    return true;
+}
+
+bool test_FrozenGroup_large()
+{
+    Group knobs("root");
+    for (int g = 0; g < 100; ++g) {
+        Group& gr = knobs.getGroup("g" + std::to_string(g));
+        for (int k = 0; k < 100; ++k) {
+            gr.addKnob("k" + std::to_string(g) + "_" + std::to_string(k), g * 1000 + k);
+        }
+    }
+
+    FrozenGroup frozen(knobs);
+    assert(frozen.size() == 100 * 100);
+    for (int g = 0; g < 100; ++g) {
+        for (int k = 0; k < 100; ++k) {
+            std::string nm = "k" + std::to_string(g) + "_" + std::to_string(k);
+            assert(frozen.asInt(frozen.at(nm)) == g * 1000 + k);
+            assert(frozen.at("g" + std::to_string(g) + ":" + nm) == frozen.at(nm));
+        }
+    }
+
+    return true;
+}
+
+bool test_FrozenGroup_empty()
+{
+    FrozenGroup frozen(Group("empty"));
+    assert(frozen.size() == 0);
+    assert(frozen.find("x") == FrozenGroup::npos);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_FrozenGroup_lookup(); !ok) return 1;
+    if (auto ok=test_FrozenGroup_large();  !ok) return 1;
+    if (auto ok=test_FrozenGroup_empty();  !ok) return 1;
+
+    return 0;
+}
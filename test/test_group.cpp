@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cassert>
+#include <thread>
 #include <type_traits>
 
 #include "../knob.h"
@@ -26,6 +27,25 @@ bool test_Knob_array()
                   << "=" << k.asString() << std::endl;
         assert(k.asInt() == 123);
     }
+    assert(not std::get<0>(ar.findKnob("k2")));
+
+    // lookup returns the knob in the array, not a copy
+    assert(ar.find("k7") == &ar.at(1) and ar.indexOf("k3") == 2);
+    assert(&std::get<1>(ar.findKnob("k3")) == &ar.at(2));
+
+    // several SIMD blocks and a tail, first match wins
+    for (int i = 0; i < 37; ++i) ar.addKnob("knob-" + std::to_string(i), i);
+    assert(ar.addKnob(knb::Knob("knob-5", 500)) == 40 and ar.size() == 41);
+    for (int i = 0; i < 37; ++i) {
+        assert(ar.indexOf("knob-" + std::to_string(i)) == static_cast<std::size_t>(i) + 3);
+        assert(ar.find("knob-" + std::to_string(i))->asInt() == i);
+    }
+    assert(ar.indexOf("knob-37") == knb::Array::npos and ar.find("") == nullptr);
+    assert(ar.indexOf("a-long-name-of-knob-0") == knb::Array::npos);
+
+    knb::Knob big("big", std::string(100, 'x'));
+    ar.addKnob(std::move(big));
+    assert(ar.find("big")->asString().size() == 100);
 
     return true;
 }
@@ -58,11 +78,256 @@ bool test_Knob_group()
     return true;
 }
 
+bool test_Knob_handle()
+{
+    Group knobs("root", false);
+    knobs.addKnob("max", 100)
+         .addKnob("version", "1.2.3");
+    knobs.getGroup("feature-A")
+        .addKnob("A-val1", 345)
+        .getGroup("A-X")
+            .addKnob("enabled", true)
+    ;
+
+    [[maybe_unused]] KnobHandle<int> h = knobs.bind<int>("feature-A:A-val1");
+    assert(h and h.get() == 345);
+    assert(*knobs.bind<int>("max") == 100);
+    assert(knobs.bind<bool>("feature-A:A-X:enabled").get() == true);
+    assert(knobs.bind<std::string>("version")->size() == 5);
+
+    // handle follows value changes
+    knobs.changeValue(&knobs.atPath("feature-A:A-val1"), "543");
+    assert(h.get() == 543);
+
+    try { knobs.bind<float>("max"); assert(false); }
+    catch (const std::invalid_argument&) {}
+    try { knobs.bind<int>("feature-A:nope"); assert(false); }
+    catch (const std::out_of_range&) {}
+    try { knobs.bind<int>("nope:A-val1"); assert(false); }
+    catch (const std::out_of_range&) {}
+
+    return true;
+}
+bool test_Knob_lookup()
+{
+    Group knobs("root");
+    knobs.getGroup("b").addKnob("dup", 2).addKnob("b-only", 20);
+    knobs.getGroup("a").getGroup("x").addKnob("dup", 1);
+    knobs.getGroup("a").addKnob("a-only", 10);
+
+    [[maybe_unused]] auto ref = knobs.lookup("b-only");
+    assert(ref and not ref.ambiguous() and ref.knob->asInt() == 20);
+    assert(knobs.path(ref) == "root:b:b-only");
+
+    // "a:x" is visited before "b", like old depth-first findKnob
+    [[maybe_unused]] auto dup = knobs.lookup("dup");
+    assert(dup and dup.ambiguous() and dup.matches == 2);
+    assert(dup.knob->asInt() == 1);
+    assert(knobs.path(dup) == "root:a:x:dup");
+
+    // own knob is visited before knobs of subgroups
+    knobs.getGroup("b").getGroup("c").addKnob("b-only", 30);
+    assert(knobs.lookup("b-only").knob->asInt() == 20);
+    knobs.addKnob("dup", 0);
+    assert(knobs.lookup("dup").knob->asInt() == 0);
+    assert(knobs.lookup("dup").matches == 3);
+
+    // every level has its own index
+    [[maybe_unused]] const Group& b = knobs.gr("b");
+    assert(b.lookup("dup").knob->asInt() == 2 and not b.lookup("dup").ambiguous());
+    assert(b.path(b.lookup("dup")) == "b:dup");
+    assert(not b.lookup("a-only"));
+
+    // copy has its own index pointing to its own knobs
+    Group copy = knobs;
+    [[maybe_unused]] auto cref = copy.lookup("a-only");
+    assert(cref and cref.knob != knobs.lookup("a-only").knob);
+    assert(copy.path(cref) == "root:a:a-only");
+    copy.getGroup("a").addKnob("new-one", 5);
+    assert(copy.lookup("new-one") and not knobs.lookup("new-one"));
+
+    Group moved = std::move(copy);
+    assert(moved.lookup("new-one").knob->asInt() == 5);
+    moved.getGroup("z").addKnob("zz", 7);
+    assert(moved.lookup("zz").owner == &moved.gr("z"));
+
+    return true;
+}
+bool test_Group_arena()
+{
+    std::vector<std::byte> buffer(1 << 20);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(),
+                                              std::pmr::null_memory_resource());
+    // nothing may come from the default resource
+    auto* old = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        Group knobs("root", &arena, false);
+        knobs.addKnob("max", 100, "max value");
+        knobs.getGroup("feature-A")
+            .addKnob("A-val1", 345)
+            .getGroup("A-X")
+                .addKnob("A-X-val2", 987)
+        ;
+        assert(knobs.gr("feature-A").get_allocator().resource() == &arena);
+        assert(knobs.gr("feature-A").gr("A-X").get_allocator().resource() == &arena);
+        assert(knobs.lookup("A-X-val2").knob->asInt() == 987);
+
+        Group copy(std::allocator_arg, &arena, knobs);
+        assert(copy.gr("feature-A").get_allocator().resource() == &arena);
+        assert(copy.lookup("A-val1").knob->asInt() == 345);
+
+        Array ar("array", &arena);
+        ar.addKnob("k1", 1);
+        assert(ar.at(0).asInt() == 1);
+    }
+    std::pmr::set_default_resource(old);
+
+    // copy of arena tree goes to the default resource
+    std::pmr::monotonic_buffer_resource arena2;
+    Group knobs("root", &arena2);
+    knobs.getGroup("g").addKnob("k", 1);
+    Group copy = knobs;
+    assert(copy.gr("g").get_allocator().resource() == std::pmr::get_default_resource());
+    knobs = copy;
+    assert(knobs.gr("g").get_allocator().resource() == &arena2);
+    assert(knobs.lookup("k").owner == &knobs.gr("g"));
+
+    return true;
+}
+
+bool test_Group_live()
+{
+    Group knobs("root", false);
+    knobs.addLiveKnob("verbosity", 1, "log verbosity")
+         .addKnob("max", 100);
+    knobs.getGroup("sampler").addLiveKnob("rate", 0.5f).addLiveKnob("on", false);
+
+    [[maybe_unused]] LiveKnob<int> verbosity = knobs.live<int>("verbosity");
+    [[maybe_unused]] LiveKnob<float> rate = knobs.live<float>("sampler:rate");
+    assert(verbosity.get() == 1 and *rate == 0.5f);
+    assert(knobs.at("verbosity").desc() == "log verbosity");
+
+    [[maybe_unused]] bool thrown = false;
+    try { knobs.live<int>("max"); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown); thrown = false;
+    try { knobs.live<float>("verbosity"); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown); thrown = false;
+    try { knobs.addLiveKnob("max", 5); knobs.addKnob("s", "str"); knobs.addLiveKnob("s", 1); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+    assert(knobs.live<int>("max").get() == 100);
+
+    // live knobs change after finalize, others do not
+    knobs.finalize();
+    std::vector<float> seen;
+    const std::size_t id = knobs.subscribe("sampler:rate",
+        [&](const Knob& k){ seen.push_back(k.asFloat()); });
+    knobs.setLive("sampler:rate", 0.25f);
+    assert(*rate == 0.25f and knobs.atPath("sampler:rate").asFloat() == 0.25f);
+    knobs.changeValue(&knobs.atPath("sampler:rate"), "0.75");
+    assert(*rate == 0.75f);
+    knobs.changeValue(&knobs.at("verbosity"), "3");
+    assert(*verbosity == 3);
+    knobs.changeValue(&knobs.at("s"), "other");
+    assert(knobs.at("s").asString() == "str");
+    assert((seen == std::vector<float>{0.25f, 0.75f}));
+
+    knobs.unsubscribe("sampler:rate", id);
+    knobs.setLive("sampler:rate", 1.0f);
+    assert(seen.size() == 2 and *rate == 1.0f);
+
+    // replaced live knob stays live, readers and subscribers see the new value
+    std::vector<int> levels;
+    const std::size_t vid = knobs.subscribe("verbosity", [&](const Knob& k){ levels.push_back(k.asInt()); });
+    knobs.addKnob(Knob("verbosity", 5, "more logs"));
+    assert(*verbosity == 5 and knobs.at("verbosity").asInt() == 5 and knobs.at("verbosity").desc() == "more logs");
+    assert(levels == std::vector<int>{5});
+    thrown = false;
+    try { knobs.addKnob(Knob("verbosity", 1.0f)); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown and *verbosity == 5);
+    knobs.unsubscribe("verbosity", vid);
+
+    // changes from several threads are serialized
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&knobs, t]{
+            for (int i = 0; i < 1000; ++i) knobs.setLive("verbosity", t * 1000 + i);
+        });
+    }
+    for (auto& w : writers) w.join();
+    assert(*verbosity % 1000 == 999 and knobs.at("verbosity").asInt() == *verbosity);
+    assert(Group(knobs).fingerprint() == knobs.fingerprint());
+
+    // copy has own live values
+    Group copy = knobs;
+    copy.setLive("sampler:on", true);
+    assert(copy.live<bool>("sampler:on").get() and not knobs.live<bool>("sampler:on").get());
+
+    static_assert(alignof(detail::LiveCell) == 64, "live value on own cache line");
+    return true;
+}
+
+bool test_Group_traversal()
+{
+    Group knobs("root");
+    knobs.addKnob("b", 2).addKnob("a", 1);
+    knobs.getGroup("g2").addKnob("x", 5);
+    knobs.getGroup("g1").getGroup("empty");
+    knobs.getGroup("g1").getGroup("h").addKnob("y", 4);
+    knobs.getGroup("g1").addKnob("z", 3);
+    knobs.getGroup("g3");
+
+    std::vector<std::string> visited;
+    assert(knobs.visit([&](const Knob& k){ visited.push_back(std::string(k.name())); }));
+    const std::vector<std::string> order{"a", "b", "z", "y", "x"};
+    assert(visited == order);
+
+    // iterator gives the same order and path of every knob
+    std::vector<std::string> iterated, paths;
+    std::string path;
+    for (auto it = knobs.tree().begin(); it != knobs.tree().end(); ++it) {
+        iterated.push_back(std::string(it->name()));
+        path.clear(); it.appendPath(path);
+        paths.push_back(path);
+    }
+    assert(iterated == order);
+    assert((paths == std::vector<std::string>{"a", "b", "g1:z", "g1:h:y", "g2:x"}));
+    for ([[maybe_unused]] const Knob& k : knobs.tree()) { assert(not k.name().empty()); }
+    auto it = knobs.gr("g1").tree().begin();
+    assert(it->name() == "z" and it.depth() == 0 and &it.owner() == &knobs.gr("g1"));
+    ++it;
+    assert(it->name() == "y" and it.depth() == 1 and it.owner().parent() == &knobs.gr("g1"));
+    assert(++it == knobs.gr("g1").tree().end());
+    assert(knobs.gr("g3").tree().empty());
+
+    // early stop, owner
+    [[maybe_unused]] int count = 0;
+    assert(not knobs.visit([&](const Knob& k){ ++count; return k.name() != "z"; }));
+    assert(count == 3);
+    std::vector<std::string> owners;
+    knobs.visit([&](const Knob&, const Group& g){ owners.push_back(std::string(g.name())); });
+    assert((owners == std::vector<std::string>{"root", "root", "g1", "h", "g2"}));
+
+    // flat ranges
+    std::vector<std::string> own, subs;
+    for (const Knob& k : knobs.knobs()) own.push_back(std::string(k.name()));
+    for (const Group& g : knobs.groups()) subs.push_back(std::string(g.name()));
+    assert((own == std::vector<std::string>{"a", "b"}));
+    assert((subs == std::vector<std::string>{"g1", "g2", "g3"}));
+    assert(std::distance(knobs.tree().begin(), knobs.tree().end()) == 5);
+
+    return true;
+}
 
 int main(int argc, char* argv[])
 {
     if (auto ok=test_Knob_array();   !ok) return 1;
     if (auto ok=test_Knob_group();   !ok) return 1;
+    if (auto ok=test_Knob_handle();  !ok) return 1;
+    if (auto ok=test_Knob_lookup();  !ok) return 1;
+    if (auto ok=test_Group_arena();  !ok) return 1;
+    if (auto ok=test_Group_live();   !ok) return 1;
+    if (auto ok=test_Group_traversal(); !ok) return 1;
 
     return 0;
 }
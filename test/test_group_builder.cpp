@@ -0,0 +1,129 @@
+#include <iostream>
+#include <cassert>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../group_builder.h"
+
+using namespace knb;
+
+static std::string path(std::size_t i)
+{
+    // least significant group first, so knobs come unsorted
+    return "g" + std::to_string(i % 3) + ":h" + std::to_string(i / 3 % 4);
+}
+
+[[maybe_unused]] static std::vector<std::string> order(const Group& g)
+{
+    std::vector<std::string> names;
+    g.visit([&](const Knob& k, const Group& owner) {
+        names.push_back(std::string(owner.name()) + "." + std::string(k.name()));
+    });
+    return names;
+}
+
+bool test_GroupBuilder_build()
+{
+    Group ref("sim");
+    GroupBuilder b("sim");
+    b.reserve(40);
+    for (std::size_t i = 0; i < 40; ++i) {
+        const std::string nm = "k" + std::to_string(i);
+        ref.getGroup("g" + std::to_string(i % 3)).getGroup("h" + std::to_string(i / 3 % 4))
+           .addKnob(nm, static_cast<int>(i), "some knob");
+        b.add(path(i), nm, static_cast<int>(i), "some knob");
+    }
+    ref.addKnob("top", "root knob").getGroup("g1").addKnob("mid", 0.5);
+    b.add("", "top", "root knob").add("g1", Knob("mid", 0.5));
+    // groups with a common prefix, `a:b` comes before `a-c`
+    ref.getGroup("a").getGroup("b").addKnob("x", 1);
+    ref.getGroup("a-c").addKnob("y", 2);
+    b.add("a-c", "y", 2).add("a:b", "x", 1);
+    assert(b.size() == 44);
+
+    Group g = b.build();
+    assert(b.size() == 0);
+    assert(g.name() == "sim");
+    assert(g.fingerprint() == ref.fingerprint());
+    assert(order(g) == order(ref));
+    assert(g.atPath("g2:h1:k5").asInt() == 5);
+    assert(g.gr("g1").at("mid").asDouble() == 0.5);
+    assert(g.atPath("g0:h1:k39").desc() == "some knob");
+    auto [found, where, k] = g.findKnob("x");
+    assert(found and where == "sim:a:b:x" and k->asInt() == 1);
+    assert(&g.gr("a").gr("b").at("x") == k);
+
+    // built tree is an ordinary one
+    Group copy(g);
+    assert(copy.fingerprint() == g.fingerprint());
+    g.changeValue(&g.atPath("g1:h0:k1"), "7");
+    assert(g.atPath("g1:h0:k1").asInt() == 1); // immutable by default
+
+    Group empty = GroupBuilder("empty").build();
+    assert(empty.name() == "empty" and order(empty).empty());
+
+    // string values are moved into the tree, not copied
+    std::string long1(100, 'a'), long2(100, 'b');
+    [[maybe_unused]] const char* p1 = long1.data();
+    [[maybe_unused]] const char* p2 = long2.data();
+    Group direct("direct");
+    direct.addKnob("s", std::move(long1));
+    assert(direct.bind<std::string>("s")->data() == p1);
+    GroupBuilder sb("moved");
+    sb.add("", "s", std::move(long2));
+    Group built = sb.build();
+    assert(built.bind<std::string>("s")->data() == p2);
+
+    return true;
+}
+
+bool test_GroupBuilder_duplicates()
+{
+    GroupBuilder b("sim", false);
+    b.add("c", "ways", 4).add("c", "policy", "lru").add("c", "ways", 8).add("c:d", "ways", 2);
+    Group g = b.build();
+    assert(g.gr("c").at("ways").asInt() == 8);
+    assert(g.atPath("c:d:ways").asInt() == 2);
+    assert(order(g).size() == 3);
+    [[maybe_unused]] const Fingerprint before = g.fingerprint();
+    assert(g.changeValue(&g.atPath("c:ways"), "16") and g.atPath("c:ways").asInt() == 16);
+    assert(g.fingerprint() != before and Group(g).fingerprint() == g.fingerprint());
+
+    return true;
+}
+
+bool test_GroupBuilder_arena()
+{
+    std::pmr::monotonic_buffer_resource arena;
+    GroupBuilder b("sim", &arena);
+    for (int i = 0; i < 100; ++i) b.add("g" + std::to_string(i % 7), "k" + std::to_string(i), i);
+    Group g = b.build();
+    assert(g.get_allocator().resource() == &arena);
+    assert(g.gr("g3").get_allocator().resource() == &arena);
+    assert(g.atPath("g3:k10").asInt() == 10);
+
+    return true;
+}
+
+bool test_GroupBuilder_frozen()
+{
+    GroupBuilder b("sim");
+    b.add("core:l2", "ways", 8).add("core", "freq", 2.5).add("", "name", "sim-a");
+    FrozenGroup f = b.buildFrozen();
+    assert(f.size() == 3);
+    assert(f.asInt(f.at("core:l2:ways")) == 8);
+    assert(f.path(f.at("freq")) == "sim:core:freq");
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_GroupBuilder_build(); !ok) return 1;
+    if (auto ok=test_GroupBuilder_duplicates(); !ok) return 1;
+    if (auto ok=test_GroupBuilder_arena(); !ok) return 1;
+    if (auto ok=test_GroupBuilder_frozen(); !ok) return 1;
+
+    return 0;
+}
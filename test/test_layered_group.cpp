@@ -0,0 +1,121 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+
+#include "../layered_group.h"
+#include "../frozen_group.h"
+
+using namespace knb;
+
+bool test_Layered_resolve()
+{
+    Group defaults("defaults");
+    defaults.addKnob("max", 100).addKnob("min", 10).addKnob("version", "1.0");
+    defaults.getGroup("cache").addKnob("ways", 4).addKnob("policy", "lru");
+
+    Group site("site");
+    site.getGroup("cache").addKnob("ways", 8);
+    site.addKnob("site-only", true);
+
+    Group argv("argv");
+    argv.addKnob("max", 200);
+    argv.getGroup("cache").getGroup("l2").addKnob("ways", 16);
+
+    LayeredGroup config("config");
+    config.push(defaults).push(site, "site file").push(argv);
+    assert(config.size() == 3);
+
+    assert(config.at("max").asInt() == 200 and config.layerOf("max") == 2);
+    assert(config.at("min").asInt() == 10 and config.layerOf("min") == 0);
+    assert(config.at("cache:ways").asInt() == 8);
+    assert(config.label(config.layerOf("cache:ways")) == "site file");
+    assert(config.label(config.layerOf("max")) == "argv");
+    assert(config.at("cache:l2:ways").asInt() == 16);
+    assert(config.find("nope") == nullptr and config.layerOf("cache:nope") == LayeredGroup::npos);
+    assert(&config.at("min") == &defaults.at("min")); // no copies
+
+    [[maybe_unused]] bool thrown = false;
+    try { config.at("cache:l3:ways"); } catch (const std::out_of_range&) { thrown = true; }
+    assert(thrown);
+
+    auto [ok, path, k] = config.findKnob("ways");
+    // first in visit order, from the topmost layer that has it
+    assert(ok and path == "config:cache:ways" and k->asInt() == 8 and k == &config.at("cache:ways"));
+    std::tie(ok, path, k) = config.findKnob("policy");
+    assert(ok and path == "config:cache:policy");
+
+    // visit order and values are those of the merged tree
+    std::vector<std::string> seen;
+    config.visit([&](const Knob& k){ seen.push_back(std::string(k.name()) + "=" + k.asString()); });
+    const std::vector<std::string> expect{"max=200", "min=10", "site-only=true", "version=1.0",
+        "policy=lru", "ways=8", "ways=16"};
+    assert(seen == expect);
+
+    std::ostringstream audit;
+    config.audit(audit);
+    assert(audit.str().find("max = 200  # argv\n") != std::string::npos);
+    assert(audit.str().find("cache:ways = 8  # site file\n") != std::string::npos);
+    assert(audit.str().find("cache:l2:ways = 16  # argv\n") != std::string::npos);
+    assert(audit.str().find("version = 1.0  # defaults\n") != std::string::npos);
+
+    Group flat = config.flatten();
+    std::vector<std::string> flatSeen;
+    flat.visit([&](const Knob& k){ flatSeen.push_back(std::string(k.name()) + "=" + k.asString()); });
+    assert(flatSeen == expect);
+    assert(flat.name() == "config");
+    FrozenGroup frozen(flat);
+    assert(frozen.asInt(frozen.at("cache:l2:ways")) == 16);
+
+    return true;
+}
+
+bool test_Layered_flatten()
+{
+    Group defaults("defaults");
+    defaults.addKnob("rate", 10).addKnob("depth", 4);
+    defaults.constrain("rate", {1, 100}).constrain("depth", {1, 16});
+    defaults.getGroup("cache").addKnob("ways", 4).addDerived<int>("sets", "ways * 2");
+
+    Group site("site");
+    site.addKnob("rate", 50).addLiveKnob("depth", 8);
+    site.constrain("rate", {1, 64});
+    site.getGroup("cache").addKnob("ways", 8);
+
+    LayeredGroup config("config");
+    config.push(defaults).push(site);
+
+    // derived knob found by leaf name is computed over the layers
+    auto [ok, path, k] = config.findKnob("sets");
+    assert(ok and path == "config:cache:sets" and k->asInt() == 16);
+    std::tie(ok, path, k) = config.findKnob("nope");
+    assert(not ok and path.empty() and k == nullptr);
+
+    Group flat = config.flatten();
+    assert(flat.range("rate") != nullptr and flat.range("rate")->max == 64);
+    assert(flat.range("depth") != nullptr and flat.range("depth")->max == 16);
+    assert(flat.range("cache:ways") == nullptr);
+    assert(flat.live<int>("depth").get() == 8);
+    [[maybe_unused]] bool thrown = false;
+    try { flat.live<int>("rate"); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+    flat.setLive("depth", 12);
+    assert(flat.live<int>("depth").get() == 12 and flat.at("depth").asInt() == 12);
+
+    // value of the upper layer outside of the range of a lower one
+    Group argv("argv");
+    argv.addKnob("depth", 32);
+    config.push(argv);
+    thrown = false;
+    try { config.flatten(); } catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Layered_resolve(); !ok) return 1;
+    if (auto ok=test_Layered_flatten(); !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <cassert>
+
+#include "../parallel_visit.h"
+
+using namespace knb;
+
+bool test_ParallelVisit()
+{
+    Group knobs("root");
+    long long expect = 0;
+    for (int g = 0; g < 50; ++g) {
+        Group& grp = knobs.getGroup("g" + std::to_string(g));
+        for (int k = 0; k < 100; ++k) {
+            grp.getGroup("sub").addKnob("k" + std::to_string(k), g * 100 + k);
+            expect += g * 100 + k;
+        }
+    }
+    knobs.addKnob("top", 1); expect += 1;
+
+    std::atomic<long long> sum{0};
+    assert(parallelVisit(knobs, [&](const Knob& k){ sum += k.asInt(); }, 4));
+    assert(sum == expect);
+
+    std::atomic<int> owners{0};
+    parallelVisit(knobs, [&](const Knob&, const Group& g){ if (g.name() == "sub") ++owners; }, 3);
+    assert(owners == 5000);
+
+    std::atomic<int> seen{0};
+    assert(not parallelVisit(knobs, [&](const Knob&){ return ++seen < 10; }, 4));
+    assert(seen < 5001);
+
+    [[maybe_unused]] bool thrown = false;
+    try { parallelVisit(knobs, [](const Knob& k){ if (k.asInt() == 4242) throw std::runtime_error("x"); }); }
+    catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    Group empty("empty");
+    assert(parallelVisit(empty, [](const Knob&){ assert(false); }));
+
+    return true;
+}
+
+bool test_ParallelVisit_derived()
+{
+    Group knobs("root", false);
+    for (int g = 0; g < 8; ++g) {
+        knobs.getGroup("g" + std::to_string(g)).addKnob("size", 64 * (g + 1))
+             .addDerived<int>("half", "size / 2");
+    }
+    std::atomic<long long> sum{0};
+    assert(parallelVisit(knobs, [&](const Knob& k){ if (k.name() == "half") sum += k.asInt(); }, 4));
+    assert(sum == 32 * 36);
+
+    knobs.changeValue(&knobs.atPath("g0:size"), "128");
+    sum = 0;
+    parallelVisit(knobs, [&](const Knob& k){ if (k.name() == "half") sum += k.asInt(); }, 4);
+    assert(sum == 32 * 36 + 32);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_ParallelVisit(); !ok) return 1;
+    if (auto ok=test_ParallelVisit_derived(); !ok) return 1;
+
+    return 0;
+}
@@ -1,9 +1,66 @@
 #include <cassert>
+#include <cstdio>
+#include <fstream>
 
 #include "../program_options.h"
 
+static void test_OptionParser()
+{
+    knb::Group knobs("test", false);
+    knobs.addKnob("max", 100)
+         .addKnob("verbose", false)
+         .addKnob("policy", "lru");
+    knobs.getGroup("feature-A").addKnob("A-val1", 345).addKnob("ratio", 0.5f);
+    knobs.getGroup("feature-B").addKnob("A-val1", 1);
+
+    {
+        std::ofstream rsp("test_program_options.rsp");
+        rsp << "--max=300\n--policy \"least recently used\"\n  --verbose=1 @test_program_options.rsp2\n";
+        std::ofstream rsp2("test_program_options.rsp2");
+        rsp2 << "--feature-B:A-val1 7\n";
+    }
+
+    const char* args[] = {"prog", "--ratio=0.25", "--feature-A:A-val1", "5",
+        "@test_program_options.rsp", "--max=12x", "--nope", "file.txt", "--A-val1=9", "--ratio",
+        "--", "--max", "@missing.rsp", "--A-val1"};
+    knb::OptionParser parser;
+    [[maybe_unused]] bool ok = parser.parse(sizeof(args)/sizeof(args[0]), const_cast<char**>(args), knobs);
+    std::remove("test_program_options.rsp");
+    std::remove("test_program_options.rsp2");
+
+    assert(knobs.atPath("feature-A:ratio").asFloat() == 0.25f);
+    assert(knobs.atPath("feature-A:A-val1").asInt() == 5);
+    assert(knobs.atPath("feature-B:A-val1").asInt() == 7);
+    assert(knobs.at("max").asInt() == 300);
+    assert(knobs.at("policy").asString() == "least recently used");
+    assert(knobs.at("verbose").asBool() == true);
+
+    // "--max=12x" bad value, "--A-val1=9" is in feature-A and feature-B, "--ratio" has no value
+    assert(not ok);
+    assert(parser.errors().size() == 3 and parser.errors()[1] == "--A-val1=9: ambiguous name, use the knob path");
+    assert(parser.unknown().size() == 1 and parser.unknown()[0] == "--nope");
+    const std::vector<knb::strv> rest{"prog", "--max=12x", "--nope", "file.txt", "--A-val1=9", "--ratio",
+        "--max", "@missing.rsp", "--A-val1"};
+    assert(parser.nonConsumed() == rest);
+
+    knb::OptionParser missing;
+    [[maybe_unused]] const char* args2[] = {"@missing.rsp", "--max"};
+    assert(not missing.parse(2, const_cast<char**>(args2), knobs));
+    assert(missing.errors().size() == 2);
+
+    // finalized tree: options are reported, not silently dropped
+    knobs.finalize();
+    knb::OptionParser late;
+    [[maybe_unused]] const char* args3[] = {"--max=7", "--verbose"};
+    assert(not late.parse(2, const_cast<char**>(args3), knobs));
+    assert(late.errors().size() == 2 and late.nonConsumed().size() == 2);
+    assert(knobs.at("max").asInt() == 300);
+}
+
 int main(int argc, char* argv[])
 {
+    test_OptionParser();
+
     knb::Group knobs("test", false);
     knobs.addKnob("version", "1.2.3", "Program version")
          .addKnob("max",         100, "max value of ...")
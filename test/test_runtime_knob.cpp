@@ -58,6 +58,29 @@ bool test_Knob_compare()
     return true;
 }
 
+bool test_Knob_wide()
+{
+    const Knob addr{"addr", std::uint64_t(0xffff'ffff'ffff'fff0ull)};
+    const Knob seed{"seed", std::int64_t(-1) << 40};
+    const Knob ratio{"ratio", 0.1};
+    assert(addr.type() == Knob::T::UInt64 and addr.asUInt64() == 0xffff'ffff'ffff'fff0ull);
+    assert(seed.type() == Knob::T::Int64 and seed.asInt64() == -(std::int64_t(1) << 40));
+    assert(ratio.type() == Knob::T::Double and ratio.asDouble() == 0.1);
+    assert(addr.asString() == "18446744073709551600");
+    assert(ratio.asString() == "0.1");
+
+    // old type ids do not change
+    static_assert(static_cast<int>(Knob::T::String) == 3 and static_cast<int>(Knob::T::Int64) == 4);
+    static_assert(Knob::typeOf<double>() == Knob::T::Double);
+    assert(*ratio.bind<double>() == 0.1);
+
+    auto [st, k] = seed.withValue("8Gi");
+    assert(st and k.asInt64() == (std::int64_t(8) << 30) and k.name() == "seed");
+    std::tie(st, k) = addr.withValue("-1");
+    assert(not st and k.asUInt64() == addr.asUInt64());
+
+    return true;
+}
 
 int main(int argc, char* argv[])
 {
@@ -67,6 +90,7 @@ int main(int argc, char* argv[])
     if (auto ok=test_Knob_construct();   !ok) return 1;
     if (auto ok=test_Knob_Bool();   !ok) return 1;
     if (auto ok=test_Knob_compare();   !ok) return 1;
+    if (auto ok=test_Knob_wide();   !ok) return 1;
 
     knb::Knob k1{"k1",true};
     knb::Knob k2{"k2",777};
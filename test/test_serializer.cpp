@@ -0,0 +1,146 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+
+#include "../serializer.h"
+#include "../program_options.h"
+#include "../config_file.h"
+
+using namespace knb;
+
+static Group makeKnobs()
+{
+    Group knobs("sim");
+    knobs.addKnob("max", 100, "Max value").addKnob("ratio", 0.25f, "Hit ratio")
+         .addKnob("trace", false, "Write trace").addKnob("name", "a \"b\"\tc", "Run name");
+    knobs.getGroup("cache").addKnob("ways", 8).addKnob("policy", "lru");
+    knobs.getGroup("cache").getGroup("l2").addKnob("ways", 16);
+    knobs.getGroup("empty");
+    return knobs;
+}
+
+bool test_Serializer_formats()
+{
+    const Group knobs = makeKnobs();
+    std::string out;
+
+    serialize(knobs, Format::KeyValue, out);
+    assert(out ==
+        "max = 100\n"
+        "name = \"a \\\"b\\\"\\tc\"\n"
+        "ratio = 0.25\n"
+        "trace = false\n"
+        "cache:policy = \"lru\"\n"
+        "cache:ways = 8\n"
+        "cache:l2:ways = 16\n");
+
+    out.clear();
+    serialize(knobs, Format::Json, out);
+    assert(out ==
+        "{\n"
+        "  \"max\": 100,\n"
+        "  \"name\": \"a \\\"b\\\"\\tc\",\n"
+        "  \"ratio\": 0.25,\n"
+        "  \"trace\": false,\n"
+        "  \"cache\": {\n"
+        "    \"policy\": \"lru\",\n"
+        "    \"ways\": 8,\n"
+        "    \"l2\": {\n"
+        "      \"ways\": 16\n"
+        "    }\n"
+        "  },\n"
+        "  \"empty\": {\n"
+        "  }\n"
+        "}\n");
+
+    out.clear();
+    serialize(knobs.gr("cache"), Format::Help, out, 4);
+    assert(out ==
+        "--policy [\"lru\"]\n"
+        "  \n"
+        "--ways [8]\n"
+        "  \n"
+        "--ways [16]\n"
+        "  \n");
+
+    // printOptions is the Help format
+    std::ostringstream help;
+    printOptions(knobs, help, 4);
+    out.clear();
+    serialize(knobs, Format::Help, out, 4);
+    assert(help.str() == out);
+    assert(out.find("--max [100]\n  Max \n  valu\n  e\n") != std::string::npos);
+    assert(out.find("--no-trace\n") != std::string::npos);
+    assert(out.find("--ratio [0.25]\n") != std::string::npos);
+
+    return true;
+}
+
+bool test_Serializer_reuse()
+{
+    Group knobs("sim");
+    for (int i = 0; i < 100; ++i) knobs.addKnob("knob-" + std::to_string(i), i * 1000);
+
+    Serializer s;
+    const std::string first(s.render(knobs, Format::KeyValue));
+    [[maybe_unused]] const std::size_t capacity = s.capacity();
+    assert(capacity >= first.size());
+    assert(s.render(knobs, Format::KeyValue) == first);
+    assert(s.capacity() == capacity); // no regrowth
+
+    std::ostringstream o;
+    s.dump(knobs, Format::Json, o);
+    assert(o.str() == s.render(knobs, Format::Json));
+
+    return true;
+}
+
+bool test_Serializer_roundtrip()
+{
+    // into a tree that declares the same knobs, which gives their types
+    auto make = [](int max, float ratio, bool trace, const char* policy, double scale,
+                   std::uint64_t mem, std::vector<std::int64_t> lat) {
+        Group knobs("sim", false);
+        knobs.addKnob("max", max).addKnob("ratio", ratio).addKnob("trace", trace);
+        knobs.addKnob("scale", scale).addKnob("mem", mem).addKnob("latency", lat);
+        knobs.getGroup("cache").addKnob("policy", policy);
+        knobs.getGroup("cache").getGroup("l2").addKnob("ways", max / 2);
+        return knobs;
+    };
+    const Group knobs = make(100, 1.0f, true, "say \"hi\" # not a comment;\n\tC:\\tmp\\", 2.0,
+                             std::uint64_t(1) << 63, {4, 12, 40});
+    Group other = make(1, 3.5f, false, "fifo", 0.5, 0, {});
+
+    // KeyValue output is configuration file text
+    std::string text;
+    serialize(knobs, Format::KeyValue, text);
+    auto [ok, errors] = loadConfig(text, other);
+    assert(ok and errors.empty());
+
+    std::string again;
+    serialize(other, Format::KeyValue, again);
+    assert(again == text);
+    assert(other.at("ratio").asFloat() == 1.0f and other.at("scale").asDouble() == 2.0);
+    assert(other.at("mem").asUInt64() == std::uint64_t(1) << 63);
+    assert(other.at("latency").asInt64Array()[2] == 40);
+    assert(other.gr("cache").at("policy").asString() == "say \"hi\" # not a comment;\n\tC:\\tmp\\");
+    assert(text.find("\"say \\\"hi\\\" # not a comment;\\n\\tC:\\\\tmp\\\\\"\n") != std::string::npos);
+
+    // shortest form of float is exact
+    Group ratio("sim", false);
+    ratio.addKnob("ratio", 0.1f);
+    text.clear();
+    serialize(ratio, Format::KeyValue, text);
+    assert(std::get<0>(loadConfig(text, other)) and other.at("ratio").asFloat() == 0.1f);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Serializer_formats(); !ok) return 1;
+    if (auto ok=test_Serializer_reuse(); !ok) return 1;
+    if (auto ok=test_Serializer_roundtrip(); !ok) return 1;
+
+    return 0;
+}
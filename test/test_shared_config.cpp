@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <thread>
+
+#include <sys/wait.h>
+
+#include "../shared_config.h"
+
+using namespace knb;
+
+static void build(Group& g, int ways)
+{
+    g.addKnob("ways", ways).addKnob("policy", "lru").addKnob("ratio", 0.5);
+    g.getGroup("cache").addKnob("size", 32768).addKnob("neg-size", -32768).addKnob("on", true);
+}
+
+static const std::string segment = "/knobcpp_test_" + std::to_string(::getpid());
+
+bool test_SharedConfig_open()
+{
+    Group g("sim", false);
+    build(g, 8);
+    SharedConfigWriter writer(segment, g);
+    assert(writer.version() == 0);
+
+    SharedConfig config(segment);
+    assert(config.version() == 0);
+    assert(config.root().name() == "sim");
+    assert(config.root().at("ways").asInt() == 8);
+    assert(config.root().at("policy").asStringView() == "lru");
+    assert(config.root().gr("cache").at("size").asInt() == 32768);
+    assert(std::get<0>(config.root().findKnob("neg-size")));
+
+    // another process maps the same pages
+    const pid_t child = ::fork();
+    if (child == 0) {
+        SharedConfig worker(segment);
+        ::_exit(worker.root().at("ways").asInt() == 8 and worker.root().at("ratio").asDouble() == 0.5? 0 : 1);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    assert(WIFEXITED(status) and WEXITSTATUS(status) == 0);
+
+    [[maybe_unused]] bool threw = false;
+    try { SharedConfig none("/knobcpp_no_such_segment"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+
+    assert(SharedConfigWriter::unlink(segment));
+    assert(config.root().at("ways").asInt() == 8); // mapping outlives the name
+    assert(not SharedConfigWriter::unlink(segment));
+
+    return true;
+}
+
+bool test_SharedConfig_publish()
+{
+    Group g("sim", false);
+    build(g, 8);
+    SharedConfigWriter writer(segment, g);
+    SharedConfig config(segment);
+
+    g.changeValue(&g.at("ways"), "16");
+    g.changeValue(&g.atPath("cache:on"), "false");
+    assert(writer.publish(g) == 2);
+    assert(config.version() == 1 and writer.version() == 1);
+    assert(config.root().at("ways").asInt() == 16 and not config.root().gr("cache").at("on").asBool());
+    assert(writer.publish(g) == 0 and config.version() == 1);
+
+    // structure, strings and arrays need a new segment
+    Group other("sim", false);
+    build(other, 8);
+    other.addKnob("extra", 1);
+    [[maybe_unused]] bool threw = false;
+    try { writer.publish(other); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    g.changeValue(&g.at("policy"), "fifo");
+    threw = false;
+    try { writer.publish(g); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    assert(config.version() == 1 and config.root().at("policy").asStringView() == "lru");
+
+    SharedConfigWriter::unlink(segment);
+    return true;
+}
+
+bool test_SharedConfig_replace()
+{
+    Group g("sim", false);
+    build(g, 8);
+    auto writer = std::make_unique<SharedConfigWriter>(segment, g);
+    SharedConfig old(segment);
+
+    // new structure goes to a new segment, old mapping keeps its image
+    Group other("sim", false);
+    build(other, 4);
+    other.addKnob("extra", 1);
+    writer = std::make_unique<SharedConfigWriter>(segment, other);
+    assert(old.root().at("ways").asInt() == 8);
+    assert(not std::get<0>(old.root().findKnob("extra")));
+    SharedConfig config(segment);
+    assert(config.root().at("ways").asInt() == 4 and config.root().at("extra").asInt() == 1);
+
+    SharedConfigWriter::unlink(segment);
+    return true;
+}
+
+bool test_SharedConfig_seqlock()
+{
+    Group g("sim", false);
+    build(g, 8);
+    SharedConfigWriter writer(segment, g);
+    SharedConfig config(segment);
+
+    // size and neg-size always change together
+    std::atomic<bool> done{false};
+    std::thread controller([&]{
+        for (int i = 1; i <= 2000; ++i) {
+            g.changeValue(&g.atPath("cache:size"), std::to_string(i));
+            g.changeValue(&g.atPath("cache:neg-size"), std::to_string(-i));
+            writer.publish(g);
+        }
+        done = true;
+    });
+    std::size_t reads = 0;
+    while (not done or reads == 0) {
+        [[maybe_unused]] const auto [size, neg] = config.read([](SnapshotGroupView root) {
+            const SnapshotGroupView cache = root.gr("cache");
+            return std::make_pair(cache.at("size").asInt(), cache.at("neg-size").asInt());
+        });
+        assert(size == -neg);
+        ++reads;
+    }
+    controller.join();
+    assert(config.version() == 2000);
+    assert(config.root().gr("cache").at("size").asInt() == 2000);
+
+    SharedConfigWriter::unlink(segment);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_SharedConfig_open(); !ok) return 1;
+    if (auto ok=test_SharedConfig_publish(); !ok) return 1;
+    if (auto ok=test_SharedConfig_replace(); !ok) return 1;
+    if (auto ok=test_SharedConfig_seqlock(); !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+
+#include "../snapshot.h"
+
+using namespace knb;
+
+bool test_Snapshot_query()
+{
+    Group knobs("root");
+    knobs.addKnob("version","1.2.3", "Program version")
+         .addKnob("max", 100)
+         .addKnob("feature-A", true)
+    ;
+    knobs.getGroup("feature-A")
+        .addKnob("A-val1", 345, "Feature A value")
+        .getGroup("A-X")
+            .addKnob("A-X-val2", 987)
+            .addKnob("ratio", 0.25f)
+    ;
+    knobs.getGroup("feature-B")
+        .addKnob("A-val1", 1)
+        .addKnob("policy", "lru")
+    ;
+    knobs.getGroup("feature-C");
+    knobs.finalize();
+
+    const std::string image = makeSnapshot(knobs);
+    SnapshotView view(image.data(), image.size());
+    SnapshotGroupView root = view.root();
+
+    assert(root.name() == "root");
+    assert(root.at("version").asString() == "1.2.3");
+    assert(root.at("version").desc() == "Program version");
+    assert(root.at("max").asInt() == 100);
+    assert(root.at("feature-A").asBool() == true);
+    assert(root.gr("feature-A").at("A-val1").asInt() == 345);
+    assert(root.gr("feature-A").gr("A-X").at("ratio").asFloat() == 0.25f);
+    assert(root.gr("feature-B").at("policy").asStringView() == "lru");
+
+    try { root.at("nope"); assert(false); } catch (const std::out_of_range&) {}
+    try { root.gr("nope"); assert(false); } catch (const std::out_of_range&) {}
+    try { root.at("max").asFloat(); assert(false); } catch (const std::bad_variant_access&) {}
+
+    // same answers as Group::findKnob, including repeated names
+    for (const char* nm : {"A-X-val2", "A-val1", "policy", "max", "nope"}) {
+        auto [ok, path, k] = knobs.findKnob(nm);
+        auto [sok, spath, sk] = root.findKnob(nm);
+        assert(ok == sok and path == spath);
+        if (ok) assert(k->asString() == sk.asString());
+    }
+    auto [ok, path, k] = root.gr("feature-B").findKnob("A-val1");
+    assert(ok and path == "feature-B:A-val1" and k.asInt() == 1);
+    assert(not std::get<0>(root.gr("feature-C").findKnob("A-val1")));
+
+    std::vector<std::string> names, snames;
+    knobs.visit([&](const Knob& kb){ names.emplace_back(kb.name()); });
+    root.visit([&](SnapshotKnobView kb){ snames.emplace_back(kb.name()); });
+    assert(names == snames);
+
+    // corrupted image is rejected
+    std::string bad = image; bad[0] = 'X';
+    try { SnapshotView(bad.data(), bad.size()); assert(false); } catch (const std::runtime_error&) {}
+    try { SnapshotView(image.data(), image.size() - 1); assert(false); } catch (const std::runtime_error&) {}
+
+    // records that point outside of the image or loop are rejected
+    using namespace knb::detail;
+    const auto& h = *reinterpret_cast<const SnapshotHeader*>(image.data());
+    [[maybe_unused]] auto corrupt = [&](auto change) {
+        std::string img = image;
+        change(img.data());
+        try { SnapshotView(img.data(), img.size(), true); } catch (const std::runtime_error&) { return true; }
+        return false;
+    };
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotKnob*>(p + h.knobsOff)[1].name.off = h.size; }));
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotKnob*>(p + h.knobsOff)[0].sameName = 0; }));
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotKnob*>(p + h.knobsOff)[2].type = 42; }));
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotGroup*>(p + h.groupsOff)[1].parent = 1; }));
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotGroup*>(p + h.groupsOff)[0].numKnobs = h.numKnobs + 1; }));
+    assert(corrupt([&](char* p) {
+        auto* slots = reinterpret_cast<std::uint32_t*>(p + h.slotsOff);
+        for (std::uint32_t i = 0; i < h.numSlots; ++i) slots[i] = 0;
+    }));
+    assert(not corrupt([](char*) {}));
+    assert(corrupt([&](char* p) { reinterpret_cast<SnapshotHeader*>(p)->version = snapshotVersion - 1; }));
+    std::string trusted = image;
+    reinterpret_cast<SnapshotKnob*>(trusted.data() + h.knobsOff)[2].type = 42;
+    assert(SnapshotView(trusted.data(), trusted.size()).root().at("max").asInt() == 100);
+
+    // validation walks deep trees without recursion, the writer bounds the depth
+    Group deep("deep");
+    Group* g = &deep;
+    for (std::uint32_t d = 0; d < snapshotMaxDepth; ++d) g = &g->getGroup("g");
+    g->addKnob("leaf", 1);
+    const std::string deepImage = makeSnapshot(deep);
+    assert(std::get<2>(SnapshotView(deepImage.data(), deepImage.size(), true).root().findKnob("leaf")).asInt() == 1);
+    g->getGroup("g").addKnob("leaf", 2);
+    [[maybe_unused]] bool thrown = false;
+    try { makeSnapshot(deep); } catch (const std::length_error&) { thrown = true; }
+    assert(thrown);
+
+    return true;
+}
+
+bool test_Snapshot_file()
+{
+    Group knobs("root");
+    for (int g = 0; g < 50; ++g) {
+        Group& gr = knobs.getGroup("g" + std::to_string(g));
+        for (int k = 0; k < 50; ++k) {
+            gr.addKnob("k" + std::to_string(g * 50 + k), g * 50 + k);
+        }
+    }
+    const std::string file = "test_snapshot.knb";
+    if (not saveSnapshot(knobs, file)) return false;
+    {
+        MappedSnapshot snap(file, true);
+        for (int i = 0; i < 2500; ++i) {
+            auto [ok, path, k] = snap.root().findKnob("k" + std::to_string(i));
+            assert(ok and k.asInt() == i);
+            assert(path == "root:g" + std::to_string(i / 50) + ":k" + std::to_string(i));
+        }
+        assert(snap.root().gr("g7").at("k360").asInt() == 360);
+    }
+    std::remove(file.c_str());
+
+    try { MappedSnapshot snap("no-such-file.knb"); assert(false); }
+    catch (const std::runtime_error&) {}
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Snapshot_query(); !ok) return 1;
+    if (auto ok=test_Snapshot_file();  !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+
+#include "../span.h"
+#include "../knob.h"
+#include "../frozen_group.h"
+#include "../snapshot.h"
+#include "../config_file.h"
+#include "../config_struct.h"
+#include "../program_options.h"
+#include "../serializer.h"
+#include "../dispatch.h"
+#include "../sweep.h"
+
+using namespace knb;
+
+bool test_Span_Buffer()
+{
+    const std::vector<double> v{1.5, 2.5, 3.5};
+    Buffer<double> b(v);
+    assert(b.size() == 3 and b[1] == 2.5);
+    assert(reinterpret_cast<std::uintptr_t>(b.data()) % Buffer<double>::alignment == 0);
+    assert(b.data()[7] == 0.0); // padded to 64 bytes
+
+    Buffer<double> copy = b;
+    assert(copy.data() == b.data()); // shared
+    assert(copy == b and not (copy < b));
+    assert(Buffer<double>({1.0, 2.0}) < Buffer<double>({1.0, 3.0}));
+    assert(Buffer<double>().empty() and Buffer<double>().span().empty());
+
+    Span<const double> s = b.span();
+    double sum = 0;
+    for (double x : s) sum += x;
+    assert(sum == 7.5 and s.back() == 3.5 and s.subspan(1, 5).size() == 2);
+
+    std::vector<int> ints{1, 2};
+    Span<int> si(ints);
+    si[0] = 5;
+    assert(ints[0] == 5);
+
+    return true;
+}
+
+bool test_Span_knobs()
+{
+    Group knobs("sim", false);
+    knobs.addKnob("latency", std::vector<std::int64_t>{4, 12, 40}, "Latency per level")
+         .addKnob("weights", std::vector<double>{0.5, 0.25, 0.25})
+         .addKnob("mem-size", std::uint64_t(16) << 30)
+         .addKnob("seed", std::int64_t(-5))
+         .addKnob("scale", 1e-300);
+    [[maybe_unused]] const Knob& lat = knobs.at("latency");
+    assert(lat.type() == Knob::T::Int64Array and lat.asInt64Array().size() == 3);
+    assert(lat.asInt64Array()[2] == 40 and lat.asString() == "4,12,40");
+    assert(knobs.at("weights").asDoubleArray()[1] == 0.25);
+    assert(knobs.at("scale").asDouble() == 1e-300);
+
+    assert(knobs.changeValue(&lat, "1, 2, 3, 4KiB"));
+    assert(lat.asInt64Array().size() == 4 and lat.asInt64Array()[3] == 4096);
+    assert(knobs.changeValue(&lat, "") and lat.asInt64Array().empty());
+    knobs.constrain("weights", {0, 1});
+    assert(not knobs.changeValue(&knobs.at("weights"), "0.5, 2"));
+    assert(knobs.at("weights").asString() == "0.5,0.25,0.25");
+    assert(knobs.changeValue(&knobs.at("mem-size"), "32GiB"));
+    assert(knobs.at("mem-size").asUInt64() == std::uint64_t(32) << 30);
+    assert(not knobs.changeValue(&knobs.at("mem-size"), "-1"));
+    assert(knobs.changeValue(&lat, "4,12,40"));
+
+    // options, config text, dumps
+    OptionParser parser;
+    assert(parser.parse({"--seed=9000000000", "--weights", "0.1,0.9"}, knobs));
+    assert(knobs.at("seed").asInt64() == 9000000000 and knobs.at("weights").asDoubleArray()[1] == 0.9);
+
+    std::string text;
+    serialize(knobs, Format::KeyValue, text);
+    assert(text.find("latency = 4,12,40\n") != std::string::npos);
+    Group other("sim", false);
+    other.addKnob("latency", std::vector<std::int64_t>{}).addKnob("weights", std::vector<double>{})
+         .addKnob("mem-size", std::uint64_t(0)).addKnob("seed", std::int64_t(0)).addKnob("scale", 0.0);
+    auto [ok, errors] = loadConfig(text, other);
+    assert(ok);
+    std::string again;
+    serialize(other, Format::KeyValue, again);
+    assert(again == text);
+
+    std::string json;
+    serialize(knobs, Format::Json, json);
+    assert(json.find("\"latency\": [4, 12, 40]") != std::string::npos);
+    assert(json.find("\"mem-size\": 34359738368") != std::string::npos);
+
+    // compiled and mapped forms keep the types
+    FrozenGroup frozen(knobs);
+    assert(frozen.asInt64Array(frozen.at("latency"))[1] == 12);
+    assert(frozen.asUInt64(frozen.at("mem-size")) == std::uint64_t(32) << 30);
+    assert(*frozen.bind<double>("scale") == 1e-300);
+    assert(frozen.knob(frozen.at("weights")) == knobs.at("weights"));
+
+    const std::string image = makeSnapshot(knobs);
+    SnapshotView snap(image.data(), image.size());
+    [[maybe_unused]] auto lv = snap.root().at("latency").asInt64Array();
+    assert(lv.size() == 3 and lv[2] == 40);
+    assert((lv.data() - reinterpret_cast<const std::int64_t*>(image.data())) % 8 == 0);
+    assert(snap.root().at("seed").asInt64() == 9000000000);
+    assert(snap.root().at("weights").knob() == knobs.at("weights"));
+
+    return true;
+}
+
+struct Cache {
+    std::uint64_t size;
+    std::vector<std::int64_t> latency;
+    double scale;
+};
+
+bool test_Span_integration()
+{
+    Group knobs("sim", false);
+    StructBinding<Cache> binding;
+    binding.field("size", &Cache::size).field("latency", &Cache::latency).field("scale", &Cache::scale);
+    binding.addKnobs(knobs, Cache{1024, {1, 2}, 0.5});
+    assert(knobs.at("latency").type() == Knob::T::Int64Array);
+    knobs.changeValue(&knobs.at("latency"), "3,4,5");
+    const Cache c = binding.load(knobs);
+    assert(c.size == 1024 and c.latency == std::vector<std::int64_t>({3, 4, 5}) and c.scale == 0.5);
+
+    knobs.addLiveKnob("budget", std::int64_t(1) << 40);
+    [[maybe_unused]] LiveKnob<std::int64_t> budget = knobs.live<std::int64_t>("budget");
+    knobs.setLive("budget", std::int64_t(7));
+    assert(*budget == 7);
+
+    int hit = 0;
+    dispatch<1024, 2048>(knobs.at("size"), [&](auto size){ hit = size; });
+    assert(hit == 1024);
+
+    Sweep sweep(knobs);
+    sweep.range<std::uint64_t>("size", 1024, 4096, 1024).range("scale", 0.25, 1.0, 0.25);
+    assert(sweep.size() == 16);
+    SweepPoint p(sweep);
+    sweep.point(15, p);
+    assert(p.at("size").asUInt64() == 4096 and p.at("scale").asDouble() == 1.0);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Span_Buffer(); !ok) return 1;
+    if (auto ok=test_Span_knobs(); !ok) return 1;
+    if (auto ok=test_Span_integration(); !ok) return 1;
+
+    return 0;
+}
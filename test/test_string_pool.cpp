@@ -0,0 +1,77 @@
+#include <iostream>
+#include <cassert>
+
+#include "../knob.h"
+
+using namespace knb;
+
+bool test_StringPool_intern()
+{
+    StringPool pool;
+    std::string a("some knob description");
+    std::string b("some knob description");
+    [[maybe_unused]] strv ia = pool.intern(a), ib = pool.intern(b);
+    assert(ia == a and ia.data() == ib.data());
+    assert(ia.data() != a.data());
+    assert(pool.size() == 1);
+    assert(pool.owns(ia) and not pool.owns(a));
+    assert(pool.intern("").empty());
+
+    std::string big(64 * 1024, 'x');
+    assert(pool.intern(big) == big);
+    for (int i = 0; i < 10000; ++i) pool.intern("name-" + std::to_string(i));
+    assert(pool.size() == 10002);
+    assert(ia == "some knob description");
+
+    return true;
+}
+
+bool test_StringPool_tree()
+{
+    Group knobs("root");
+    knobs.addKnob("x", 1, "shared description")
+         .addKnob("y", 2, "shared description");
+    knobs.getGroup("sub").addKnob("x", 3, "shared description");
+
+    [[maybe_unused]] const Knob& x = knobs.at("x");
+    [[maybe_unused]] const Knob& y = knobs.at("y");
+    [[maybe_unused]] const Knob& subx = knobs.gr("sub").at("x");
+    assert(x.pool() == knobs.pool() and subx.pool() == knobs.pool());
+    assert(x.desc().data() == y.desc().data());
+    assert(x.sameName(subx) and not x.sameName(y));
+
+    // standalone knob owns its strings, re-interned when added to a tree
+    Knob z{"z", 4, "shared description"};
+    assert(z.pool() == nullptr and z.name() == "z" and z.desc() == "shared description");
+    knobs.addKnob(z);
+    assert(knobs.at("z").desc().data() == x.desc().data() and knobs.at("z").pool() == knobs.pool());
+    Knob w = z.withValue("5").second;
+    assert(w.name() == "z" and w.desc() == "shared description" and w.name().data() != z.name().data());
+    assert(w.sameName(z) and not w.sameName(Knob("y", 1)));
+    std::vector<Knob> moved;
+    for (int i = 0; i < 100; ++i) moved.emplace_back("m" + std::to_string(i), i, "d"); // reallocates
+    assert(moved[42].name() == "m42" and moved[42].desc() == "d");
+    Knob taken = std::move(w);
+    assert(taken.name() == "z" and w.name().empty());
+    assert(Knob().pool() == nullptr and Knob().name().empty());
+
+    // knob copied out of the tree keeps strings alive
+    Knob copy;
+    {
+        Group tmp("tmp");
+        tmp.addKnob("long-knob-name-that-is-not-small", 5, "tmp knob");
+        copy = tmp.at("long-knob-name-that-is-not-small");
+    }
+    assert(copy.name() == "long-knob-name-that-is-not-small");
+    assert(copy.desc() == "tmp knob");
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_StringPool_intern(); !ok) return 1;
+    if (auto ok=test_StringPool_tree();   !ok) return 1;
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <cassert>
+#include <set>
+
+#include "../sweep.h"
+
+using namespace knb;
+
+static Group makeBase()
+{
+    Group knobs("root");
+    knobs.addKnob("max", 100).addKnob("policy", "lru", "Replacement policy");
+    knobs.getGroup("cache").addKnob("ways", 4).addKnob("ratio", 0.5f).addKnob("prefetch", false);
+    knobs.finalize();
+    return knobs;
+}
+
+bool test_Sweep_grid()
+{
+    const Group base = makeBase();
+    Sweep sweep(base);
+    sweep.range("cache:ways", 1, 16, 1)
+         .values("policy", {"lru", "fifo", "random"})
+         .values("cache:prefetch", std::vector<bool>{false, true})
+         .range("cache:ratio", 0.25f, 1.0f, 0.25f);
+    assert(sweep.size() == 16 * 3 * 2 * 4);
+
+    // every configuration exactly once
+    std::set<std::tuple<int,std::string,bool,float>> seen;
+    SweepPoint p(sweep);
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        sweep.point(i, p);
+        seen.emplace(p.at("cache:ways").asInt(), p.at("policy").asString(),
+                     p[2].asBool(), p.at("cache:ratio").asFloat());
+        assert(p.at("max").asInt() == 100);
+        assert(&p.at("max") == &base.at("max"));
+        assert(p.at("policy").desc() == "Replacement policy");
+    }
+    assert(seen.size() == sweep.size());
+    assert(std::get<0>(*seen.begin()) == 1 and std::get<0>(*seen.rbegin()) == 16);
+
+    sweep.point(sweep.size() - 1, p);
+    Group g = p.group();
+    assert(g.atPath("cache:ways").asInt() == 16 and g.at("policy").asString() == "random");
+    assert(base.atPath("cache:ways").asInt() == 4);
+
+    [[maybe_unused]] bool thrown = false;
+    try { sweep.values("max", std::vector<float>{1.0f}); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown and sweep.size() == 16 * 3 * 2 * 4);
+
+    return true;
+}
+
+bool test_Sweep_samples()
+{
+    const Group base = makeBase();
+    const std::size_t n = 1000;
+    Sweep sweep(base);
+    sweep.uniform("cache:ratio", 0.0, 1.0)
+         .uniform("cache:ways", 1, 64)
+         .samples(n, Sweep::Sampling::LatinHypercube, 7);
+    assert(sweep.size() == n);
+
+    // Latin hypercube: one sample per stratum in every dimension
+    std::vector<int> strata(n, 0);
+    std::mutex mutex;
+    sweep.run([&](const SweepPoint& p){
+        const float r = p.at("cache:ratio").asFloat();
+        [[maybe_unused]] const int w = p.at("cache:ways").asInt();
+        assert(r >= 0.0f and r <= 1.0f and w >= 1 and w <= 64);
+        std::lock_guard<std::mutex> lock(mutex);
+        ++strata[std::min<std::size_t>(static_cast<std::size_t>(r * n), n - 1)];
+    }, 4);
+    assert(std::all_of(std::begin(strata), std::end(strata), [](int c){return c == 1;}));
+
+    // grid x samples
+    Sweep mixed(base);
+    mixed.values("cache:prefetch", std::vector<bool>{false, true})
+         .uniform("cache:ratio", 0.0, 1.0).samples(10, Sweep::Sampling::Random);
+    assert(mixed.size() == 20);
+
+    return true;
+}
+
+bool test_Sweep_run()
+{
+    const Group base = makeBase();
+    Sweep sweep(base);
+    sweep.range("max", 0, 99999, 1);
+
+    std::atomic<long long> sum{0};
+    std::atomic<std::size_t> count{0};
+    sweep.run([&](const SweepPoint& p){
+        sum += p.at("max").asInt();
+        ++count;
+    }, 4);
+    assert(count == 100000);
+    assert(sum == 99999LL * 100000 / 2);
+
+    [[maybe_unused]] bool thrown = false;
+    try {
+        sweep.run([&](const SweepPoint& p){
+            if (p.index() == 500) throw std::runtime_error("simulation failed");
+        }, 3);
+    } catch (const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (auto ok=test_Sweep_grid();    !ok) return 1;
+    if (auto ok=test_Sweep_samples(); !ok) return 1;
+    if (auto ok=test_Sweep_run();     !ok) return 1;
+
+    return 0;
+}